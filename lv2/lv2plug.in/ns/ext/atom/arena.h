@@ -0,0 +1,222 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file arena.h A growable forge sink for building large atoms.
+
+   When forging to a fixed buffer, the size of the result must be known in
+   advance.  This is fine in run(), where output goes to a port buffer, but
+   awkward for large atoms built elsewhere, like state snapshots or messages
+   with many parameters.  An arena is a forge sink which grows its buffer as
+   necessary, so atoms of any size can be built without guessing.
+
+   The buffer grows geometrically, and is kept when the arena is reused, so
+   repeatedly building similar atoms quickly reaches a steady state where no
+   allocation is done at all.  References are offsets, so they remain valid
+   when the buffer is moved.
+
+   For example:
+   @code
+   LV2_Atom_Arena arena;
+   lv2_atom_arena_init(&arena, 4096);
+
+   lv2_atom_arena_begin(&arena, &forge);
+   LV2_Atom_Forge_Frame frame;
+   lv2_atom_forge_object(&forge, &frame, 0, uris->patch_Put);
+   ...
+   lv2_atom_forge_pop(&forge, &frame);
+
+   const LV2_Atom* atom = lv2_atom_arena_get(&arena);
+   ...
+
+   lv2_atom_arena_free(&arena);
+   @endcode
+
+   Since it allocates memory, an arena is not realtime safe (except when the
+   buffer does not need to grow).
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_ARENA_H
+#define LV2_ATOM_ARENA_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup arena Arena
+   @ingroup atom
+   @{
+*/
+
+/** A growable buffer for forging atoms.  Fields are private. */
+typedef struct {
+	uint8_t* buf;       /**< Buffer, or NULL */
+	uint32_t size;      /**< Number of bytes written */
+	uint32_t capacity;  /**< Size of buffer */
+	bool     error;     /**< True if allocation failed */
+} LV2_Atom_Arena;
+
+/**
+   Initialise `arena` with an initial capacity.
+
+   @param arena The arena to initialise.
+   @param capacity Initial size of the buffer, which may be zero to defer
+   allocation until the first write.
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+lv2_atom_arena_init(LV2_Atom_Arena* arena, uint32_t capacity)
+{
+	memset(arena, 0, sizeof(LV2_Atom_Arena));
+	if (capacity) {
+		if (!(arena->buf = (uint8_t*)malloc(capacity))) {
+			return false;
+		}
+		arena->capacity = capacity;
+	}
+	return true;
+}
+
+/** Free the buffer of `arena`.  The arena may be reused after init again. */
+static inline void
+lv2_atom_arena_free(LV2_Atom_Arena* arena)
+{
+	free(arena->buf);
+	memset(arena, 0, sizeof(LV2_Atom_Arena));
+}
+
+/**
+   Grow the buffer of `arena` to at least `capacity` bytes.
+
+   The capacity at least doubles, so the total cost of growing is linear in
+   the size of the output.
+
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+lv2_atom_arena_reserve(LV2_Atom_Arena* arena, uint64_t capacity)
+{
+	if (arena->buf && capacity <= arena->capacity) {
+		return true;
+	} else if (capacity > UINT32_MAX) {
+		return false;
+	}
+
+	uint64_t new_capacity = arena->capacity ? arena->capacity : 64;
+	while (new_capacity < capacity) {
+		new_capacity *= 2;
+	}
+	if (new_capacity > UINT32_MAX) {
+		new_capacity = UINT32_MAX & ~(uint64_t)7;
+		if (new_capacity < capacity) {
+			return false;
+		}
+	}
+
+	uint8_t* const new_buf = (uint8_t*)realloc(arena->buf, new_capacity);
+	if (!new_buf) {
+		return false;
+	}
+
+	arena->buf      = new_buf;
+	arena->capacity = (uint32_t)new_capacity;
+	return true;
+}
+
+/**
+   Forge sink that appends to an arena.
+
+   References are offsets from the start of the buffer, plus one.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_arena_sink(LV2_Atom_Forge_Sink_Handle handle,
+                    const void*                data,
+                    uint32_t                   size)
+{
+	LV2_Atom_Arena* const arena = (LV2_Atom_Arena*)handle;
+	if (arena->error ||
+	    !lv2_atom_arena_reserve(arena, (uint64_t)arena->size + size)) {
+		arena->error = true;
+		return 0;
+	}
+
+	const uint32_t offset = arena->size;
+	memcpy(arena->buf + offset, data, size);
+	arena->size += size;
+	return (LV2_Atom_Forge_Ref)offset + 1;
+}
+
+/** Forge deref function for an arena, see lv2_atom_arena_sink(). */
+static inline LV2_Atom*
+lv2_atom_arena_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
+{
+	LV2_Atom_Arena* const arena = (LV2_Atom_Arena*)handle;
+	return (LV2_Atom*)(arena->buf + (ref - 1));
+}
+
+/**
+   Clear `arena` and set it as the sink for `forge`.
+
+   Anything previously written to the arena is discarded, but the buffer is
+   kept, so reusing an arena does not allocate unless the output is larger
+   than anything written before.
+*/
+static inline void
+lv2_atom_arena_begin(LV2_Atom_Arena* arena, LV2_Atom_Forge* forge)
+{
+	arena->size  = 0;
+	arena->error = false;
+	lv2_atom_forge_set_sink(
+		forge, lv2_atom_arena_sink, lv2_atom_arena_deref, arena);
+}
+
+/**
+   Return the first atom written to `arena`.
+
+   The returned pointer is only valid until the next write to the arena, since
+   the buffer may be moved when it grows.
+
+   @return The atom, or NULL if nothing was written or allocation failed.
+*/
+static inline const LV2_Atom*
+lv2_atom_arena_get(const LV2_Atom_Arena* arena)
+{
+	return (arena->error || arena->size < sizeof(LV2_Atom))
+		? NULL
+		: (const LV2_Atom*)arena->buf;
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_ATOM_ARENA_H */
@@ -0,0 +1,778 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/arena.h"
+#include "lv2/lv2plug.in/ns/ext/atom/fanout.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/template.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+#define N_ITERATIONS 1000000
+
+/** Sink for results, so the compiler can not optimise benchmarks away. */
+static volatile uintptr_t bench_sink = 0;
+
+static LV2_URID
+urid_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	/* URIDs are not significant here, but must be distinct and stable */
+	uint32_t h = 5381;
+	for (const char* c = uri; *c; ++c) {
+		h = (h << 5) + h + (uint8_t)*c;
+	}
+	return (h & 0xFFFF) + 1;
+}
+
+static double
+bench_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static void
+bench_report(const char* name, unsigned n, double begin, double end)
+{
+	printf("%-44s %10.2f ns\n", name, (end - begin) * 1.0e9 / n);
+}
+
+static void
+bench_report_rate(const char* name, double bytes, double begin, double end)
+{
+	printf("%-44s %10.2f MB/s\n", name, bytes / (end - begin) / 1.0e6);
+}
+
+/**
+   Benchmark querying 4 keys in an object with `n_props` properties.
+
+   Keys are 1000, 1001, ... in order, and the queried keys are spread across
+   the object with the last one at the end, so every method must scan the
+   entire object, except lookups in an index which has already been built.
+*/
+static void
+bench_object_query(LV2_Atom_Forge* forge, uint32_t n_props)
+{
+	uint8_t* buf = (uint8_t*)calloc(1, 32 * (n_props + 1));
+	lv2_atom_forge_set_buffer(forge, buf, 32 * (n_props + 1));
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; i < n_props; ++i) {
+		lv2_atom_forge_key(forge, 1000 + i);
+		lv2_atom_forge_float(forge, (float)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Object* obj     = (const LV2_Atom_Object*)buf;
+	const uint32_t         keys[4] = { 1000,
+	                                   1000 + n_props / 3,
+	                                   1000 + 2 * n_props / 3,
+	                                   1000 + n_props - 1 };
+
+	char name[64];
+	snprintf(name, sizeof(name), "lv2_atom_object_query (%u props)", n_props);
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		const LV2_Atom* a = NULL;
+		const LV2_Atom* b = NULL;
+		const LV2_Atom* c = NULL;
+		const LV2_Atom* d = NULL;
+		LV2_Atom_Object_Query q[] = {
+			{ keys[0], &a },
+			{ keys[1], &b },
+			{ keys[2], &c },
+			{ keys[3], &d },
+			LV2_ATOM_OBJECT_QUERY_END
+		};
+		lv2_atom_object_query(obj, q);
+		bench_sink += (uintptr_t)d;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2_atom_object_get (%u props)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		const LV2_Atom* a = NULL;
+		const LV2_Atom* b = NULL;
+		const LV2_Atom* c = NULL;
+		const LV2_Atom* d = NULL;
+		lv2_atom_object_get(obj,
+		                    keys[0], &a,
+		                    keys[1], &b,
+		                    keys[2], &c,
+		                    keys[3], &d,
+		                    0);
+		bench_sink += (uintptr_t)d;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	LV2_Atom_Object_Plan plan;
+	lv2_atom_object_plan_init(&plan, 4, keys);
+
+	snprintf(name, sizeof(name), "lv2_atom_object_plan_query (%u props)",
+	         n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		const LV2_Atom* values[4];
+		lv2_atom_object_plan_query(&plan, obj, values);
+		bench_sink += (uintptr_t)values[3];
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	uint32_t* offsets = (uint32_t*)calloc(n_props, sizeof(uint32_t));
+
+	snprintf(name, sizeof(name), "lv2_atom_object_index (%u props)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		LV2_Atom_Object_Index index;
+		lv2_atom_object_index_init(&index, obj, offsets, n_props);
+		for (unsigned k = 0; k < 4; ++k) {
+			bench_sink += (uintptr_t)lv2_atom_object_index_get(&index, keys[k]);
+		}
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	LV2_Atom_Object_Index index;
+	lv2_atom_object_index_init(&index, obj, offsets, n_props);
+
+	snprintf(name, sizeof(name), "lv2_atom_object_index_get (%u props)",
+	         n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		for (unsigned k = 0; k < 4; ++k) {
+			bench_sink += (uintptr_t)lv2_atom_object_index_get(&index, keys[k]);
+		}
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	free(offsets);
+	free(buf);
+}
+
+/** Apply `gain` to frames [begin, end), a simple vectorisable kernel. */
+static void
+apply_gain(float* out, const float* in, uint32_t begin, uint32_t end, float gain)
+{
+	for (uint32_t i = begin; i < end; ++i) {
+		out[i] = in[i] * gain;
+	}
+}
+
+/**
+   Benchmark splitting a cycle of `n_frames` frames with one MIDI-like event
+   every 8 frames, rendering between events as eg-midigate does.
+*/
+static void
+bench_slicer(LV2_Atom_Forge* forge, uint32_t n_frames)
+{
+	const uint32_t n_events = n_frames / 8;
+	const uint32_t buf_size = 32 * (n_events + 1);
+	uint8_t*       buf      = (uint8_t*)calloc(1, buf_size);
+	float*         in       = (float*)calloc(n_frames, sizeof(float));
+	float*         out      = (float*)calloc(n_frames, sizeof(float));
+	const unsigned n_cycles = 20000;
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, buf_size);
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		const uint8_t msg[3] = { 0x90, (uint8_t)(i % 128), 0x40 };
+		lv2_atom_forge_frame_time(forge, i * 8);
+		lv2_atom_forge_atom(forge, 3, 1);
+		lv2_atom_forge_write(forge, msg, 3);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "hand-coded loop (%u frames)", n_frames);
+	double begin = bench_time();
+	for (unsigned c = 0; c < n_cycles; ++c) {
+		float    gain   = 1.0f;
+		uint32_t offset = 0;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			const uint32_t t = (uint32_t)ev->time.frames;
+			apply_gain(out, in, offset, t, gain);
+			gain   = ((const uint8_t*)(ev + 1))[1] * (1.0f / 127.0f);
+			offset = t;
+		}
+		apply_gain(out, in, offset, n_frames, gain);
+	}
+	bench_report(name, n_cycles, begin, bench_time());
+
+	const uint32_t min_lens[] = { 0, 32, 128 };
+	for (unsigned m = 0; m < sizeof(min_lens) / sizeof(uint32_t); ++m) {
+		snprintf(name, sizeof(name), "lv2_atom_slicer (%u frames, min %u)",
+		         n_frames, min_lens[m]);
+		begin = bench_time();
+		for (unsigned c = 0; c < n_cycles; ++c) {
+			float           gain = 1.0f;
+			LV2_Atom_Slicer slicer;
+			LV2_Atom_Slice  slice;
+			lv2_atom_slicer_init(&slicer, seq, n_frames, min_lens[m]);
+			while (lv2_atom_slicer_next(&slicer, &slice)) {
+				LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+					gain = ((const uint8_t*)(ev + 1))[1] * (1.0f / 127.0f);
+				}
+				apply_gain(out, in, slice.begin, slice.end, gain);
+			}
+		}
+		bench_report(name, n_cycles, begin, bench_time());
+	}
+
+	bench_sink += (uintptr_t)out[n_frames - 1];
+	free(out);
+	free(in);
+	free(buf);
+}
+
+/**
+   Forge MIDI-like events for `n_voices` voices one voice at a time, so the
+   sequence is only in order if there is one voice.
+*/
+static bool
+forge_voices(LV2_Atom_Forge* forge,
+             uint32_t        n_voices,
+             uint32_t        n_events,
+             bool            sort)
+{
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (uint32_t v = 0; v < n_voices; ++v) {
+		for (uint32_t i = 0; i < n_events; ++i) {
+			const uint8_t msg[3] = { 0x90, (uint8_t)(v % 128), 0x40 };
+			lv2_atom_forge_frame_time(forge, i * 16 + v);
+			lv2_atom_forge_atom(forge, 3, 1);
+			lv2_atom_forge_write(forge, msg, 3);
+		}
+	}
+	if (sort) {
+		return lv2_atom_forge_pop_sequence_sorted(forge, &frame, 0);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return true;
+}
+
+/**
+   Benchmark splitting a cycle of `n_frames` frames with events in beat time,
+   like bench_slicer(), at 120 BPM and 48 kHz.
+
+   This compares converting every time stamp with the tempo, as a host or
+   plugin would do by hand, with the slicer and a tempo map.
+*/
+static void
+bench_slicer_beats(LV2_Atom_Forge* forge, uint32_t n_frames)
+{
+	const uint32_t n_events = n_frames / 8;
+	const uint32_t buf_size = 32 * (n_events + 1);
+	uint8_t*       buf      = (uint8_t*)calloc(1, buf_size);
+	float*         in       = (float*)calloc(n_frames, sizeof(float));
+	float*         out      = (float*)calloc(n_frames, sizeof(float));
+	const unsigned n_cycles = 20000;
+	const double   rate     = 48000.0;
+	volatile float bpm      = 120.0f;
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, buf_size);
+	lv2_atom_forge_sequence_head(forge, &frame, 1);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		const uint8_t msg[3] = { 0x90, (uint8_t)(i % 128), 0x40 };
+		lv2_atom_forge_beat_time(forge, i * 8 * bpm / (60.0 * rate));
+		lv2_atom_forge_atom(forge, 3, 1);
+		lv2_atom_forge_write(forge, msg, 3);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "hand-coded beats (%u frames)", n_frames);
+	double begin = bench_time();
+	for (unsigned c = 0; c < n_cycles; ++c) {
+		float    gain   = 1.0f;
+		uint32_t offset = 0;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			const uint32_t t = (uint32_t)(ev->time.beats / (bpm / 60.0) * rate
+			                              + 0.5);
+			apply_gain(out, in, offset, t, gain);
+			gain   = ((const uint8_t*)(ev + 1))[1] * (1.0f / 127.0f);
+			offset = t;
+		}
+		apply_gain(out, in, offset, n_frames, gain);
+	}
+	bench_report(name, n_cycles, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2_atom_slicer beats (%u frames)", n_frames);
+	LV2_Atom_Tempo_Segment segment;
+	LV2_Atom_Tempo_Map     tempo;
+	lv2_atom_tempo_map_init(&tempo, &segment, 1, rate);
+	begin = bench_time();
+	for (unsigned c = 0; c < n_cycles; ++c) {
+		float           gain = 1.0f;
+		LV2_Atom_Slicer slicer;
+		LV2_Atom_Slice  slice;
+		lv2_atom_tempo_map_reset(&tempo, 0, 0.0, bpm);
+		lv2_atom_slicer_init(&slicer, seq, n_frames, 0);
+		lv2_atom_slicer_set_tempo(&slicer, &tempo);
+		while (lv2_atom_slicer_next(&slicer, &slice)) {
+			LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+				gain = ((const uint8_t*)(ev + 1))[1] * (1.0f / 127.0f);
+			}
+			apply_gain(out, in, slice.begin, slice.end, gain);
+		}
+	}
+	bench_report(name, n_cycles, begin, bench_time());
+
+	bench_sink += (uintptr_t)out[n_frames - 1];
+	free(out);
+	free(in);
+	free(buf);
+}
+
+/**
+   Benchmark forging a sequence with `n_events` per voice out of order, then
+   sorting it with and without scratch space.
+*/
+static void
+bench_sequence_sort(LV2_Atom_Forge* forge, uint32_t n_voices, uint32_t n_events)
+{
+	const uint32_t seq_size = 24 * n_voices * n_events + 16;
+	const uint32_t buf_size = 2 * seq_size + 4 * n_voices * n_events + 8;
+	uint8_t*       buf      = (uint8_t*)calloc(1, buf_size);
+	const unsigned n_cycles = N_ITERATIONS / (n_voices * n_events);
+
+	const struct {
+		const char* name;
+		uint32_t    size;
+		bool        sort;
+	} modes[] = { { "unsorted", seq_size, false },
+	              { "sorted with index", buf_size, true },
+	              { "sorted in place", seq_size, true } };
+
+	for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+		char name[64];
+		snprintf(name, sizeof(name), "%s (%u voices, %u events)",
+		         modes[m].name, n_voices, n_events);
+
+		const double begin = bench_time();
+		for (unsigned c = 0; c < n_cycles; ++c) {
+			lv2_atom_forge_set_buffer(forge, buf, modes[m].size);
+			bench_sink += forge_voices(forge, n_voices, n_events, modes[m].sort);
+		}
+		bench_report(name, n_cycles, begin, bench_time());
+	}
+
+	free(buf);
+}
+
+/**
+   Benchmark validating a sequence of `n_events` events, alternating between
+   MIDI-like events and objects with a string and a vector of 64 floats, like
+   typical messages from a UI.
+*/
+static void
+bench_validate(LV2_Atom_Forge* forge, uint32_t n_events)
+{
+	const uint32_t buf_size = 192 * (n_events + 1);
+	uint8_t*       buf      = (uint8_t*)calloc(1, buf_size);
+	const LV2_URID eg_Set   = urid_map(NULL, "http://example.org/Set");
+	const LV2_URID eg_name  = urid_map(NULL, "http://example.org/name");
+	const LV2_URID eg_data  = urid_map(NULL, "http://example.org/data");
+	float          data[64] = { 0.0f };
+
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_set_buffer(forge, buf, buf_size);
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		lv2_atom_forge_frame_time(forge, i);
+		if (i % 2) {
+			lv2_atom_forge_object(forge, &obj_frame, 0, eg_Set);
+			lv2_atom_forge_key(forge, eg_name);
+			lv2_atom_forge_string(forge, "gain", 4);
+			lv2_atom_forge_key(forge, eg_data);
+			lv2_atom_forge_vector(forge, sizeof(float), forge->Float, 64, data);
+			lv2_atom_forge_pop(forge, &obj_frame);
+		} else {
+			const uint8_t msg[3] = { 0x90, (uint8_t)(i % 128), 0x40 };
+			lv2_atom_forge_atom(forge, 3, 1);
+			lv2_atom_forge_write(forge, msg, 3);
+		}
+	}
+	lv2_atom_forge_pop(forge, &seq_frame);
+
+	const LV2_Atom_Sequence* seq      = (const LV2_Atom_Sequence*)buf;
+	const uint32_t           size     = lv2_atom_total_size(&seq->atom);
+	const unsigned           n_passes = N_ITERATIONS / n_events;
+
+	char name[64];
+	snprintf(name, sizeof(name), "lv2_atom_validate (%u events)", n_events);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n_passes; ++i) {
+		bench_sink += lv2_atom_sequence_validate(forge, seq, size);
+	}
+	bench_report_rate(name, (double)size * n_passes, begin, bench_time());
+
+	snprintf(name, sizeof(name), "LV2_ATOM_SEQUENCE_FOREACH (%u events)",
+	         n_events);
+	begin = bench_time();
+	for (unsigned i = 0; i < n_passes; ++i) {
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			bench_sink += ev->body.type;
+		}
+	}
+	bench_report_rate(name, (double)size * n_passes, begin, bench_time());
+
+	free(buf);
+}
+
+/**
+   Benchmark hashing a chunk with a `size` byte body, compared to checking it
+   for equality with an identical copy, which is the worst case for equality.
+*/
+static void
+bench_hash(LV2_Atom_Forge* forge, uint32_t size)
+{
+	const uint32_t total = sizeof(LV2_Atom) + size;
+	LV2_Atom*      a     = (LV2_Atom*)calloc(1, total);
+	LV2_Atom*      b     = (LV2_Atom*)calloc(1, total);
+	a->type = b->type = forge->Chunk;
+	a->size = b->size = size;
+	for (uint32_t i = 0; i < size; ++i) {
+		((uint8_t*)(a + 1))[i] = ((uint8_t*)(b + 1))[i] = (uint8_t)i;
+	}
+
+	const unsigned n = N_ITERATIONS;
+	char           name[64];
+	snprintf(name, sizeof(name), "lv2_atom_hash (%u bytes)", size);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		bench_sink += lv2_atom_hash(a, i);
+	}
+	bench_report(name, n, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2_atom_equals (%u bytes)", size);
+	begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		bench_sink += lv2_atom_equals(a, b);
+		((uint8_t*)(b + 1))[0] = (uint8_t)i;  // Defeat loop-invariant hoisting
+		((uint8_t*)(b + 1))[0] = 0;
+	}
+	bench_report(name, n, begin, bench_time());
+
+	free(b);
+	free(a);
+}
+
+/** Benchmark hashing an object with `n_props` float properties. */
+static void
+bench_hash_object(LV2_Atom_Forge* forge, uint32_t n_props)
+{
+	uint8_t* buf = (uint8_t*)calloc(1, 32 * (n_props + 1));
+	lv2_atom_forge_set_buffer(forge, buf, 32 * (n_props + 1));
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; i < n_props; ++i) {
+		lv2_atom_forge_key(forge, 1000 + i);
+		lv2_atom_forge_float(forge, (float)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom* obj = (const LV2_Atom*)buf;
+	const unsigned  n   = N_ITERATIONS / n_props;
+	char            name[64];
+	snprintf(name, sizeof(name), "lv2_atom_hash (%u props)", n_props);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		bench_sink += lv2_atom_hash(obj, i);
+	}
+	bench_report(name, n, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2_atom_hash_canonical (%u props)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		bench_sink += lv2_atom_hash_canonical(obj, forge->Object, i);
+	}
+	bench_report(name, n, begin, bench_time());
+
+	free(buf);
+}
+
+/**
+   Forge a parameter set with `n_props` properties, like a patch:Put for a
+   plugin with many controls.
+
+   @return True iff everything was written successfully.
+*/
+static bool
+forge_parameters(LV2_Atom_Forge* forge, uint32_t n_props)
+{
+	LV2_Atom_Forge_Frame frame;
+	bool                 ok = lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; ok && i < n_props; ++i) {
+		ok = (lv2_atom_forge_key(forge, 1000 + i) &&
+		      (i % 4 ? lv2_atom_forge_float(forge, (float)i)
+		             : lv2_atom_forge_string(forge, "parameter", 9)));
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return ok;
+}
+
+/**
+   Benchmark sending a parameter set to `n_targets` outputs.
+
+   This compares forging the message for every output with forging it once to
+   a fanout which copies it to every output.
+*/
+static void
+bench_fanout(LV2_Atom_Forge* forge, uint32_t n_props, uint32_t n_targets)
+{
+	const unsigned n = N_ITERATIONS / (n_props * n_targets);
+	uint64_t       msg_buf[512];
+	uint64_t       bufs[8][512];
+	char           name[64];
+
+	LV2_Atom_Forge         forges[8];
+	LV2_Atom_Forge_Frame   frames[8];
+	LV2_Atom_Fanout_Target targets[8];
+	for (uint32_t t = 0; t < n_targets; ++t) {
+		forges[t]        = *forge;
+		targets[t].forge = &forges[t];
+	}
+
+	snprintf(name, sizeof(name), "forge each (%u props, %u outputs)",
+	         n_props, n_targets);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		for (uint32_t t = 0; t < n_targets; ++t) {
+			lv2_atom_forge_set_buffer(
+				&forges[t], (uint8_t*)bufs[t], sizeof(bufs[t]));
+			lv2_atom_forge_sequence_head(&forges[t], &frames[t], 0);
+			lv2_atom_forge_frame_time(&forges[t], i);
+			forge_parameters(&forges[t], n_props);
+			lv2_atom_forge_pop(&forges[t], &frames[t]);
+		}
+		bench_sink += bufs[n_targets - 1][0];
+	}
+	bench_report(name, n, begin, bench_time());
+
+	snprintf(name, sizeof(name), "fanout (%u props, %u outputs)",
+	         n_props, n_targets);
+	LV2_Atom_Fanout fanout;
+	lv2_atom_fanout_init(&fanout, msg_buf, sizeof(msg_buf), targets, n_targets);
+	lv2_atom_fanout_begin(&fanout, forge);
+	begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		for (uint32_t t = 0; t < n_targets; ++t) {
+			lv2_atom_forge_set_buffer(
+				&forges[t], (uint8_t*)bufs[t], sizeof(bufs[t]));
+			lv2_atom_forge_sequence_head(&forges[t], &frames[t], 0);
+		}
+		forge_parameters(forge, n_props);
+		lv2_atom_fanout_commit(&fanout, i);
+		for (uint32_t t = 0; t < n_targets; ++t) {
+			lv2_atom_forge_pop(&forges[t], &frames[t]);
+		}
+		bench_sink += bufs[n_targets - 1][0];
+	}
+	bench_report(name, n, begin, bench_time());
+}
+
+/**
+   Benchmark building a parameter set of unknown size.
+
+   Without an arena, the usual approach is to guess a buffer size and retry
+   with a larger buffer if it is too small.  This is compared with a fresh
+   arena every time, and with one arena which is reused.
+*/
+static void
+bench_arena(LV2_Atom_Forge* forge, uint32_t n_props)
+{
+	const unsigned n = N_ITERATIONS / n_props;
+	char           name[64];
+
+	snprintf(name, sizeof(name), "fixed buffer with retries (%u props)",
+	         n_props);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		uint32_t size = 4096;
+		uint8_t* buf  = (uint8_t*)malloc(size);
+		lv2_atom_forge_set_buffer(forge, buf, size);
+		while (!forge_parameters(forge, n_props)) {
+			free(buf);
+			buf = (uint8_t*)malloc(size *= 2);
+			lv2_atom_forge_set_buffer(forge, buf, size);
+		}
+		bench_sink += ((const LV2_Atom*)buf)->size;
+		free(buf);
+	}
+	bench_report(name, n, begin, bench_time());
+
+	snprintf(name, sizeof(name), "new arena (%u props)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		LV2_Atom_Arena arena;
+		lv2_atom_arena_init(&arena, 4096);
+		lv2_atom_arena_begin(&arena, forge);
+		forge_parameters(forge, n_props);
+		bench_sink += lv2_atom_arena_get(&arena)->size;
+		lv2_atom_arena_free(&arena);
+	}
+	bench_report(name, n, begin, bench_time());
+
+	LV2_Atom_Arena arena;
+	lv2_atom_arena_init(&arena, 4096);
+	snprintf(name, sizeof(name), "reused arena (%u props)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < n; ++i) {
+		lv2_atom_arena_begin(&arena, forge);
+		forge_parameters(forge, n_props);
+		bench_sink += lv2_atom_arena_get(&arena)->size;
+	}
+	bench_report(name, n, begin, bench_time());
+	lv2_atom_arena_free(&arena);
+}
+
+/** Forge a state message with an Int and two Floats, or a path message. */
+static LV2_Atom_Forge_Ref
+forge_message(LV2_Atom_Forge*    forge,
+              LV2_Atom_Template* tmpl,
+              const char*        path,
+              uint32_t           path_len)
+{
+	LV2_Atom_Forge_Frame frame;
+	LV2_Atom_Forge_Ref   ref = lv2_atom_forge_object(forge, &frame, 0, 1);
+	if (path) {
+		lv2_atom_forge_key(forge, 2);
+		lv2_atom_forge_urid(forge, 3);
+		lv2_atom_forge_key(forge, 4);
+		if (tmpl) {
+			lv2_atom_template_mark_tail(tmpl, forge);
+		}
+		lv2_atom_forge_path(forge, path, path_len);
+	} else {
+		lv2_atom_forge_key(forge, 2);
+		lv2_atom_forge_int(forge, 50);
+		lv2_atom_forge_key(forge, 3);
+		lv2_atom_forge_float(forge, 1.0f);
+		lv2_atom_forge_key(forge, 4);
+		lv2_atom_forge_float(forge, 48000.0f);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return ref;
+}
+
+/** Benchmark sending messages with the forge and from a template. */
+static void
+bench_template(LV2_Atom_Forge* forge, const char* path)
+{
+	const uint32_t path_len = path ? (uint32_t)strlen(path) : 0;
+	uint64_t       buf[64];
+	char           name[64];
+
+	LV2_Atom_Template tmpl;
+	lv2_atom_template_begin(&tmpl, forge);
+	forge_message(forge, &tmpl, path, path_len);
+	if (!lv2_atom_template_end(&tmpl)) {
+		fprintf(stderr, "error: Failed to build template\n");
+		return;
+	}
+
+	snprintf(name, sizeof(name), "forge %s", path ? "path" : "state");
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+		bench_sink += forge_message(forge, NULL, path, path_len);
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "template %s", path ? "path" : "state");
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+		LV2_Atom* msg = NULL;
+		if (path) {
+			msg = lv2_atom_template_write_tail(&tmpl, forge, path, path_len + 1);
+		} else if ((msg = lv2_atom_template_write(&tmpl, forge))) {
+			lv2_atom_template_set_int(msg, 40, (int32_t)i);
+			lv2_atom_template_set_float(msg, 64, 1.0f);
+		}
+		bench_sink += (uintptr_t)msg;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	lv2_atom_template_free(&tmpl);
+}
+
+int
+main(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	printf("Object query (4 keys):\n");
+	bench_object_query(&forge, 4);
+	bench_object_query(&forge, 16);
+	bench_object_query(&forge, 64);
+	bench_object_query(&forge, 256);
+
+	printf("\nSlicing cycles with 1 event per 8 frames:\n");
+	bench_slicer(&forge, 512);
+	bench_slicer(&forge, 4096);
+	bench_slicer_beats(&forge, 512);
+	bench_slicer_beats(&forge, 4096);
+
+	printf("\nForging sequences out of order:\n");
+	bench_sequence_sort(&forge, 1, 64);
+	bench_sequence_sort(&forge, 8, 8);
+	bench_sequence_sort(&forge, 8, 64);
+	bench_sequence_sort(&forge, 32, 64);
+
+	printf("\nValidating sequences:\n");
+	bench_validate(&forge, 64);
+	bench_validate(&forge, 4096);
+
+	printf("\nHashing and comparing atoms:\n");
+	bench_hash(&forge, 16);
+	bench_hash(&forge, 256);
+	bench_hash(&forge, 4096);
+	bench_hash_object(&forge, 4);
+	bench_hash_object(&forge, 64);
+
+	printf("\nSending messages:\n");
+	bench_template(&forge, NULL);
+	bench_template(&forge, "/home/user/samples/kick.wav");
+	bench_fanout(&forge, 4, 3);
+	bench_fanout(&forge, 64, 3);
+	bench_fanout(&forge, 64, 8);
+
+	printf("\nBuilding parameter sets of unknown size:\n");
+	bench_arena(&forge, 64);
+	bench_arena(&forge, 1024);
+	bench_arena(&forge, 16384);
+
+	return 0;
+}
@@ -0,0 +1,301 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.hpp"
+
+#define N_ITERATIONS 100000
+
+namespace atom = lv2::atom;
+
+/** Sink for results, so the compiler can not optimise benchmarks away. */
+static volatile uintptr_t bench_sink = 0;
+
+/** Make the compiler assume that `buf` has changed, so loops are not hoisted. */
+static inline void
+bench_clobber(const void* buf)
+{
+#ifdef __GNUC__
+	__asm__ __volatile__("" : : "r"(buf) : "memory");
+#else
+	bench_sink += (uintptr_t)buf;
+#endif
+}
+
+static LV2_URID
+urid_map(LV2_URID_Map_Handle, const char* uri)
+{
+	/* URIDs are not significant here, but must be distinct and stable */
+	uint32_t h = 5381;
+	for (const char* c = uri; *c; ++c) {
+		h = (h << 5) + h + (uint8_t)*c;
+	}
+	return (h & 0xFFFF) + 1;
+}
+
+static double
+bench_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static void
+bench_report(const char* name, unsigned n, double begin, double end)
+{
+	printf("%-44s %10.2f ns\n", name, (end - begin) * 1.0e9 / n);
+}
+
+/** Benchmark summing the Int bodies of a sequence of `n_events` events. */
+static void
+bench_sequence(LV2_Atom_Forge* forge, uint32_t n_events)
+{
+	const uint32_t size = 16 + n_events * 24;
+	uint8_t*       buf  = (uint8_t*)calloc(1, size);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		lv2_atom_forge_frame_time(forge, i);
+		lv2_atom_forge_int(forge, (int32_t)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "LV2_ATOM_SEQUENCE_FOREACH (%u)", n_events);
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		int64_t sum = 0;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			if (ev->body.type == forge->Int) {
+				sum += ev->time.frames + ((const LV2_Atom_Int*)&ev->body)->body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2::atom::SequenceView (%u)", n_events);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		int64_t sum = 0;
+		for (const LV2_Atom_Event& ev : atom::SequenceView(seq)) {
+			if (ev.body.type == forge->Int) {
+				sum += ev.time.frames + ((const LV2_Atom_Int&)ev.body).body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	free(buf);
+}
+
+/** Benchmark summing the Float values of an object with `n_props` keys. */
+static void
+bench_object(LV2_Atom_Forge* forge, uint32_t n_props)
+{
+	const uint32_t size = 16 + n_props * 24;
+	uint8_t*       buf  = (uint8_t*)calloc(1, size);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; i < n_props; ++i) {
+		lv2_atom_forge_key(forge, 1000 + i);
+		lv2_atom_forge_float(forge, (float)i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Object* obj = (const LV2_Atom_Object*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "LV2_ATOM_OBJECT_FOREACH (%u)", n_props);
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		float sum = 0.0f;
+		LV2_ATOM_OBJECT_FOREACH(obj, prop) {
+			if (prop->value.type == forge->Float) {
+				sum += ((const LV2_Atom_Float*)&prop->value)->body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2::atom::ObjectView (%u)", n_props);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		float sum = 0.0f;
+		for (const LV2_Atom_Property_Body& prop : atom::ObjectView(obj)) {
+			if (prop.value.type == forge->Float) {
+				sum += ((const LV2_Atom_Float&)prop.value).body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	free(buf);
+}
+
+/** Benchmark summing the Long elements of a tuple of `n_elems` elements. */
+static void
+bench_tuple(LV2_Atom_Forge* forge, uint32_t n_elems)
+{
+	const uint32_t size = 8 + n_elems * 16;
+	uint8_t*       buf  = (uint8_t*)calloc(1, size);
+
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_tuple(forge, &frame);
+	for (uint32_t i = 0; i < n_elems; ++i) {
+		lv2_atom_forge_long(forge, i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Tuple* tup = (const LV2_Atom_Tuple*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "LV2_ATOM_TUPLE_BODY_FOREACH (%u)", n_elems);
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		int64_t sum = 0;
+		LV2_ATOM_TUPLE_BODY_FOREACH(LV2_ATOM_BODY(tup), tup->atom.size, elem) {
+			if (elem->type == forge->Long) {
+				sum += ((const LV2_Atom_Long*)elem)->body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2::atom::TupleView (%u)", n_elems);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		int64_t sum = 0;
+		for (const LV2_Atom& elem : atom::TupleView(tup)) {
+			if (elem.type == forge->Long) {
+				sum += ((const LV2_Atom_Long&)elem).body;
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	free(buf);
+}
+
+/** Benchmark summing the elements of a Float vector of `n_elems` elements. */
+static void
+bench_vector(LV2_Atom_Forge* forge, uint32_t n_elems)
+{
+	float* const elems = (float*)calloc(n_elems, sizeof(float));
+	for (uint32_t i = 0; i < n_elems; ++i) {
+		elems[i] = (float)i;
+	}
+
+	const uint32_t size = 16 + n_elems * sizeof(float);
+	uint8_t*       buf  = (uint8_t*)calloc(1, size);
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_vector(forge, sizeof(float), forge->Float, n_elems, elems);
+
+	const LV2_Atom* vec = (const LV2_Atom*)buf;
+
+	char name[64];
+	snprintf(name, sizeof(name), "LV2_ATOM_CONTENTS cast (%u)", n_elems);
+	double begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		float sum = 0.0f;
+		const LV2_Atom_Vector* v = (const LV2_Atom_Vector*)vec;
+		if (vec->type == forge->Vector &&
+		    v->body.child_type == forge->Float &&
+		    v->body.child_size == sizeof(float)) {
+			const float* const values =
+				(const float*)LV2_ATOM_CONTENTS(LV2_Atom_Vector, vec);
+			const uint32_t n = (vec->size - sizeof(LV2_Atom_Vector_Body)) /
+				sizeof(float);
+			for (uint32_t j = 0; j < n; ++j) {
+				sum += values[j];
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	snprintf(name, sizeof(name), "lv2::atom::VectorView (%u)", n_elems);
+	begin = bench_time();
+	for (unsigned i = 0; i < N_ITERATIONS; ++i) {
+		bench_clobber(buf);
+		float sum = 0.0f;
+		if (auto v = atom::view<atom::VectorView>(forge, vec)) {
+			if (auto values = v->as<float>(forge)) {
+				for (float f : *values) {
+					sum += f;
+				}
+			}
+		}
+		bench_sink += (uintptr_t)sum;
+	}
+	bench_report(name, N_ITERATIONS, begin, bench_time());
+
+	free(buf);
+	free(elems);
+}
+
+int
+main(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	printf("Iterating over sequences:\n");
+	bench_sequence(&forge, 16);
+	bench_sequence(&forge, 256);
+
+	printf("\nIterating over objects:\n");
+	bench_object(&forge, 16);
+	bench_object(&forge, 256);
+
+	printf("\nIterating over tuples:\n");
+	bench_tuple(&forge, 16);
+	bench_tuple(&forge, 256);
+
+	printf("\nSumming vectors:\n");
+	bench_vector(&forge, 64);
+	bench_vector(&forge, 1024);
+
+	return 0;
+}
@@ -0,0 +1,411 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/arena.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.hpp"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.hpp"
+
+#include <type_traits>
+
+static char** uris   = NULL;
+static size_t n_uris = 0;
+
+static LV2_URID
+urid_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	for (size_t i = 0; i < n_uris; ++i) {
+		if (!strcmp(uris[i], uri)) {
+			return i + 1;
+		}
+	}
+
+	const size_t len = strlen(uri);
+	uris = (char**)realloc(uris, ++n_uris * sizeof(char*));
+	uris[n_uris - 1] = (char*)malloc(len + 1);
+	memcpy(uris[n_uris - 1], uri, len + 1);
+	return n_uris;
+}
+
+static int
+test_fail(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return 1;
+}
+
+/** Schema with one property of every supported type. */
+typedef lv2::atom::Object<int32_t, int64_t, float, double, bool, uint32_t>
+	Message;
+
+static_assert(Message::size == 16 + 6 * 24, "Unexpected message size");
+static_assert(Message::event_size == Message::size + 8,
+              "Unexpected event size");
+
+struct Uris {
+	LV2_URID eg_Message;
+	LV2_URID eg_int;
+	LV2_URID eg_long;
+	LV2_URID eg_float;
+	LV2_URID eg_double;
+	LV2_URID eg_bool;
+	LV2_URID eg_urid;
+	LV2_URID eg_other;
+};
+
+/** Write a message with the C forge, which the schema must match exactly. */
+static void
+forge_message(LV2_Atom_Forge* forge, const Uris& u, int32_t i)
+{
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_object(forge, &frame, 0, u.eg_Message);
+	lv2_atom_forge_key(forge, u.eg_int);
+	lv2_atom_forge_int(forge, i);
+	lv2_atom_forge_key(forge, u.eg_long);
+	lv2_atom_forge_long(forge, i * 2);
+	lv2_atom_forge_key(forge, u.eg_float);
+	lv2_atom_forge_float(forge, i * 3.0f);
+	lv2_atom_forge_key(forge, u.eg_double);
+	lv2_atom_forge_double(forge, i * 4.0);
+	lv2_atom_forge_key(forge, u.eg_bool);
+	lv2_atom_forge_bool(forge, i % 2);
+	lv2_atom_forge_key(forge, u.eg_urid);
+	lv2_atom_forge_urid(forge, u.eg_other);
+	lv2_atom_forge_pop(forge, &frame);
+}
+
+/** Check that values read from a message are those written by forge_message. */
+static bool
+check_message(const Message& message, const LV2_Atom_Object* obj,
+              const Uris& u, int32_t i)
+{
+	int32_t  iv = 0;
+	int64_t  lv = 0;
+	float    fv = 0.0f;
+	double   dv = 0.0;
+	bool     bv = false;
+	uint32_t uv = 0;
+	return message.read(obj, iv, lv, fv, dv, bv, uv) &&
+		iv == i && lv == i * 2 && fv == i * 3.0f && dv == i * 4.0 &&
+		bv == (bool)(i % 2) && uv == u.eg_other;
+}
+
+static int
+test_write(LV2_Atom_Forge* forge, const Uris& u, const Message& message)
+{
+	uint8_t c_buf[1024];
+	uint8_t t_buf[1024];
+
+	// Write a sequence of events with both forges
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, c_buf, sizeof(c_buf));
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (int32_t i = 0; i < 3; ++i) {
+		lv2_atom_forge_frame_time(forge, i * 10);
+		forge_message(forge, u, i);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	memset(t_buf, 0xFF, sizeof(t_buf));
+	lv2_atom_forge_set_buffer(forge, t_buf, sizeof(t_buf));
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (int32_t i = 0; i < 3; ++i) {
+		if (!message.write_event(
+			    forge, i * 10, i, i * 2, i * 3.0f, i * 4.0, i % 2, u.eg_other)) {
+			return test_fail("Failed to write event %d\n", i);
+		}
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom* c_seq = (const LV2_Atom*)c_buf;
+	if (c_seq->size != 8 + 3 * Message::event_size ||
+	    memcmp(c_buf, t_buf, lv2_atom_total_size(c_seq))) {
+		return test_fail("Typed sequence differs from forged sequence\n");
+	}
+
+	// Write a single object and check its size and contents
+	lv2_atom_forge_set_buffer(forge, t_buf, sizeof(t_buf));
+	LV2_Atom_Forge_Ref ref = message.write(
+		forge, 7, 14, 21.0f, 28.0, true, u.eg_other);
+	const LV2_Atom_Object* obj = (const LV2_Atom_Object*)t_buf;
+	if (!ref || forge->offset != Message::size ||
+	    obj->atom.type != forge->Object || obj->body.otype != u.eg_Message ||
+	    !check_message(message, obj, u, 7)) {
+		return test_fail("Incorrect typed object\n");
+	}
+
+	// Write to a buffer that is too small, which writes nothing
+	lv2_atom_forge_set_buffer(forge, t_buf, Message::size - 8);
+	if (message.write(forge, 1, 2, 3.0f, 4.0, false, 0) || forge->offset) {
+		return test_fail("Wrote typed object to a small buffer\n");
+	}
+
+	// Write to a sink, which gets the object in one piece
+	LV2_Atom_Arena arena;
+	lv2_atom_arena_init(&arena, 0);
+	lv2_atom_arena_begin(&arena, forge);
+	ref = message.write(forge, 7, 14, 21.0f, 28.0, true, u.eg_other);
+	const LV2_Atom* sunk = lv2_atom_arena_get(&arena);
+	if (!ref || !sunk || !lv2_atom_equals(sunk, (const LV2_Atom*)t_buf)) {
+		lv2_atom_arena_free(&arena);
+		return test_fail("Sink typed object differs from buffer object\n");
+	}
+	lv2_atom_arena_free(&arena);
+
+	return 0;
+}
+
+static int
+test_read(LV2_Atom_Forge* forge, const Uris& u, const Message& message)
+{
+	uint8_t buf[1024];
+
+	// Read an object with exactly the schema layout
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	forge_message(forge, u, 5);
+	if (!check_message(message, (const LV2_Atom_Object*)buf, u, 5)) {
+		return test_fail("Failed to read object with schema layout\n");
+	}
+
+	// Read an object with properties in a different order and extra ones
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_object(forge, &frame, 0, u.eg_Message);
+	lv2_atom_forge_key(forge, u.eg_urid);
+	lv2_atom_forge_urid(forge, u.eg_other);
+	lv2_atom_forge_key(forge, u.eg_other);
+	lv2_atom_forge_string(forge, "extra", 5);
+	lv2_atom_forge_key(forge, u.eg_bool);
+	lv2_atom_forge_bool(forge, true);
+	lv2_atom_forge_key(forge, u.eg_double);
+	lv2_atom_forge_double(forge, 12.0);
+	lv2_atom_forge_key(forge, u.eg_float);
+	lv2_atom_forge_float(forge, 9.0f);
+	lv2_atom_forge_key(forge, u.eg_long);
+	lv2_atom_forge_long(forge, 6);
+	lv2_atom_forge_key(forge, u.eg_int);
+	lv2_atom_forge_int(forge, 3);
+	lv2_atom_forge_pop(forge, &frame);
+	if (!check_message(message, (const LV2_Atom_Object*)buf, u, 3)) {
+		return test_fail("Failed to read reordered object\n");
+	}
+
+	// Read an object with a value of the wrong type
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_object(forge, &frame, 0, u.eg_Message);
+	lv2_atom_forge_key(forge, u.eg_int);
+	lv2_atom_forge_float(forge, 1.0f);
+	lv2_atom_forge_pop(forge, &frame);
+
+	int32_t  iv = 42;
+	int64_t  lv = 0;
+	float    fv = 0.0f;
+	double   dv = 0.0;
+	bool     bv = false;
+	uint32_t uv = 0;
+	if (message.read((const LV2_Atom_Object*)buf, iv, lv, fv, dv, bv, uv) ||
+	    iv != 42) {
+		return test_fail("Read value with incorrect type\n");
+	}
+
+	return 0;
+}
+
+static_assert(std::is_trivially_copyable<lv2::atom::SequenceView>::value &&
+              std::is_trivially_copyable<lv2::atom::ObjectView>::value &&
+              std::is_trivially_copyable<lv2::atom::TupleView>::value &&
+              std::is_trivially_copyable<lv2::atom::VectorView>::value,
+              "Views are not trivially copyable");
+
+static int
+test_views(LV2_Atom_Forge* forge, const Uris& u)
+{
+	namespace atom = lv2::atom;
+
+	uint64_t buf[128];
+	memset(buf, 0, sizeof(buf));
+
+	// Write a sequence with an object, a tuple, a vector, and an int
+	const float          floats[] = { 1.0f, 2.0f, 3.0f };
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	lv2_atom_forge_frame_time(forge, 1);
+	lv2_atom_forge_object(forge, &frame, 7, u.eg_Message);
+	lv2_atom_forge_key(forge, u.eg_int);
+	lv2_atom_forge_int(forge, 42);
+	lv2_atom_forge_key(forge, u.eg_other);
+	lv2_atom_forge_string(forge, "odd length", 10);
+	lv2_atom_forge_key(forge, u.eg_float);
+	lv2_atom_forge_float(forge, 2.5f);
+	lv2_atom_forge_pop(forge, &frame);
+	lv2_atom_forge_frame_time(forge, 2);
+	lv2_atom_forge_tuple(forge, &frame);
+	lv2_atom_forge_bool(forge, true);
+	lv2_atom_forge_string(forge, "str", 3);
+	lv2_atom_forge_long(forge, 3);
+	lv2_atom_forge_pop(forge, &frame);
+	lv2_atom_forge_frame_time(forge, 3);
+	lv2_atom_forge_vector(forge, sizeof(float), forge->Float, 3, floats);
+	lv2_atom_forge_frame_time(forge, 4);
+	lv2_atom_forge_int(forge, 4);
+	lv2_atom_forge_pop(forge, &seq_frame);
+
+	const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+
+	// Iterate over events, which must be those visited by the C macro
+	const LV2_Atom_Event* expected[8];
+	size_t                n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		expected[n_events++] = ev;
+	}
+
+	auto seq_view = atom::view<atom::SequenceView>(forge, &seq->atom);
+	if (!seq_view || seq_view->empty() || seq_view->unit()) {
+		return test_fail("Failed to view sequence\n");
+	}
+
+	size_t i = 0;
+	for (const LV2_Atom_Event& ev : *seq_view) {
+		if (i == n_events || &ev != expected[i] ||
+		    ev.time.frames != (int64_t)++i) {
+			return test_fail("Sequence view visited incorrect event\n");
+		}
+	}
+	if (i != 4) {
+		return test_fail("Sequence view visited %zu events, not 4\n", i);
+	}
+
+	atom::SequenceView::iterator ev = seq_view->begin();
+
+	// View the object, and check that views of the wrong type are empty
+	if (atom::view<atom::TupleView>(forge, &ev->body) ||
+	    atom::view<atom::ObjectView>(forge, nullptr)) {
+		return test_fail("Viewed atom as the wrong type\n");
+	}
+	auto obj = atom::view<atom::ObjectView>(forge, &ev->body);
+	if (!obj || obj->id() != 7 || obj->otype() != u.eg_Message) {
+		return test_fail("Failed to view object\n");
+	}
+
+	LV2_URID keys[3] = { 0, 0, 0 };
+	i = 0;
+	for (const LV2_Atom_Property_Body& prop : *obj) {
+		keys[i++] = prop.key;
+	}
+	const LV2_Atom* fv = obj->get(u.eg_float);
+	if (i != 3 || keys[0] != u.eg_int || keys[1] != u.eg_other ||
+	    keys[2] != u.eg_float || !fv || fv->type != forge->Float ||
+	    ((const LV2_Atom_Float*)fv)->body != 2.5f || obj->get(u.eg_bool)) {
+		return test_fail("Incorrect object properties\n");
+	}
+
+	// View the tuple
+	auto tup = atom::view<atom::TupleView>(forge, &(++ev)->body);
+	if (!tup || tup->empty()) {
+		return test_fail("Failed to view tuple\n");
+	}
+
+	const LV2_URID types[] = { forge->Bool, forge->String, forge->Long };
+	i = 0;
+	for (const LV2_Atom& elem : *tup) {
+		if (i == 3 || elem.type != types[i++]) {
+			return test_fail("Incorrect tuple element\n");
+		}
+	}
+	if (i != 3) {
+		return test_fail("Tuple view visited %zu elements, not 3\n", i);
+	}
+
+	// View the vector as the correct and incorrect types
+	auto vec = atom::view<atom::VectorView>(forge, &(++ev)->body);
+	if (!vec || vec->size() != 3 || vec->child_type() != forge->Float ||
+	    vec->child_size() != sizeof(float)) {
+		return test_fail("Failed to view vector\n");
+	}
+	if (vec->as<int32_t>(forge) || vec->as<double>(forge)) {
+		return test_fail("Viewed vector elements as the wrong type\n");
+	}
+
+	auto values = vec->as<float>(forge);
+	if (!values || values->size() != 3 || (*values)[2] != 3.0f) {
+		return test_fail("Failed to get vector elements\n");
+	}
+	float sum = 0.0f;
+	for (float f : *values) {
+		sum += f;
+	}
+	if (sum != 6.0f || vec->elements<float>().data() != values->data()) {
+		return test_fail("Incorrect vector elements\n");
+	}
+
+	// Views of empty containers visit nothing
+	const LV2_Atom_Sequence empty_seq = { { 8, forge->Sequence }, { 0, 0 } };
+	const LV2_Atom_Tuple    empty_tup = { { 0, forge->Tuple } };
+	for (const LV2_Atom_Event& e : atom::SequenceView(&empty_seq)) {
+		return test_fail("Visited event %ld in empty sequence\n",
+		                 (long)e.time.frames);
+	}
+	for (const LV2_Atom& e : atom::TupleView(&empty_tup)) {
+		return test_fail("Visited element of type %u in empty tuple\n",
+		                 e.type);
+	}
+
+	return 0;
+}
+
+int
+main(void)
+{
+	LV2_URID_Map   map = { NULL, urid_map };
+	LV2_Atom_Forge forge;
+	lv2_atom_forge_init(&forge, &map);
+
+	Uris u;
+	u.eg_Message = urid_map(NULL, "http://example.org/Message");
+	u.eg_int     = urid_map(NULL, "http://example.org/int");
+	u.eg_long    = urid_map(NULL, "http://example.org/long");
+	u.eg_float   = urid_map(NULL, "http://example.org/float");
+	u.eg_double  = urid_map(NULL, "http://example.org/double");
+	u.eg_bool    = urid_map(NULL, "http://example.org/bool");
+	u.eg_urid    = urid_map(NULL, "http://example.org/urid");
+	u.eg_other   = urid_map(NULL, "http://example.org/other");
+
+	const LV2_URID keys[] = { u.eg_int, u.eg_long, u.eg_float,
+	                          u.eg_double, u.eg_bool, u.eg_urid };
+	const Message message(&forge, u.eg_Message, keys);
+
+	const int ret = test_write(&forge, u, message) ||
+		test_read(&forge, u, message) ||
+		test_views(&forge, u);
+
+	for (size_t i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+
+	return ret;
+}
@@ -18,7 +18,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "lv2/lv2plug.in/ns/ext/atom/arena.h"
+#include "lv2/lv2plug.in/ns/ext/atom/codec.h"
+#include "lv2/lv2plug.in/ns/ext/atom/fanout.h"
 #include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/ring.h"
+#include "lv2/lv2plug.in/ns/ext/atom/template.h"
 #include "lv2/lv2plug.in/ns/ext/atom/util.h"
 
 char** uris   = NULL;
@@ -47,6 +52,12 @@ urid_map(LV2_URID_Map_Handle handle, const char* uri)
 	return n_uris;
 }
 
+static const char*
+urid_unmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	return (urid > 0 && urid <= n_uris) ? uris[urid - 1] : NULL;
+}
+
 static int
 test_fail(const char* fmt, ...)
 {
@@ -58,6 +69,1916 @@ test_fail(const char* fmt, ...)
 	return 1;
 }
 
+/** Forge a sequence of Int events with the given times and values. */
+static LV2_Atom_Sequence*
+forge_int_sequence(LV2_Atom_Forge* forge,
+                   uint8_t*        buf,
+                   uint32_t        size,
+                   uint32_t        n_events,
+                   const int64_t*  times,
+                   const int32_t*  values)
+{
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		lv2_atom_forge_frame_time(forge, times[i]);
+		lv2_atom_forge_int(forge, values[i]);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return (LV2_Atom_Sequence*)buf;
+}
+
+/** Check that `seq` contains Int events with the given times and values. */
+static int
+check_int_sequence(const LV2_Atom_Sequence* seq,
+                   uint32_t                 n_events,
+                   const int64_t*           times,
+                   const int32_t*           values)
+{
+	uint32_t n = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		const int32_t value = ((const LV2_Atom_Int*)&ev->body)->body;
+		if (n >= n_events) {
+			return test_fail("Sequence has too many events\n");
+		} else if (ev->time.frames != times[n]) {
+			return test_fail("Event %u time %ld != %ld\n",
+			                 n, (long)ev->time.frames, (long)times[n]);
+		} else if (value != values[n]) {
+			return test_fail("Event %u value %d != %d\n", n, value, values[n]);
+		}
+		++n;
+	}
+	if (n != n_events) {
+		return test_fail("Sequence has %u events != %u\n", n, n_events);
+	}
+	return 0;
+}
+
+static int
+test_sequence_merge(LV2_Atom_Forge* forge)
+{
+	static const int64_t a_times[]  = { 0, 4, 4, 9 };
+	static const int32_t a_values[] = { 1, 2, 3, 4 };
+	static const int64_t b_times[]  = { 4, 5, 6 };
+	static const int32_t b_values[] = { 11, 12, 13 };
+	static const int64_t c_times[]  = { 1, 2, 3, 10 };
+	static const int32_t c_values[] = { 21, 22, 23, 24 };
+
+	uint8_t a_buf[256];
+	uint8_t b_buf[256];
+	uint8_t c_buf[256];
+	uint8_t e_buf[64];
+	uint8_t out_buf[512];
+
+	const LV2_Atom_Sequence* inputs[] = {
+		forge_int_sequence(forge, a_buf, sizeof(a_buf), 4, a_times, a_values),
+		forge_int_sequence(forge, e_buf, sizeof(e_buf), 0, NULL, NULL),
+		forge_int_sequence(forge, b_buf, sizeof(b_buf), 3, b_times, b_values),
+		forge_int_sequence(forge, c_buf, sizeof(c_buf), 4, c_times, c_values)
+	};
+
+	LV2_Atom_Sequence* out = (LV2_Atom_Sequence*)out_buf;
+	out->atom.type = forge->Sequence;
+	out->body.unit = 0;
+	out->body.pad  = 0;
+	lv2_atom_sequence_clear(out);
+
+	static const int64_t times[]  = { 0, 1, 2, 3, 4, 4, 4, 5, 6, 9, 10 };
+	static const int32_t values[] = { 1, 21, 22, 23, 2, 3, 11, 12, 13, 4, 24 };
+
+	const uint32_t capacity = sizeof(out_buf) - sizeof(LV2_Atom);
+	if (!lv2_atom_sequence_merge(out, capacity, 4, inputs, 0)) {
+		return test_fail("Failed to merge sequences\n");
+	} else if (check_int_sequence(out, 11, times, values)) {
+		return 1;
+	}
+
+	// Merge into an output with space for only 5 events
+	lv2_atom_sequence_clear(out);
+	const uint32_t small = (uint32_t)sizeof(LV2_Atom_Sequence_Body) + 5 * 24;
+	if (lv2_atom_sequence_merge(out, small, 4, inputs, 0)) {
+		return test_fail("Merged sequences into insufficient space\n");
+	} else if (check_int_sequence(out, 5, times, values)) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static int
+test_sequence_index(LV2_Atom_Forge* forge)
+{
+	static const int64_t times[]  = { 0, 2, 2, 2, 5, 7, 8 };
+	static const int32_t values[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+	uint8_t                  buf[512];
+	const LV2_Atom_Sequence* seq = forge_int_sequence(
+		forge, buf, sizeof(buf), 7, times, values);
+
+	uint32_t                offsets[7];
+	LV2_Atom_Sequence_Index index;
+	if (lv2_atom_sequence_index_init(&index, seq, offsets, 6)) {
+		return test_fail("Indexed sequence into insufficient space\n");
+	} else if (index.n_events != 6 || lv2_atom_sequence_index_get(&index, 6)) {
+		return test_fail("Partial index has %u events != 6\n", index.n_events);
+	} else if (lv2_atom_sequence_index_seek_frames(&index, 100) != 6) {
+		return test_fail("Partial index seeked past its events\n");
+	} else if (!lv2_atom_sequence_index_init(&index, seq, offsets, 7)) {
+		return test_fail("Failed to index sequence\n");
+	}
+
+	for (uint32_t i = 0; i < 7; ++i) {
+		const LV2_Atom_Event* ev = lv2_atom_sequence_index_get(&index, i);
+		if (((const LV2_Atom_Int*)&ev->body)->body != values[i]) {
+			return test_fail("Indexed event %u is incorrect\n", i);
+		}
+	}
+	if (lv2_atom_sequence_index_get(&index, 7)) {
+		return test_fail("Got indexed event past end\n");
+	}
+
+	static const int64_t  seek_times[]   = { -1, 0, 1, 2, 3, 7, 8, 9 };
+	static const uint32_t seek_results[] = { 0, 0, 1, 1, 4, 5, 6, 7 };
+	for (uint32_t i = 0; i < sizeof(seek_times) / sizeof(int64_t); ++i) {
+		const uint32_t r = lv2_atom_sequence_index_seek_frames(
+			&index, seek_times[i]);
+		if (r != seek_results[i]) {
+			return test_fail("Seek to %ld found %u != %u\n",
+			                 (long)seek_times[i], r, seek_results[i]);
+		}
+	}
+
+	return 0;
+}
+
+/** Check that the next slice from `slicer` has the given range and events. */
+static int
+check_slice(LV2_Atom_Slicer* slicer,
+            uint32_t         begin,
+            uint32_t         end,
+            uint32_t         n_events,
+            int32_t          first_value)
+{
+	LV2_Atom_Slice slice;
+	if (!lv2_atom_slicer_next(slicer, &slice)) {
+		return test_fail("Premature end of slices\n");
+	} else if (slice.begin != begin || slice.end != end) {
+		return test_fail("Slice [%u, %u) != [%u, %u)\n",
+		                 slice.begin, slice.end, begin, end);
+	}
+
+	uint32_t n = 0;
+	LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+		if (n == 0 && ((LV2_Atom_Int*)&ev->body)->body != first_value) {
+			return test_fail("Slice [%u, %u) starts with wrong event\n",
+			                 begin, end);
+		}
+		++n;
+	}
+	if (n != n_events) {
+		return test_fail("Slice [%u, %u) has %u events != %u\n",
+		                 begin, end, n, n_events);
+	}
+	return 0;
+}
+
+static int
+test_sequence_slicer(LV2_Atom_Forge* forge)
+{
+	static const int64_t times[]  = { 0, 0, 10, 12, 70 };
+	static const int32_t values[] = { 1, 2, 3, 4, 5 };
+
+	uint8_t                  buf[512];
+	const LV2_Atom_Sequence* seq = forge_int_sequence(
+		forge, buf, sizeof(buf), 5, times, values);
+
+	LV2_Atom_Slice  slice;
+	LV2_Atom_Slicer slicer;
+	lv2_atom_slicer_init(&slicer, seq, 64, 0);
+	if (check_slice(&slicer, 0, 10, 2, 1) ||
+	    check_slice(&slicer, 10, 12, 1, 3) ||
+	    check_slice(&slicer, 12, 64, 1, 4) ||
+	    check_slice(&slicer, 64, 64, 1, 5)) {
+		return 1;
+	} else if (lv2_atom_slicer_next(&slicer, &slice)) {
+		return test_fail("Slicer did not end\n");
+	}
+
+	lv2_atom_slicer_init(&slicer, seq, 64, 4);
+	if (check_slice(&slicer, 0, 10, 2, 1) ||
+	    check_slice(&slicer, 10, 64, 2, 3) ||
+	    check_slice(&slicer, 64, 64, 1, 5)) {
+		return 1;
+	} else if (lv2_atom_slicer_next(&slicer, &slice)) {
+		return test_fail("Slicer did not end\n");
+	}
+
+	seq = forge_int_sequence(forge, buf, sizeof(buf), 2, times + 2, values);
+	lv2_atom_slicer_init(&slicer, seq, 64, 0);
+	if (check_slice(&slicer, 0, 10, 0, 0) ||
+	    check_slice(&slicer, 10, 12, 1, 1) ||
+	    check_slice(&slicer, 12, 64, 1, 2)) {
+		return 1;
+	} else if (lv2_atom_slicer_next(&slicer, &slice)) {
+		return test_fail("Slicer did not end\n");
+	}
+
+	return 0;
+}
+
+static int
+test_sequence_editor(LV2_Atom_Forge* forge)
+{
+	static const int64_t times[]  = { 0, 1, 2, 3 };
+	static const int32_t values[] = { 1, 2, 3, 4 };
+
+	// Remove and modify events with no extra space
+	uint8_t            buf[512];
+	LV2_Atom_Sequence* seq = forge_int_sequence(
+		forge, buf, sizeof(buf), 4, times, values);
+
+	LV2_Atom_Sequence_Editor editor;
+	lv2_atom_sequence_editor_init(&editor, seq, seq->atom.size);
+	for (LV2_Atom_Event* ev = NULL;
+	     (ev = lv2_atom_sequence_editor_current(&editor));) {
+		LV2_Atom_Int* value = (LV2_Atom_Int*)&ev->body;
+		if (value->body == 2) {
+			lv2_atom_sequence_editor_drop(&editor);
+		} else {
+			value->body *= 10;
+			lv2_atom_sequence_editor_keep(&editor);
+		}
+	}
+	lv2_atom_sequence_editor_finish(&editor);
+
+	static const int64_t filtered_times[]  = { 0, 2, 3 };
+	static const int32_t filtered_values[] = { 10, 30, 40 };
+	if (check_int_sequence(seq, 3, filtered_times, filtered_values)) {
+		return 1;
+	}
+
+	// Insert events with space for only two more than the original, with a
+	// capacity that is not a multiple of 8, and with an unpadded last event
+	static const uint32_t extra_space[] = { 48, 52, 52 };
+	static const int64_t  inserted_times[]  = { 0, 1, 1, 2, 2, 3 };
+	static const int32_t  inserted_values[] = { 11, 12, 2, 13, 3, 4 };
+
+	struct {
+		LV2_Atom_Event event;
+		int32_t        value;
+	} extra = { { { 0 }, { sizeof(int32_t), forge->Int } }, 0 };
+
+	for (unsigned i = 0; i < 3; ++i) {
+		seq = forge_int_sequence(forge, buf, sizeof(buf), 4, times, values);
+		if (i == 2) {
+			seq->atom.size -= 4;
+		}
+		lv2_atom_sequence_editor_init(
+			&editor, seq, seq->atom.size + extra_space[i]);
+
+		for (LV2_Atom_Event* ev = NULL;
+		     (ev = lv2_atom_sequence_editor_current(&editor));) {
+			const size_t offset = (size_t)((uint8_t*)ev - (uint8_t*)seq);
+			if (offset % 8) {
+				return test_fail("Editor event at misaligned offset %u\n",
+				                 (unsigned)offset);
+			}
+
+			const int32_t value = ((const LV2_Atom_Int*)&ev->body)->body;
+			extra.event.time.frames = ev->time.frames;
+			extra.value             = value + 10;
+			if (!lv2_atom_sequence_editor_insert(&editor, &extra.event)) {
+				if (value != 4) {
+					return test_fail("Failed to insert before event %d\n",
+					                 value);
+				}
+			} else if (value == 4) {
+				return test_fail("Inserted event past capacity\n");
+			}
+
+			if (value == 1) {
+				lv2_atom_sequence_editor_drop(&editor);
+			} else {
+				lv2_atom_sequence_editor_keep(&editor);
+			}
+		}
+		lv2_atom_sequence_editor_finish(&editor);
+
+		if (check_int_sequence(seq, 6, inserted_times, inserted_values)) {
+			return 1;
+		}
+	}
+
+	// Append an event after visiting every event
+	seq = forge_int_sequence(forge, buf, sizeof(buf), 4, times, values);
+	lv2_atom_sequence_editor_init(&editor, seq, sizeof(buf) - sizeof(LV2_Atom));
+	while (lv2_atom_sequence_editor_current(&editor)) {
+		lv2_atom_sequence_editor_keep(&editor);
+	}
+	extra.event.time.frames = 4;
+	extra.value             = 5;
+	if (!lv2_atom_sequence_editor_insert(&editor, &extra.event)) {
+		return test_fail("Failed to append event\n");
+	}
+	lv2_atom_sequence_editor_finish(&editor);
+
+	static const int64_t appended_times[]  = { 0, 1, 2, 3, 4 };
+	static const int32_t appended_values[] = { 1, 2, 3, 4, 5 };
+	return check_int_sequence(seq, 5, appended_times, appended_values);
+}
+
+static int
+test_validate(LV2_Atom_Forge* forge)
+{
+	const LV2_URID eg_Object = urid_map(NULL, "http://example.org/Object");
+	const LV2_URID eg_key    = urid_map(NULL, "http://example.org/key");
+
+	// Forge a sequence with an object containing a tuple of strings and a vector
+	uint8_t              buf[512];
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	LV2_Atom_Forge_Frame tup_frame;
+	const int32_t        elems[] = { 1, 2, 3 };
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	lv2_atom_forge_frame_time(forge, 1);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_frame_time(forge, 2);
+	lv2_atom_forge_object(forge, &obj_frame, 0, eg_Object);
+	lv2_atom_forge_key(forge, eg_key);
+	lv2_atom_forge_tuple(forge, &tup_frame);
+	LV2_Atom* str = (LV2_Atom*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_string(forge, "hello", 5));
+	lv2_atom_forge_literal(forge, "hi", 2, 0, 0);
+	lv2_atom_forge_pop(forge, &tup_frame);
+	lv2_atom_forge_key(forge, eg_key);
+	LV2_Atom* vec = (LV2_Atom*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_vector(forge, sizeof(int32_t), forge->Int, 3, elems));
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_frame_time(forge, 3);
+	LV2_Atom* last = (LV2_Atom*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_long(forge, 4));
+	lv2_atom_forge_pop(forge, &seq_frame);
+
+	LV2_Atom_Sequence* seq  = (LV2_Atom_Sequence*)buf;
+	const uint32_t     size = lv2_atom_total_size(&seq->atom);
+	if (!lv2_atom_sequence_validate(forge, seq, size)) {
+		return test_fail("Valid sequence is invalid\n");
+	} else if (lv2_atom_validate(forge, &seq->atom, size - 8)) {
+		return test_fail("Truncated sequence is valid\n");
+	} else if (lv2_atom_object_validate(forge, (LV2_Atom_Object*)seq, size)) {
+		return test_fail("Sequence is a valid object\n");
+	}
+
+	// Break things one at a time, and check that the sequence becomes invalid
+	((char*)(str + 1))[5] = 'x';
+	if (lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Unterminated string is valid\n");
+	}
+	((char*)(str + 1))[5] = '\0';
+
+	vec->size -= 2;
+	if (lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Vector with partial element is valid\n");
+	}
+	vec->size += 2;
+
+	last->size = 4;
+	if (lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Long with bad size is valid\n");
+	}
+	last->size = 64;
+	if (lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Atom overflowing container is valid\n");
+	}
+	last->size = 8;
+
+	*((int64_t*)last - 1) = 0;
+	if (lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Unordered sequence is valid\n");
+	}
+	*((int64_t*)last - 1) = 3;
+
+	if (!lv2_atom_validate(forge, &seq->atom, size)) {
+		return test_fail("Repaired sequence is invalid\n");
+	}
+
+	// Check the order of sequences with explicit time units
+	const LV2_URID frame_time = urid_map(NULL, LV2_ATOM__frameTime);
+	const LV2_URID beat_time  = urid_map(NULL, LV2_ATOM__beatTime);
+	for (unsigned i = 0; i < 2; ++i) {
+		lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+		lv2_atom_forge_sequence_head(forge, &seq_frame, i ? beat_time
+		                                                  : frame_time);
+		for (int32_t t = 0; t < 3; ++t) {
+			if (i) {
+				lv2_atom_forge_beat_time(forge, t / 2.0);
+			} else {
+				lv2_atom_forge_frame_time(forge, t);
+			}
+			lv2_atom_forge_int(forge, t);
+		}
+		lv2_atom_forge_pop(forge, &seq_frame);
+
+		LV2_Atom_Event* const first = lv2_atom_sequence_begin(&seq->body);
+		LV2_Atom_Event* const ev    = lv2_atom_sequence_next(first);
+		if (!lv2_atom_validate_units(
+			    forge, &seq->atom, sizeof(buf), frame_time, beat_time)) {
+			return test_fail("Valid sequence %u with unit is invalid\n", i);
+		}
+
+		if (i) {
+			ev->time.beats = -1.0;
+		} else {
+			ev->time.frames = -1;
+		}
+		if (!lv2_atom_validate(forge, &seq->atom, sizeof(buf))) {
+			return test_fail("Sequence with unknown unit is invalid\n");
+		} else if (lv2_atom_validate_units(
+			           forge, &seq->atom, sizeof(buf), frame_time, beat_time)) {
+			return test_fail("Unordered sequence %u with unit is valid\n", i);
+		}
+	}
+
+	// Nest tuples too deeply
+	LV2_Atom_Forge_Frame frames[LV2_ATOM_VALIDATE_MAX_DEPTH + 1];
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	for (unsigned i = 0; i < LV2_ATOM_VALIDATE_MAX_DEPTH + 1; ++i) {
+		lv2_atom_forge_tuple(forge, &frames[i]);
+	}
+	for (unsigned i = LV2_ATOM_VALIDATE_MAX_DEPTH + 1; i > 0; --i) {
+		lv2_atom_forge_pop(forge, &frames[i - 1]);
+	}
+	if (lv2_atom_validate(forge, (LV2_Atom*)buf, sizeof(buf))) {
+		return test_fail("Deeply nested tuple is valid\n");
+	} else if (!lv2_atom_validate(forge, (LV2_Atom*)(buf + 8), sizeof(buf) - 8)) {
+		return test_fail("Maximally nested tuple is invalid\n");
+	}
+
+	return 0;
+}
+
+/** A growable memory buffer used as encoder output and decoder input. */
+typedef struct {
+	uint8_t* buf;
+	uint32_t size;
+	uint32_t offset;
+	uint32_t chunk;
+} CodecBuffer;
+
+static LV2_Atom_Forge_Ref
+codec_sink(LV2_Atom_Forge_Sink_Handle handle, const void* buf, uint32_t size)
+{
+	CodecBuffer* out = (CodecBuffer*)handle;
+	out->buf = (uint8_t*)realloc(out->buf, out->size + size);
+	memcpy(out->buf + out->size, buf, size);
+	out->size += size;
+	return out->size;
+}
+
+static uint32_t
+codec_source(void* handle, void* buf, uint32_t size)
+{
+	// Return at most `chunk` bytes at a time to test refilling
+	CodecBuffer*   in = (CodecBuffer*)handle;
+	const uint32_t n  = (in->size - in->offset < in->chunk)
+		? in->size - in->offset : in->chunk;
+	memcpy(buf, in->buf + in->offset, n < size ? n : size);
+	in->offset += (n < size ? n : size);
+	return n < size ? n : size;
+}
+
+static int
+test_codec(LV2_Atom_Forge* forge)
+{
+	LV2_URID_Unmap unmap     = { NULL, urid_unmap };
+	LV2_URID_Map   map       = { NULL, urid_map };
+	const LV2_URID eg_Object = urid_map(NULL, "http://example.org/Object");
+	const LV2_URID eg_key    = urid_map(NULL, "http://example.org/key");
+	const LV2_URID eg_value  = urid_map(NULL, "http://example.org/value");
+	const LV2_URID beat_time = urid_map(NULL, LV2_ATOM__beatTime);
+	const float    floats[]  = { 1.0f, -2.5f, 3.25f };
+	const uint8_t  midi[]    = { 0x90, 0x40, 0x7F };
+
+	// Forge a sequence of an object containing every type and a beat sequence
+	uint8_t              buf[1024];
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	LV2_Atom_Forge_Frame tup_frame;
+	LV2_Atom_Forge_Frame beats_frame;
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	lv2_atom_forge_frame_time(forge, -1);
+	lv2_atom_forge_object(forge, &obj_frame, 0, eg_Object);
+	lv2_atom_forge_key(forge, eg_key);
+	lv2_atom_forge_tuple(forge, &tup_frame);
+	lv2_atom_forge_int(forge, -42);
+	lv2_atom_forge_long(forge, INT64_MIN);
+	lv2_atom_forge_float(forge, 1.5f);
+	lv2_atom_forge_double(forge, -0.125);
+	lv2_atom_forge_bool(forge, true);
+	lv2_atom_forge_urid(forge, eg_value);
+	lv2_atom_forge_string(forge, "hello", 5);
+	lv2_atom_forge_path(forge, "/tmp/x.wav", 10);
+	lv2_atom_forge_literal(forge, "bonjour", 7, 0, eg_key);
+	lv2_atom_forge_vector(forge, sizeof(float), forge->Float, 3, floats);
+	lv2_atom_forge_atom(forge, 3, eg_value);
+	lv2_atom_forge_write(forge, midi, 3);
+	lv2_atom_forge_pop(forge, &tup_frame);
+	lv2_atom_forge_property_head(forge, eg_value, eg_key);
+	lv2_atom_forge_sequence_head(forge, &beats_frame, beat_time);
+	lv2_atom_forge_beat_time(forge, 1.5);
+	lv2_atom_forge_int(forge, 7);
+	lv2_atom_forge_pop(forge, &beats_frame);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_frame_time(forge, 300);
+	lv2_atom_forge_urid(forge, eg_value);
+	lv2_atom_forge_pop(forge, &seq_frame);
+
+	// Encode it twice in a document, so the second uses the URI table
+	const LV2_Atom*  atom    = (const LV2_Atom*)buf;
+	CodecBuffer      encoded = { NULL, 0, 0, 0 };
+	LV2_Atom_Encoder encoder;
+	lv2_atom_encoder_init(&encoder, forge, &unmap, codec_sink, &encoded);
+	lv2_atom_encoder_begin(&encoder);
+	if (!lv2_atom_encoder_write(&encoder, atom)) {
+		return test_fail("Failed to encode atom\n");
+	}
+	lv2_atom_encoder_flush(&encoder);
+	const uint32_t first_size = encoded.size;
+	if (!lv2_atom_encoder_write(&encoder, atom) ||
+	    !lv2_atom_encoder_end(&encoder)) {
+		return test_fail("Failed to encode atom again\n");
+	} else if (encoded.size - first_size >= lv2_atom_total_size(atom) / 2) {
+		return test_fail("Encoded size %u is too large\n",
+		                 encoded.size - first_size);
+	}
+
+	// Decode it, reading a few bytes at a time
+	uint8_t          out[2048];
+	LV2_Atom_Decoder decoder;
+	LV2_Atom_Forge   out_forge;
+	lv2_atom_forge_init(&out_forge, &map);
+	lv2_atom_forge_set_buffer(&out_forge, out, sizeof(out));
+	encoded.chunk = 3;
+	lv2_atom_decoder_init(&decoder, &out_forge, &map, codec_source, &encoded);
+	if (!lv2_atom_decoder_begin(&decoder)) {
+		return test_fail("Failed to begin decoding\n");
+	}
+	for (unsigned i = 0; i < 2; ++i) {
+		const LV2_Atom* decoded = lv2_atom_forge_deref(
+			&out_forge, lv2_atom_decoder_read(&decoder));
+		if (!decoded) {
+			return test_fail("Failed to decode atom %u\n", i);
+		} else if (!lv2_atom_equals(atom, decoded)) {
+			return test_fail("Decoded atom %u differs from original\n", i);
+		}
+	}
+	if (!lv2_atom_decoder_at_end(&decoder)) {
+		return test_fail("Decoder did not reach end\n");
+	}
+
+	// Decode into a forge that is too small
+	encoded.offset = 0;
+	lv2_atom_forge_set_buffer(&out_forge, out, 64);
+	lv2_atom_decoder_init(&decoder, &out_forge, &map, codec_source, &encoded);
+	if (!lv2_atom_decoder_begin(&decoder)) {
+		return test_fail("Failed to begin decoding again\n");
+	} else if (lv2_atom_decoder_read(&decoder)) {
+		return test_fail("Decoded atom into insufficient space\n");
+	}
+
+	// Decode a truncated document
+	encoded.offset = 0;
+	encoded.size   = 32;
+	lv2_atom_forge_set_buffer(&out_forge, out, sizeof(out));
+	lv2_atom_decoder_init(&decoder, &out_forge, &map, codec_source, &encoded);
+	if (!lv2_atom_decoder_begin(&decoder)) {
+		return test_fail("Failed to begin decoding truncated document\n");
+	} else if (lv2_atom_decoder_read(&decoder)) {
+		return test_fail("Decoded truncated atom\n");
+	}
+
+	// Decode garbage
+	encoded.offset = 0;
+	encoded.buf[0] = 'X';
+	lv2_atom_decoder_init(&decoder, &out_forge, &map, codec_source, &encoded);
+	if (lv2_atom_decoder_begin(&decoder)) {
+		return test_fail("Began decoding document with bad header\n");
+	}
+
+	// Decode vectors of zero-size elements, and elements that do not fit
+	static const uint8_t tails[][8] = {
+		{ 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F },  // 2^32 - 1 empty elements
+		{ 0, 0x80, 0x08, 0xFF, 0xFF, 0x03 }      // 65535 1024 byte elements
+	};
+	const uint32_t vector_len = (uint32_t)strlen(LV2_ATOM__Vector);
+	uint8_t        vector_buf[64] = { 'L', 'V', '2', 'A', 1, 1, 0 };
+	vector_buf[6] = (uint8_t)vector_len;
+	memcpy(vector_buf + 7, LV2_ATOM__Vector, vector_len);
+	for (unsigned i = 0; i < 2; ++i) {
+		CodecBuffer vector = { vector_buf, 7 + vector_len + 8, 0, 64 };
+		memcpy(vector_buf + 7 + vector_len, tails[i], sizeof(tails[i]));
+		lv2_atom_decoder_init(
+			&decoder, &out_forge, &map, codec_source, &vector);
+		if (!lv2_atom_decoder_begin(&decoder)) {
+			return test_fail("Failed to begin decoding vector %u\n", i);
+		} else if (lv2_atom_decoder_read(&decoder)) {
+			return test_fail("Decoded invalid vector %u\n", i);
+		}
+	}
+
+	free(encoded.buf);
+	return 0;
+}
+
+/** Record of which handlers were called, in order. */
+typedef struct {
+	char     calls[16];
+	uint32_t n_calls;
+} DispatchLog;
+
+static void
+on_int(void* handle, const LV2_Atom_Event* ev)
+{
+	DispatchLog* log = (DispatchLog*)handle;
+	log->calls[log->n_calls++] = 'i';
+}
+
+static void
+on_eg_object(void* handle, const LV2_Atom_Event* ev)
+{
+	DispatchLog* log = (DispatchLog*)handle;
+	log->calls[log->n_calls++] = 'e';
+}
+
+static void
+on_object(void* handle, const LV2_Atom_Event* ev)
+{
+	DispatchLog* log = (DispatchLog*)handle;
+	log->calls[log->n_calls++] = 'o';
+}
+
+static void
+on_other(void* handle, const LV2_Atom_Event* ev)
+{
+	DispatchLog* log = (DispatchLog*)handle;
+	log->calls[log->n_calls++] = '?';
+}
+
+static int
+test_event_dispatch(LV2_Atom_Forge* forge)
+{
+	const LV2_URID eg_Object = urid_map(NULL, "http://example.org/Object");
+	const LV2_URID eg_Other  = urid_map(NULL, "http://example.org/Other");
+	const LV2_URID eg_Blank  = urid_map(NULL, "http://example.org/Blank");
+
+	uint8_t              buf[512];
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	lv2_atom_forge_frame_time(forge, 0);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_frame_time(forge, 1);
+	lv2_atom_forge_object(forge, &obj_frame, 0, eg_Object);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_frame_time(forge, 2);
+	lv2_atom_forge_object(forge, &obj_frame, 0, eg_Other);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_frame_time(forge, 3);
+	lv2_atom_forge_float(forge, 4.0f);
+	lv2_atom_forge_frame_time(forge, 4);
+	LV2_Atom* blank = (LV2_Atom*)lv2_atom_forge_deref(
+		forge, lv2_atom_forge_object(forge, &obj_frame, 0, eg_Object));
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_frame_time(forge, 5);
+	lv2_atom_forge_atom(forge, 0, eg_Blank);
+	lv2_atom_forge_pop(forge, &seq_frame);
+
+	// Make an object with an alias type, like a deprecated atom:Blank
+	blank->type = eg_Blank;
+
+	LV2_Atom_Dispatch dispatch;
+	lv2_atom_dispatch_init(&dispatch, forge->Object, eg_Blank, 0);
+	if (!lv2_atom_dispatch_add(&dispatch, forge->Int, 0, on_int) ||
+	    !lv2_atom_dispatch_add(&dispatch, forge->Object, eg_Object, on_eg_object) ||
+	    !lv2_atom_dispatch_add(&dispatch, forge->Object, 0, on_other) ||
+	    !lv2_atom_dispatch_add(&dispatch, forge->Object, 0, on_object)) {
+		return test_fail("Failed to add dispatch handler\n");
+	}
+	dispatch.fallback = on_other;
+
+	DispatchLog log = { { 0 }, 0 };
+	lv2_atom_dispatch_sequence(&dispatch, &log, (LV2_Atom_Sequence*)buf);
+	if (strcmp(log.calls, "ieo?e?")) {
+		return test_fail("Dispatched to \"%s\" != \"ieo?e?\"\n", log.calls);
+	}
+
+	const LV2_Atom_Dispatch_Entry* e = lv2_atom_dispatch_find(
+		&dispatch, forge->Object, eg_Object);
+	if (!e || e->count != 2) {
+		return test_fail("Bad dispatch count for eg:Object\n");
+	} else if (dispatch.n_unhandled != 2) {
+		return test_fail("Unhandled count %u != 2\n", dispatch.n_unhandled);
+	}
+
+	// Fill a table with keys that collide until it refuses more handlers
+	const uint32_t slot    = lv2_atom_dispatch_slot(forge->Int, 0);
+	uint32_t       n_added = 0;
+	uint32_t       otype   = 0;
+	lv2_atom_dispatch_init(&dispatch, forge->Object, 0, 0);
+	for (;; ++otype) {
+		const uint32_t type = forge->Int;
+		if (lv2_atom_dispatch_slot(type, otype) != slot) {
+			continue;
+		} else if (!lv2_atom_dispatch_add(&dispatch, type, otype, on_int)) {
+			break;
+		} else if (++n_added > LV2_ATOM_DISPATCH_N_SLOTS) {
+			return test_fail("Dispatch table overflowed\n");
+		}
+	}
+
+	if (n_added != LV2_ATOM_DISPATCH_N_SLOTS) {
+		return test_fail("Dispatch table full after %u handlers\n", n_added);
+	} else if (!lv2_atom_dispatch_add(&dispatch, forge->Int, 0, on_int)) {
+		return test_fail("Failed to replace handler in full table\n");
+	}
+	for (uint32_t o = 0; o < otype; ++o) {
+		if (lv2_atom_dispatch_slot(forge->Int, o) == slot &&
+		    !lv2_atom_dispatch_find(&dispatch, forge->Int, o)) {
+			return test_fail("Handler %u missing from full table\n", o);
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_hash(LV2_Atom_Forge* forge)
+{
+	const LV2_URID eg_Object = urid_map(NULL, "http://example.org/Object");
+	const LV2_URID eg_one    = urid_map(NULL, "http://example.org/one");
+	const LV2_URID eg_two    = urid_map(NULL, "http://example.org/two");
+	const LV2_URID eg_sub    = urid_map(NULL, "http://example.org/sub");
+
+	// Forge the same nested object twice with properties in different orders
+	uint8_t              bufs[2][256];
+	LV2_Atom_Forge_Frame frame;
+	LV2_Atom_Forge_Frame sub_frame;
+	for (unsigned i = 0; i < 2; ++i) {
+		lv2_atom_forge_set_buffer(forge, bufs[i], sizeof(bufs[i]));
+		lv2_atom_forge_object(forge, &frame, 0, eg_Object);
+		if (i == 0) {
+			lv2_atom_forge_key(forge, eg_one);
+			lv2_atom_forge_int(forge, 1);
+		}
+		lv2_atom_forge_key(forge, eg_sub);
+		lv2_atom_forge_object(forge, &sub_frame, 0, eg_Object);
+		lv2_atom_forge_key(forge, i ? eg_two : eg_one);
+		lv2_atom_forge_string(forge, i ? "two" : "one", 3);
+		lv2_atom_forge_key(forge, i ? eg_one : eg_two);
+		lv2_atom_forge_string(forge, i ? "one" : "two", 3);
+		lv2_atom_forge_pop(forge, &sub_frame);
+		lv2_atom_forge_key(forge, eg_two);
+		lv2_atom_forge_float(forge, 2.0f);
+		if (i == 1) {
+			lv2_atom_forge_key(forge, eg_one);
+			lv2_atom_forge_int(forge, 1);
+		}
+		lv2_atom_forge_pop(forge, &frame);
+	}
+
+	const LV2_Atom* a = (const LV2_Atom*)bufs[0];
+	const LV2_Atom* b = (const LV2_Atom*)bufs[1];
+	if (lv2_atom_hash(a, 0) != lv2_atom_hash(a, 0)) {
+		return test_fail("Hash is not deterministic\n");
+	} else if (lv2_atom_hash(a, 0) == lv2_atom_hash(a, 1)) {
+		return test_fail("Hash ignores seed\n");
+	} else if (lv2_atom_hash(a, 0) == lv2_atom_hash(b, 0)) {
+		return test_fail("Reordered objects have the same raw hash\n");
+	} else if (lv2_atom_hash_canonical(a, forge->Object, 0) !=
+	           lv2_atom_hash_canonical(b, forge->Object, 0)) {
+		return test_fail("Reordered objects have different canonical hashes\n");
+	}
+
+	// Changing any value changes the canonical hash
+	LV2_ATOM_OBJECT_FOREACH((LV2_Atom_Object*)b, p) {
+		if (p->value.type == forge->Object) {
+			LV2_Atom_Object*         sub  = (LV2_Atom_Object*)&p->value;
+			LV2_Atom_Property_Body*  prop = lv2_atom_object_begin(&sub->body);
+			((char*)LV2_ATOM_BODY(&prop->value))[0] = 'T';
+		}
+	}
+	if (lv2_atom_hash_canonical(a, forge->Object, 0) ==
+	    lv2_atom_hash_canonical(b, forge->Object, 0)) {
+		return test_fail("Changed nested value has the same canonical hash\n");
+	}
+
+	// Hashes of equal atoms are equal, and padding is not hashed
+	uint8_t buf[64];
+	for (uint32_t len = 0; len < 40; ++len) {
+		memset(buf, 0xFF, sizeof(buf));
+		lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+		lv2_atom_forge_string(forge, "abcdefghijklmnopqrstuvwxyzabcdefghijklm", len);
+		const LV2_Atom* str = (const LV2_Atom*)buf;
+		uint8_t         copy[64];
+		memset(copy, 0, sizeof(copy));
+		memcpy(copy, buf, lv2_atom_total_size(str));
+		if (!lv2_atom_equals(str, (const LV2_Atom*)copy) ||
+		    lv2_atom_hash(str, 0) != lv2_atom_hash((const LV2_Atom*)copy, 0)) {
+			return test_fail("Equal strings of length %u hash differently\n", len);
+		} else if (len > 0 &&
+		           lv2_atom_hash_bytes(LV2_ATOM_BODY_CONST(str), len, 0) ==
+		           lv2_atom_hash_bytes(LV2_ATOM_BODY_CONST(str), len - 1, 0)) {
+			return test_fail("Prefix of length %u has the same hash\n", len);
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_sorted_object(LV2_Atom_Forge* forge)
+{
+	static const uint32_t keys[]     = { 7, 3, 9, 3, 1, 5, 8, 2 };
+	static const uint32_t contexts[] = { 0, 2, 0, 1, 0, 0, 0, 0 };
+
+	// Forge an object with values of several sizes in arbitrary order
+	uint8_t              buf[512];
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, sizeof(buf));
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; i < 8; ++i) {
+		char str[16];
+		snprintf(str, sizeof(str), "%.*s", (int)(keys[i] + 1), "0123456789");
+		lv2_atom_forge_property_head(forge, keys[i], contexts[i]);
+		if (i % 2) {
+			lv2_atom_forge_string(forge, str, (uint32_t)strlen(str));
+		} else {
+			lv2_atom_forge_int(forge, (int32_t)keys[i]);
+		}
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	LV2_Atom_Object* obj = (LV2_Atom_Object*)buf;
+	uint8_t          copy[512];
+	memcpy(copy, buf, lv2_atom_total_size(&obj->atom));
+
+	// Index the unsorted object and find every key
+	uint32_t              offsets[8];
+	LV2_Atom_Object_Index index;
+	if (lv2_atom_object_index_init(&index, obj, offsets, 7)) {
+		return test_fail("Indexed object into insufficient space\n");
+	} else if (index.n_props != 7) {
+		return test_fail("Partial index has %u properties != 7\n",
+		                 index.n_props);
+	} else if (!lv2_atom_object_index_find(&index, keys[0])) {
+		return test_fail("Partial index missing first property\n");
+	} else if (!lv2_atom_object_index_init(&index, obj, offsets, 8)) {
+		return test_fail("Failed to index object\n");
+	} else if (index.sorted || lv2_atom_object_is_sorted(obj)) {
+		return test_fail("Unsorted object considered sorted\n");
+	}
+	for (uint32_t i = 0; i < 8; ++i) {
+		const LV2_Atom_Property_Body* prop = lv2_atom_object_index_find(
+			&index, keys[i]);
+		if (!prop || prop->key != keys[i]) {
+			return test_fail("Failed to find key %u\n", keys[i]);
+		} else if (keys[i] == 3 && prop->context != 1) {
+			return test_fail("Found key 3 with context %u\n", prop->context);
+		}
+	}
+	if (lv2_atom_object_index_get(&index, 0) ||
+	    lv2_atom_object_index_get(&index, 4) ||
+	    lv2_atom_object_index_get(&index, 10)) {
+		return test_fail("Found missing key\n");
+	}
+
+	// Sort the object and check every property survived intact
+	if (!lv2_atom_object_sort(obj) || !lv2_atom_object_is_sorted(obj)) {
+		return test_fail("Failed to sort object\n");
+	} else if (obj->atom.size != ((LV2_Atom*)copy)->size) {
+		return test_fail("Sorting changed object size\n");
+	}
+	uint32_t n = 0;
+	LV2_ATOM_OBJECT_FOREACH(obj, prop) {
+		++n;
+		if (prop->value.type == forge->Int) {
+			if (((const LV2_Atom_Int*)&prop->value)->body != (int32_t)prop->key) {
+				return test_fail("Corrupt value for key %u\n", prop->key);
+			}
+		} else if (prop->value.size != prop->key + 2) {
+			return test_fail("Corrupt string for key %u\n", prop->key);
+		}
+	}
+	if (n != 8) {
+		return test_fail("Sorted object has %u properties != 8\n", n);
+	}
+
+	// Forge the same properties in reverse order with a sorted pop
+	uint8_t rev[512];
+	lv2_atom_forge_set_buffer(forge, rev, sizeof(rev));
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (int i = 7; i >= 0; --i) {
+		char str[16];
+		snprintf(str, sizeof(str), "%.*s", (int)(keys[i] + 1), "0123456789");
+		lv2_atom_forge_property_head(forge, keys[i], contexts[i]);
+		if (i % 2) {
+			lv2_atom_forge_string(forge, str, (uint32_t)strlen(str));
+		} else {
+			lv2_atom_forge_int(forge, (int32_t)keys[i]);
+		}
+	}
+	if (!lv2_atom_forge_pop_sorted(forge, &frame)) {
+		return test_fail("Failed to pop sorted object\n");
+	} else if (!lv2_atom_equals(&obj->atom, (const LV2_Atom*)rev)) {
+		return test_fail("Sorted objects are not equal\n");
+	}
+
+	// A sorted object is indexed without sorting
+	if (!lv2_atom_object_index_init(&index, obj, offsets, 8) || !index.sorted) {
+		return test_fail("Sorted object not indexed as sorted\n");
+	}
+
+	// An unpadded last property can not be moved
+	LV2_Atom_Object* unpadded = (LV2_Atom_Object*)copy;
+	uint32_t         last     = 0;
+	LV2_ATOM_OBJECT_FOREACH(unpadded, prop) {
+		last = (uint32_t)((uint8_t*)prop - (uint8_t*)&unpadded->body);
+	}
+	LV2_Atom_Property_Body* last_prop = (LV2_Atom_Property_Body*)(
+		(uint8_t*)&unpadded->body + last);
+	last_prop->key       = 0;
+	unpadded->atom.size -= lv2_atom_property_size(last_prop) -
+		(uint32_t)sizeof(LV2_Atom_Property_Body) - last_prop->value.size;
+	if (lv2_atom_object_sort(unpadded)) {
+		return test_fail("Moved unpadded last property\n");
+	}
+
+	return 0;
+}
+
+/** Forge message `id` with `n` Ints in a Tuple in an Object into `ring`. */
+static bool
+write_ring_message(LV2_Atom_Ring*  ring,
+                   LV2_Atom_Forge* forge,
+                   uint32_t        id,
+                   uint32_t        n)
+{
+	LV2_Atom_Forge_Frame obj_frame;
+	LV2_Atom_Forge_Frame tup_frame;
+	lv2_atom_ring_begin(ring, forge);
+	lv2_atom_forge_object(forge, &obj_frame, 0, id);
+	lv2_atom_forge_key(forge, 1);
+	lv2_atom_forge_tuple(forge, &tup_frame);
+	for (uint32_t i = 0; i < n; ++i) {
+		lv2_atom_forge_int(forge, (int32_t)(id + i));
+	}
+	lv2_atom_forge_pop(forge, &tup_frame);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	return lv2_atom_ring_commit(ring);
+}
+
+/** Check that `msg` was written by write_ring_message(). */
+static int
+check_ring_message(LV2_Atom_Forge* forge, const LV2_Atom* msg, uint32_t id)
+{
+	const LV2_Atom_Object* obj = (const LV2_Atom_Object*)msg;
+	if (msg->type != forge->Object || obj->body.otype != id) {
+		return test_fail("Read ring message %u != %u\n", obj->body.otype, id);
+	}
+
+	const LV2_Atom_Property_Body* prop  = lv2_atom_object_begin(&obj->body);
+	const LV2_Atom*               tuple = &prop->value;
+	uint32_t                      i     = 0;
+	LV2_ATOM_TUPLE_BODY_FOREACH(LV2_ATOM_BODY_CONST(tuple), tuple->size, elem) {
+		if (((const LV2_Atom_Int*)elem)->body != (int32_t)(id + i++)) {
+			return test_fail("Corrupt element %u in ring message %u\n", i, id);
+		}
+	}
+	if (lv2_atom_total_size(msg) != 32 + 16 * i) {
+		return test_fail("Bad size of ring message %u\n", id);
+	}
+	return 0;
+}
+
+static int
+test_ring(LV2_Atom_Forge* forge)
+{
+	uint64_t      buf[32];
+	LV2_Atom_Ring ring;
+	if (lv2_atom_ring_init(&ring, buf, 8) ||
+	    lv2_atom_ring_init(&ring, buf, 24) ||
+	    !lv2_atom_ring_init(&ring, buf, sizeof(buf))) {
+		return test_fail("Bad ring size handling\n");
+	}
+
+	// Start near the end of the counter range to test wrapping counters
+	ring.write_head = ring.read_head = UINT32_MAX - 7;
+
+	if (lv2_atom_ring_peek(&ring)) {
+		return test_fail("Peeked message in empty ring\n");
+	} else if (write_ring_message(&ring, forge, 1, 30)) {
+		return test_fail("Wrote message larger than ring\n");
+	} else if (lv2_atom_ring_read_space(&ring)) {
+		return test_fail("Overflowed message is visible\n");
+	}
+
+	// Write and read messages of varying size, wrapping around many times
+	uint32_t queue[64];
+	uint32_t n_written = 0;
+	uint32_t n_read    = 0;
+	uint32_t rng       = 1;
+	for (uint32_t id = 1; id < 2000; ++id) {
+		rng = rng * 1103515245 + 12345;
+		const uint32_t n     = (rng >> 16) % 12;
+		const uint32_t size  = 32 + 16 * n;
+		const uint32_t tail  = sizeof(buf) - (ring.write_head % sizeof(buf));
+		const uint32_t space = lv2_atom_ring_write_space(&ring);
+		const bool     fits  = (size <= tail) ? size <= space
+		                                      : tail + size <= space;
+		if (write_ring_message(&ring, forge, id, n)) {
+			queue[n_written++ % 64] = id;
+		} else if (fits) {
+			return test_fail("Failed to write message with enough space\n");
+		}
+
+		// Read messages from time to time until the ring is empty
+		for (uint32_t r = (rng >> 24) % 4; r > 0; --r) {
+			const LV2_Atom* msg = lv2_atom_ring_peek(&ring);
+			if (!msg) {
+				if (n_read != n_written) {
+					return test_fail("Lost ring message\n");
+				}
+				break;
+			} else if (check_ring_message(forge, msg, queue[n_read++ % 64])) {
+				return 1;
+			}
+			lv2_atom_ring_pop(&ring);
+		}
+	}
+	if (n_written < 1000) {
+		return test_fail("Only wrote %u ring messages\n", n_written);
+	}
+
+	// Copy an existing atom into the ring
+	const LV2_Atom_Int i = { { sizeof(int32_t), forge->Int }, 42 };
+	while (lv2_atom_ring_peek(&ring)) {
+		lv2_atom_ring_pop(&ring);
+	}
+	if (!lv2_atom_ring_write(&ring, forge, &i.atom) ||
+	    !lv2_atom_equals(lv2_atom_ring_peek(&ring), &i.atom)) {
+		return test_fail("Failed to write atom to ring\n");
+	}
+
+	return 0;
+}
+
+/** Forge an object with `n` properties, each a Tuple with a string. */
+static bool
+forge_large_object(LV2_Atom_Forge* forge, uint32_t n)
+{
+	LV2_Atom_Forge_Frame obj_frame;
+	LV2_Atom_Forge_Frame tup_frame;
+	bool                 ok = lv2_atom_forge_object(forge, &obj_frame, 0, 1);
+	for (uint32_t i = 0; i < n; ++i) {
+		char str[24];
+		snprintf(str, sizeof(str), "value %u", i);
+		ok = ok && lv2_atom_forge_key(forge, n - i);
+		ok = ok && lv2_atom_forge_tuple(forge, &tup_frame);
+		ok = ok && lv2_atom_forge_string(forge, str, (uint32_t)strlen(str));
+		lv2_atom_forge_pop(forge, &tup_frame);
+	}
+	lv2_atom_forge_pop(forge, &obj_frame);
+	return ok;
+}
+
+static int
+test_arena(LV2_Atom_Forge* forge)
+{
+	uint8_t* buf = (uint8_t*)malloc(16384);
+	lv2_atom_forge_set_buffer(forge, buf, 16384);
+	if (!forge_large_object(forge, 300)) {
+		free(buf);
+		return test_fail("Failed to forge large object\n");
+	}
+
+	// Build the same object in an arena that must grow many times
+	LV2_Atom_Arena arena;
+	if (!lv2_atom_arena_init(&arena, 0) || lv2_atom_arena_get(&arena)) {
+		free(buf);
+		return test_fail("Failed to initialise arena\n");
+	}
+	lv2_atom_arena_begin(&arena, forge);
+	forge_large_object(forge, 300);
+	if (!lv2_atom_arena_get(&arena) ||
+	    !lv2_atom_equals(lv2_atom_arena_get(&arena), (const LV2_Atom*)buf)) {
+		lv2_atom_arena_free(&arena);
+		free(buf);
+		return test_fail("Arena object differs from buffer object\n");
+	}
+
+	// Reuse the arena, which does not reallocate for a smaller atom
+	const uint8_t* const arena_buf = arena.buf;
+	lv2_atom_arena_begin(&arena, forge);
+	lv2_atom_forge_int(forge, 42);
+	const LV2_Atom* atom = lv2_atom_arena_get(&arena);
+	if (arena.buf != arena_buf || !atom || atom->type != forge->Int) {
+		lv2_atom_arena_free(&arena);
+		free(buf);
+		return test_fail("Failed to reuse arena\n");
+	}
+
+	// Sorting needs the finished object to be dereferenced
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_arena_begin(&arena, forge);
+	lv2_atom_forge_object(forge, &frame, 0, 1);
+	for (uint32_t i = 0; i < 100; ++i) {
+		lv2_atom_forge_key(forge, 100 - i);
+		lv2_atom_forge_long(forge, i);
+	}
+	if (!lv2_atom_forge_pop_sorted(forge, &frame) ||
+	    !lv2_atom_object_is_sorted(
+		    (const LV2_Atom_Object*)lv2_atom_arena_get(&arena))) {
+		lv2_atom_arena_free(&arena);
+		free(buf);
+		return test_fail("Failed to sort object in arena\n");
+	}
+
+	lv2_atom_arena_free(&arena);
+	free(buf);
+	return 0;
+}
+
+/** Forge an event with an object with `n` floats, rolling back on overflow. */
+static bool
+forge_event_or_rollback(LV2_Atom_Forge* forge, int64_t time, uint32_t n)
+{
+	const LV2_Atom_Forge_Checkpoint checkpoint = lv2_atom_forge_checkpoint(forge);
+	LV2_Atom_Forge_Frame            frame;
+	bool                            ok = false;
+	if (lv2_atom_forge_frame_time(forge, time) &&
+	    lv2_atom_forge_object(forge, &frame, 0, 1)) {
+		ok = true;
+		for (uint32_t i = 0; ok && i < n; ++i) {
+			ok = (lv2_atom_forge_key(forge, i + 1) &&
+			      lv2_atom_forge_float(forge, (float)i));
+		}
+	}
+	if (ok) {
+		lv2_atom_forge_pop(forge, &frame);
+	} else {
+		lv2_atom_forge_rollback(forge, &checkpoint);
+	}
+	return ok;
+}
+
+static int
+test_checkpoint(LV2_Atom_Forge* forge)
+{
+	/* Fill a sequence with events of 1 to 8 properties (48 to 216 bytes) until
+	   it is full, for every buffer size in a range, checking it is valid. */
+	uint64_t buf[64];
+	for (uint32_t size = 16; size <= sizeof(buf); size += 8) {
+		memset(buf, 0xFF, sizeof(buf));
+
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, size);
+		lv2_atom_forge_sequence_head(forge, &frame, 0);
+
+		uint32_t n_events = 0;
+		for (uint32_t i = 0; i < 16; ++i) {
+			n_events += forge_event_or_rollback(forge, i, i % 8 + 1);
+		}
+		lv2_atom_forge_pop(forge, &frame);
+
+		const LV2_Atom_Sequence* seq = (const LV2_Atom_Sequence*)buf;
+		if (lv2_atom_total_size(&seq->atom) != forge->offset) {
+			return test_fail("Sequence size %u != offset %u\n",
+			                 lv2_atom_total_size(&seq->atom), forge->offset);
+		} else if (!lv2_atom_sequence_validate(forge, seq, size)) {
+			return test_fail("Invalid sequence in %u byte buffer\n", size);
+		}
+
+		uint32_t n = 0;
+		LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+			const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
+			const uint32_t n_props = (uint32_t)ev->time.frames % 8 + 1;
+			if (obj->atom.size != sizeof(LV2_Atom_Object_Body) + 24 * n_props) {
+				return test_fail("Event at %ld is truncated\n",
+				                 (long)ev->time.frames);
+			}
+			++n;
+		}
+		if (n != n_events) {
+			return test_fail("Sequence has %u events != %u\n", n, n_events);
+		} else if (size >= 80 && !n) {
+			return test_fail("No events in %u byte buffer\n", size);
+		}
+	}
+
+	return 0;
+}
+
+/** Forge an object with an Int and a Float vector in a sequence event. */
+static bool
+forge_vector_event(LV2_Atom_Forge* forge,
+                   bool            reserve,
+                   uint32_t        n_reserved,
+                   uint32_t        n_elems)
+{
+	LV2_Atom_Forge_Frame seq_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+	lv2_atom_forge_frame_time(forge, 0);
+	lv2_atom_forge_object(forge, &obj_frame, 0, 0);
+	lv2_atom_forge_key(forge, 1);
+	lv2_atom_forge_int(forge, 42);
+	lv2_atom_forge_key(forge, 2);
+
+	bool ok = true;
+	if (reserve) {
+		LV2_Atom_Forge_Frame vec_frame;
+		float* const         elems = (float*)lv2_atom_forge_vector_reserve(
+			forge, &vec_frame, sizeof(float), forge->Float, n_reserved);
+		if ((ok = elems)) {
+			for (uint32_t i = 0; i < n_elems; ++i) {
+				elems[i] = (float)i;
+			}
+			ok = lv2_atom_forge_vector_commit(forge, &vec_frame, n_elems);
+		}
+	} else {
+		float elems[16];
+		for (uint32_t i = 0; i < n_elems; ++i) {
+			elems[i] = (float)i;
+		}
+		ok = lv2_atom_forge_vector(
+			forge, sizeof(float), forge->Float, n_elems, elems);
+	}
+
+	lv2_atom_forge_key(forge, 3);
+	lv2_atom_forge_int(forge, 43);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_pop(forge, &seq_frame);
+	return ok;
+}
+
+static int
+test_vector_reserve(LV2_Atom_Forge* forge)
+{
+	uint8_t copied[256];
+	uint8_t filled[256];
+
+	// Reserving and filling is identical to copying, for any amount of shrink
+	for (uint32_t n = 0; n <= 16; ++n) {
+		memset(copied, 0xFF, sizeof(copied));
+		memset(filled, 0xFF, sizeof(filled));
+		lv2_atom_forge_set_buffer(forge, copied, sizeof(copied));
+		forge_vector_event(forge, false, 0, n);
+		const uint32_t copied_size = forge->offset;
+
+		lv2_atom_forge_set_buffer(forge, filled, sizeof(filled));
+		if (!forge_vector_event(forge, true, 16, n)) {
+			return test_fail("Failed to reserve vector of %u\n", n);
+		} else if (forge->offset != copied_size ||
+		           memcmp(copied, filled, copied_size)) {
+			return test_fail("Filled vector of %u differs from copy\n", n);
+		}
+	}
+
+	// The vector with padding must fit, or nothing is written
+	for (uint32_t size = 16; size <= 48; size += 8) {
+		LV2_Atom_Forge_Frame frame;
+		lv2_atom_forge_set_buffer(forge, filled, size);
+		const bool fits = lv2_atom_forge_vector_reserve(
+			forge, &frame, sizeof(float), forge->Float, 3);
+		if (fits != (size >= 32)) {
+			return test_fail("Reserve in %u bytes %s\n",
+			                 size, fits ? "succeeded" : "failed");
+		} else if (fits) {
+			lv2_atom_forge_vector_commit(forge, &frame, 3);
+		}
+		if (forge->offset != (fits ? 32 : 0) || forge->stack) {
+			return test_fail("Bad output after reserve in %u bytes\n", size);
+		}
+	}
+
+	// Compute the minimum and maximum of each block of a signal in place
+	float signal[64];
+	for (uint32_t i = 0; i < 64; ++i) {
+		signal[i] = (float)((i * 7) % 16) - 8.0f;
+	}
+
+	LV2_Atom_Forge_Frame peaks_frame;
+	lv2_atom_forge_set_buffer(forge, filled, sizeof(filled));
+	float* const peaks = (float*)lv2_atom_forge_vector_reserve(
+		forge, &peaks_frame, sizeof(float), forge->Float, 64 / 16 * 2);
+	if (!peaks) {
+		return test_fail("Failed to reserve peaks\n");
+	}
+	uint32_t n_peaks = 0;
+	for (uint32_t b = 0; b < 64; b += 16) {
+		float lo = signal[b];
+		float hi = signal[b];
+		for (uint32_t i = b + 1; i < b + 16; ++i) {
+			lo = signal[i] < lo ? signal[i] : lo;
+			hi = signal[i] > hi ? signal[i] : hi;
+		}
+		peaks[n_peaks++] = lo;
+		peaks[n_peaks++] = hi;
+	}
+	lv2_atom_forge_vector_commit(forge, &peaks_frame, n_peaks);
+
+	const LV2_Atom_Vector* peaks_vec = (const LV2_Atom_Vector*)filled;
+	const float*           got       = (const float*)(peaks_vec + 1);
+	if (peaks_vec->atom.size != sizeof(LV2_Atom_Vector_Body) + 8 * 4) {
+		return test_fail("Peaks vector has size %u\n", peaks_vec->atom.size);
+	}
+	for (uint32_t i = 0; i < 8; ++i) {
+		if (got[i] != (i % 2 ? 7.0f : -8.0f)) {
+			return test_fail("Peak %u is %f\n", i, (double)got[i]);
+		}
+	}
+
+	// Reserving is not possible with a sink
+	LV2_Atom_Arena       arena;
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_arena_init(&arena, 0);
+	lv2_atom_arena_begin(&arena, forge);
+	void* const elems = lv2_atom_forge_vector_reserve(
+		forge, &frame, sizeof(float), forge->Float, 4);
+	const bool written = lv2_atom_arena_get(&arena);
+	lv2_atom_arena_free(&arena);
+	if (elems || written) {
+		return test_fail("Reserved vector in sink\n");
+	}
+
+	return 0;
+}
+
+/** Forge a sequence of events with pseudo-random times and varying sizes. */
+static bool
+forge_unsorted_sequence(LV2_Atom_Forge* forge,
+                        uint32_t        unit,
+                        uint32_t        n_events)
+{
+	int32_t              elems[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint32_t             rand     = 1;
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_sequence_head(forge, &frame, unit);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		rand = rand * 1103515245 + 12345;
+		const uint32_t time = (rand >> 16) % 16;  // Many equal times
+		if (unit) {
+			lv2_atom_forge_beat_time(forge, time / 4.0);
+		} else {
+			lv2_atom_forge_frame_time(forge, time);
+		}
+		elems[0] = (int32_t)i;
+		lv2_atom_forge_vector(
+			forge, sizeof(int32_t), forge->Int, i % 8 + 1, elems);
+	}
+	return lv2_atom_forge_pop_sequence_sorted(forge, &frame, unit);
+}
+
+/** Check that a sequence has all (less than 64) events in order. */
+static int
+check_sorted_sequence(const LV2_Atom_Sequence* seq,
+                      uint32_t                 unit,
+                      uint32_t                 n_events)
+{
+	uint32_t              n    = 0;
+	uint64_t              seen = 0;
+	const LV2_Atom_Event* prev = NULL;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		const LV2_Atom_Vector* vec = (const LV2_Atom_Vector*)&ev->body;
+		const int32_t          i   = *(const int32_t*)(vec + 1);
+		if (vec->atom.size != sizeof(LV2_Atom_Vector_Body) + 4 * (i % 8 + 1)) {
+			return test_fail("Corrupt event %d after sort\n", i);
+		} else if (prev) {
+			const LV2_Atom_Vector* pvec = (const LV2_Atom_Vector*)&prev->body;
+			const int32_t          pi   = *(const int32_t*)(pvec + 1);
+			const bool             tie  = unit
+				? prev->time.beats == ev->time.beats
+				: prev->time.frames == ev->time.frames;
+			if (lv2_atom_event_is_before(ev, prev, unit != 0) ||
+			    (tie && pi > i)) {
+				return test_fail("Event %d out of order after %d\n", i, pi);
+			}
+		}
+		seen |= (uint64_t)1 << i;
+		prev = ev;
+		++n;
+	}
+	if (n != n_events) {
+		return test_fail("Sorted sequence has %u events != %u\n", n, n_events);
+	} else if (seen != ((uint64_t)1 << n_events) - 1) {
+		return test_fail("Events lost in sort\n");
+	}
+	return 0;
+}
+
+static int
+test_sequence_sort(LV2_Atom_Forge* forge)
+{
+	static const uint32_t beat_time = 1000;
+
+	uint64_t buf[1024];
+	for (uint32_t unit = 0; unit <= beat_time; unit += beat_time) {
+		for (uint32_t n_events = 0; n_events <= 48; n_events += 6) {
+			// Sort with the index, using the rest of the buffer
+			lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+			if (!forge_unsorted_sequence(forge, unit, n_events) ||
+			    check_sorted_sequence(
+				    (const LV2_Atom_Sequence*)buf, unit, n_events)) {
+				return test_fail("Failed to sort %u events\n", n_events);
+			}
+
+			// Sort in place, with a buffer exactly large enough for the events
+			const uint32_t size = forge->offset;
+			lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, size);
+			if (!forge_unsorted_sequence(forge, unit, n_events) ||
+			    forge->offset != size ||
+			    check_sorted_sequence(
+				    (const LV2_Atom_Sequence*)buf, unit, n_events)) {
+				return test_fail("Failed to sort %u events in place\n",
+				                 n_events);
+			}
+		}
+	}
+
+	// An unpadded last event can not be moved
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	lv2_atom_forge_frame_time(forge, 2);
+	lv2_atom_forge_int(forge, 2);
+	lv2_atom_forge_frame_time(forge, 1);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_pop(forge, &frame);
+
+	LV2_Atom_Sequence* seq = (LV2_Atom_Sequence*)buf;
+	seq->atom.size -= 4;
+	if (lv2_atom_sequence_sort(seq, 0, buf + 64, 512) ||
+	    lv2_atom_sequence_sort(seq, 0, NULL, 0)) {
+		return test_fail("Moved unpadded last event\n");
+	}
+
+	seq->atom.size += 4;
+	if (lv2_atom_sequence_sort_scratch_size(seq) != 8 + 48 ||
+	    !lv2_atom_sequence_sort(seq, 0, buf + 64, 56) ||
+	    !lv2_atom_sequence_is_sorted(seq, 0)) {
+		return test_fail("Failed to sort with minimal scratch space\n");
+	}
+
+	return 0;
+}
+
+/** Forge a tuple with an object with an Int, a Float, and a path last. */
+static void
+forge_template_message(LV2_Atom_Forge*    forge,
+                       LV2_Atom_Template* tmpl,
+                       int32_t            i,
+                       float              f,
+                       const char*        path)
+{
+	LV2_Atom_Forge_Frame tup_frame;
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_tuple(forge, &tup_frame);
+	lv2_atom_forge_object(forge, &obj_frame, 0, 1);
+	lv2_atom_forge_key(forge, 2);
+	const LV2_Atom_Forge_Ref i_ref = lv2_atom_forge_int(forge, i);
+	lv2_atom_forge_key(forge, 3);
+	const LV2_Atom_Forge_Ref f_ref = lv2_atom_forge_float(forge, f);
+	lv2_atom_forge_key(forge, 4);
+	if (tmpl) {
+		lv2_atom_template_field(tmpl, i_ref);
+		lv2_atom_template_field(tmpl, f_ref);
+		lv2_atom_template_mark_tail(tmpl, forge);
+	}
+	lv2_atom_forge_path(forge, path, (uint32_t)strlen(path));
+	lv2_atom_forge_pop(forge, &obj_frame);
+	lv2_atom_forge_pop(forge, &tup_frame);
+}
+
+static int
+test_template(LV2_Atom_Forge* forge)
+{
+	// Build a template, and check the fields are where the values are
+	LV2_Atom_Template tmpl;
+	if (!lv2_atom_template_begin(&tmpl, forge)) {
+		return test_fail("Failed to begin template\n");
+	}
+	forge_template_message(forge, &tmpl, 0, 0.0f, "/tmp");
+	const LV2_Atom* const atom = lv2_atom_template_end(&tmpl);
+	const uint32_t i_field = 8 + 16 + 8 + 8;  // Tuple, object, key, atom
+	const uint32_t f_field = i_field + 8 + 8 + 8;
+	if (!atom || tmpl.n_parents != 2 || tmpl.tail != f_field + 8 + 8) {
+		lv2_atom_template_free(&tmpl);
+		return test_fail("Failed to build template\n");
+	}
+
+	uint64_t expected[64];
+	uint64_t buf[64];
+	static const char* const paths[] = {
+		"", "/", "/tmp", "/tmp/foo", "/tmp/foo.wav",
+		"/home/user/very/long/path/to/a/sample/file.wav"
+	};
+	for (unsigned p = 0; p < sizeof(paths) / sizeof(paths[0]); ++p) {
+		// Write the message with the forge for reference
+		memset(expected, 0xFF, sizeof(expected));
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)expected, sizeof(expected));
+		forge_template_message(forge, NULL, (int32_t)p, p / 2.0f, paths[p]);
+		const uint32_t size = forge->offset;
+
+		// Write it from the template
+		memset(buf, 0xFF, sizeof(buf));
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+		LV2_Atom* msg = lv2_atom_template_write_tail(
+			&tmpl, forge, paths[p], (uint32_t)strlen(paths[p]) + 1);
+		if (!msg) {
+			lv2_atom_template_free(&tmpl);
+			return test_fail("Failed to write template with tail %u\n", p);
+		}
+		lv2_atom_template_set_int(msg, i_field, (int32_t)p);
+		lv2_atom_template_set_float(msg, f_field, p / 2.0f);
+		if (forge->offset != size || memcmp(expected, buf, size)) {
+			lv2_atom_template_free(&tmpl);
+			return test_fail("Template with tail %u differs from forged\n", p);
+		}
+
+		// Writing to a buffer that is too small writes nothing
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, size - 8);
+		if (lv2_atom_template_write_tail(
+			    &tmpl, forge, paths[p], (uint32_t)strlen(paths[p]) + 1) ||
+		    forge->offset) {
+			lv2_atom_template_free(&tmpl);
+			return test_fail("Wrote template to small buffer\n");
+		}
+
+		// Writing into a sequence where only the head fits rolls it back
+		LV2_Atom_Forge_Frame seq_frame;
+		lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, 24 + size - 8);
+		lv2_atom_forge_sequence_head(forge, &seq_frame, 0);
+		lv2_atom_forge_frame_time(forge, 0);
+		const uint32_t seq_size = ((LV2_Atom*)buf)->size;
+		const uint32_t offset   = forge->offset;
+		if (lv2_atom_template_write_tail(
+			    &tmpl, forge, paths[p], (uint32_t)strlen(paths[p]) + 1) ||
+		    forge->offset != offset || ((LV2_Atom*)buf)->size != seq_size) {
+			lv2_atom_template_free(&tmpl);
+			return test_fail("Partial template left in sequence\n");
+		}
+		lv2_atom_forge_pop(forge, &seq_frame);
+	}
+
+	// Write the template as it was built, within a sequence
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	lv2_atom_forge_frame_time(forge, 0);
+	LV2_Atom* const msg = lv2_atom_template_write(&tmpl, forge);
+	lv2_atom_forge_pop(forge, &frame);
+	if (!msg || !lv2_atom_equals(msg, atom) ||
+	    ((LV2_Atom_Sequence*)buf)->atom.size != 8 + 8 + 8 + atom->size) {
+		lv2_atom_template_free(&tmpl);
+		return test_fail("Incorrect template copy\n");
+	}
+	lv2_atom_template_free(&tmpl);
+	if (lv2_atom_template_write(&tmpl, forge)) {
+		return test_fail("Wrote freed template\n");
+	}
+
+	// A tail must be at the end of the message
+	lv2_atom_template_begin(&tmpl, forge);
+	LV2_Atom_Forge_Frame obj_frame;
+	lv2_atom_forge_object(forge, &obj_frame, 0, 1);
+	lv2_atom_forge_key(forge, 2);
+	lv2_atom_template_mark_tail(&tmpl, forge);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_key(forge, 3);
+	lv2_atom_forge_int(forge, 2);
+	lv2_atom_forge_pop(forge, &obj_frame);
+	const LV2_Atom* const bad = lv2_atom_template_end(&tmpl);
+	lv2_atom_template_free(&tmpl);
+	if (bad) {
+		return test_fail("Built template with tail in the middle\n");
+	}
+
+	return 0;
+}
+
+static int
+test_fanout(LV2_Atom_Forge* forge)
+{
+	static const uint32_t sizes[] = { 512, 512, 128 };
+
+	uint64_t               msg_buf[16];
+	uint64_t               expected[64];
+	uint64_t               bufs[3][64];
+	LV2_Atom_Forge         forges[3];
+	LV2_Atom_Forge_Frame   frames[3];
+	LV2_Atom_Fanout_Target targets[3];
+	for (unsigned i = 0; i < 3; ++i) {
+		forges[i] = *forge;
+		lv2_atom_forge_set_buffer(&forges[i], (uint8_t*)bufs[i], sizes[i]);
+		lv2_atom_forge_sequence_head(&forges[i], &frames[i], 0);
+		targets[i].forge    = &forges[i];
+		targets[i].overflow = false;
+	}
+
+	// A target that forges to a sink can not be rolled back
+	LV2_Atom_Fanout        fanout;
+	LV2_Atom_Forge         sink_forge  = *forge;
+	LV2_Atom_Fanout_Target sink_target = { &sink_forge, false };
+	lv2_atom_forge_set_sink(
+		&sink_forge, lv2_atom_fanout_sink, lv2_atom_fanout_deref, &fanout);
+	if (lv2_atom_fanout_init(&fanout, msg_buf, sizeof(msg_buf),
+	                         &sink_target, 1)) {
+		return test_fail("Initialised fanout with a sink target\n");
+	} else if (!lv2_atom_fanout_init(&fanout, msg_buf, sizeof(msg_buf),
+	                                 targets, 3)) {
+		return test_fail("Failed to initialise fanout\n");
+	}
+
+	// Write the same events with the forge for reference
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, (uint8_t*)expected, sizeof(expected));
+	lv2_atom_forge_sequence_head(forge, &frame, 0);
+	for (int32_t i = 0; i < 4; ++i) {
+		lv2_atom_forge_frame_time(forge, i);
+		forge_template_message(forge, NULL, i, i / 2.0f, "/tmp");
+	}
+	lv2_atom_forge_pop(forge, &frame);
+
+	// Send events to all targets, where only one fits in the last
+	LV2_Atom_Forge msg_forge = *forge;
+	lv2_atom_fanout_begin(&fanout, &msg_forge);
+	for (int32_t i = 0; i < 4; ++i) {
+		forge_template_message(&msg_forge, NULL, i, i / 2.0f, "/tmp");
+		const uint32_t n_written = lv2_atom_fanout_commit(&fanout, i);
+		if (n_written != (i ? 2u : 3u) || fanout.dropped) {
+			return test_fail("Event %d written to %u targets\n", i, n_written);
+		}
+	}
+
+	// Send an event which overflows the fanout, which is written nowhere
+	forge_template_message(
+		&msg_forge, NULL, 4, 2.0f,
+		"/home/user/a/path/which/is/too/long/to/fit/in/the/fanout/buffer.wav");
+	if (lv2_atom_fanout_commit(&fanout, 4) || !fanout.dropped) {
+		return test_fail("Wrote overflowed fanout message\n");
+	}
+
+	for (unsigned i = 0; i < 3; ++i) {
+		lv2_atom_forge_pop(&forges[i], &frames[i]);
+	}
+
+	const LV2_Atom_Sequence* const seq = (const LV2_Atom_Sequence*)expected;
+	const uint32_t                 size = lv2_atom_total_size(&seq->atom);
+	if (targets[0].overflow || targets[1].overflow || !targets[2].overflow) {
+		return test_fail("Target overflow reported incorrectly\n");
+	} else if (memcmp(bufs[0], expected, size) ||
+	           memcmp(bufs[1], expected, size)) {
+		return test_fail("Fanout output differs from forged\n");
+	}
+
+	// The last target has only the first event, and is still valid
+	const LV2_Atom_Sequence* const small = (const LV2_Atom_Sequence*)bufs[2];
+	const LV2_Atom_Event* const    first = lv2_atom_sequence_begin(&seq->body);
+	const uint32_t first_size = (uint32_t)sizeof(LV2_Atom_Event) +
+		lv2_atom_pad_size(first->body.size);
+	if (!lv2_atom_sequence_validate(forge, small, sizes[2]) ||
+	    small->atom.size != sizeof(LV2_Atom_Sequence_Body) + first_size ||
+	    memcmp(small + 1, first, first_size)) {
+		return test_fail("Incorrect output in small target\n");
+	}
+
+	return 0;
+}
+
+/** Return true iff `a` and `b` are equal, apart from rounding error. */
+static bool
+approx_equals(double a, double b)
+{
+	return a - b < 1e-9 && b - a < 1e-9;
+}
+
+static int
+test_tempo_map(LV2_Atom_Forge* forge)
+{
+	// 120 BPM at 48 kHz is 24000 frames per beat, then 60 BPM from beat 2
+	LV2_Atom_Tempo_Segment segments[2];
+	LV2_Atom_Tempo_Map     map;
+	lv2_atom_tempo_map_init(&map, segments, 2, 48000.0);
+	if (lv2_atom_tempo_map_set_tempo(&map, 0, 60.0)) {
+		return test_fail("Changed tempo of empty map\n");
+	} else if (!lv2_atom_tempo_map_reset(&map, 0, 0.0, 120.0) ||
+	           !lv2_atom_tempo_map_set_tempo(&map, 48000, 90.0) ||
+	           !lv2_atom_tempo_map_set_tempo(&map, 48000, 60.0) ||
+	           map.n_segments != 2) {
+		return test_fail("Failed to build tempo map\n");
+	} else if (lv2_atom_tempo_map_set_tempo(&map, 24000, 60.0) ||
+	           lv2_atom_tempo_map_set_tempo(&map, 96000, 120.0) ||
+	           lv2_atom_tempo_map_set_tempo(&map, 48000, 0.0)) {
+		return test_fail("Accepted invalid tempo change\n");
+	}
+
+	static const int64_t frames[] = { -24000, 0, 12000, 48000, 72000, 96000 };
+	static const double  beats[]  = { -1.0, 0.0, 0.5, 2.0, 2.5, 3.0 };
+	for (unsigned i = 0; i < sizeof(frames) / sizeof(frames[0]); ++i) {
+		const double  b = lv2_atom_tempo_map_frames_to_beats(&map, frames[i]);
+		const int64_t f = lv2_atom_tempo_map_beats_to_frames(&map, beats[i]);
+		if (!approx_equals(b, beats[i]) || f != frames[i]) {
+			return test_fail("Frame %ld is beat %f and beat %f is frame %ld\n",
+			                 (long)frames[i], b, beats[i], (long)f);
+		}
+	}
+
+	// Beats between frames are rounded to the nearest frame
+	if (lv2_atom_tempo_map_beats_to_frames(&map, 0.5 + 0.4 / 24000) != 12000 ||
+	    lv2_atom_tempo_map_beats_to_frames(&map, 0.5 + 0.6 / 24000) != 12001 ||
+	    lv2_atom_tempo_map_beats_to_frames(&map, -0.6 / 24000) != -1) {
+		return test_fail("Incorrect rounding of beats to frames\n");
+	}
+
+	// Write events at frames to a sequence in beats
+	uint64_t             buf[16];
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, (uint8_t*)buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(forge, &frame, 1);
+	lv2_atom_forge_event_time(forge, &map, 72000);
+	lv2_atom_forge_int(forge, 1);
+	lv2_atom_forge_event_time(forge, NULL, 4);
+	lv2_atom_forge_int(forge, 2);
+	lv2_atom_forge_pop(forge, &frame);
+
+	const LV2_Atom_Sequence* const seq   = (const LV2_Atom_Sequence*)buf;
+	const LV2_Atom_Event* const    first = lv2_atom_sequence_begin(&seq->body);
+	const LV2_Atom_Event* const    last  = lv2_atom_sequence_next(first);
+	if (!approx_equals(first->time.beats, 2.5) || last->time.frames != 4) {
+		return test_fail("Incorrect event time stamps\n");
+	}
+
+	// Send a message to a sequence in beats with a fanout
+	uint64_t               msg_buf[4];
+	LV2_Atom_Forge         out_forge = *forge;
+	LV2_Atom_Fanout_Target target    = { &out_forge, false };
+	LV2_Atom_Fanout        fanout;
+	lv2_atom_forge_set_buffer(&out_forge, (uint8_t*)buf, sizeof(buf));
+	lv2_atom_forge_sequence_head(&out_forge, &frame, 1);
+	lv2_atom_fanout_init(&fanout, msg_buf, sizeof(msg_buf), &target, 1);
+	lv2_atom_fanout_begin(&fanout, forge);
+	lv2_atom_forge_int(forge, 3);
+	if (lv2_atom_fanout_commit_beats(&fanout, 1.5) != 1 ||
+	    first->time.beats != 1.5 || first->body.type != forge->Int) {
+		return test_fail("Incorrect fanout event in beats\n");
+	}
+	lv2_atom_forge_pop(&out_forge, &frame);
+
+	return 0;
+}
+
+/** Forge a sequence of Int events with the given times in beats. */
+static LV2_Atom_Sequence*
+forge_beat_sequence(LV2_Atom_Forge* forge,
+                    uint8_t*        buf,
+                    uint32_t        size,
+                    uint32_t        beat_time,
+                    uint32_t        n_events,
+                    const double*   beats,
+                    const int32_t*  values)
+{
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_forge_set_buffer(forge, buf, size);
+	lv2_atom_forge_sequence_head(forge, &frame, beat_time);
+	for (uint32_t i = 0; i < n_events; ++i) {
+		lv2_atom_forge_beat_time(forge, beats[i]);
+		lv2_atom_forge_int(forge, values[i]);
+	}
+	lv2_atom_forge_pop(forge, &frame);
+	return (LV2_Atom_Sequence*)buf;
+}
+
+static int
+test_sequence_slicer_beats(LV2_Atom_Forge* forge)
+{
+	// The same events as test_sequence_slicer, at 64 frames per beat
+	static const double  beats[]  = { 0.0, 0.0, 10 / 64.0, 12 / 64.0, 70 / 64.0 };
+	static const int32_t values[] = { 1, 2, 3, 4, 5 };
+
+	uint8_t                  buf[512];
+	const LV2_Atom_Sequence* seq = forge_beat_sequence(
+		forge, buf, sizeof(buf), 1, 5, beats, values);
+
+	LV2_Atom_Tempo_Segment segments[2];
+	LV2_Atom_Tempo_Map     map;
+	lv2_atom_tempo_map_init(&map, segments, 2, 480.0);
+	lv2_atom_tempo_map_reset(&map, 0, 0.0, 450.0);
+
+	LV2_Atom_Slice  slice;
+	LV2_Atom_Slicer slicer;
+	lv2_atom_slicer_init(&slicer, seq, 64, 0);
+	lv2_atom_slicer_set_tempo(&slicer, &map);
+	if (check_slice(&slicer, 0, 10, 2, 1) ||
+	    check_slice(&slicer, 10, 12, 1, 3) ||
+	    check_slice(&slicer, 12, 64, 1, 4) ||
+	    check_slice(&slicer, 64, 64, 1, 5)) {
+		return 1;
+	} else if (lv2_atom_slicer_next(&slicer, &slice)) {
+		return test_fail("Slicer did not end\n");
+	}
+
+	// Double the tempo at frame 10 while slicing, so later events are earlier
+	lv2_atom_slicer_init(&slicer, seq, 64, 0);
+	lv2_atom_slicer_set_tempo(&slicer, &map);
+	if (check_slice(&slicer, 0, 10, 2, 1)) {
+		return 1;
+	}
+	lv2_atom_tempo_map_set_tempo(&map, 10, 900.0);
+	if (check_slice(&slicer, 10, 11, 1, 3) ||
+	    check_slice(&slicer, 11, 40, 1, 4) ||
+	    check_slice(&slicer, 40, 64, 1, 5)) {
+		return 1;
+	} else if (lv2_atom_slicer_next(&slicer, &slice)) {
+		return test_fail("Slicer did not end\n");
+	}
+
+	return 0;
+}
+
+static int
+test_sequence_merge_tempo(LV2_Atom_Forge* forge)
+{
+	static const uint32_t beat_time  = 1;
+	static const int64_t  a_times[]  = { 0, 16, 40 };
+	static const int32_t  a_values[] = { 1, 2, 3 };
+	static const double   b_beats[]  = { 0.125, 0.25, 1.0 };
+	static const int32_t  b_values[] = { 11, 12, 13 };
+
+	uint8_t a_buf[256];
+	uint8_t b_buf[256];
+	uint8_t out_buf[512];
+
+	const LV2_Atom_Sequence* inputs[] = {
+		forge_int_sequence(forge, a_buf, sizeof(a_buf), 3, a_times, a_values),
+		forge_beat_sequence(forge, b_buf, sizeof(b_buf), beat_time,
+		                    3, b_beats, b_values)
+	};
+
+	// 64 frames per beat
+	LV2_Atom_Tempo_Segment segment;
+	LV2_Atom_Tempo_Map     map;
+	lv2_atom_tempo_map_init(&map, &segment, 1, 480.0);
+	lv2_atom_tempo_map_reset(&map, 0, 0.0, 450.0);
+
+	LV2_Atom_Sequence* out = (LV2_Atom_Sequence*)out_buf;
+	out->atom.type = forge->Sequence;
+	out->body.unit = 0;
+	out->body.pad  = 0;
+	lv2_atom_sequence_clear(out);
+
+	const uint32_t capacity = sizeof(out_buf) - sizeof(LV2_Atom);
+	if (lv2_atom_sequence_merge(out, capacity, 2, inputs, beat_time)) {
+		return test_fail("Merged sequences with different units\n");
+	}
+
+	// Merge into frames
+	static const int64_t times[]  = { 0, 8, 16, 16, 40, 64 };
+	static const int32_t values[] = { 1, 11, 2, 12, 3, 13 };
+	lv2_atom_sequence_clear(out);
+	if (!lv2_atom_sequence_merge_tempo(
+		    out, capacity, 2, inputs, beat_time, &map)) {
+		return test_fail("Failed to merge sequences into frames\n");
+	} else if (check_int_sequence(out, 6, times, values)) {
+		return 1;
+	}
+
+	// Merge into beats
+	out->body.unit = beat_time;
+	lv2_atom_sequence_clear(out);
+	if (!lv2_atom_sequence_merge_tempo(
+		    out, capacity, 2, inputs, beat_time, &map)) {
+		return test_fail("Failed to merge sequences into beats\n");
+	}
+
+	uint32_t n = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(out, ev) {
+		const int32_t value = ((const LV2_Atom_Int*)&ev->body)->body;
+		if (n >= 6 || ev->time.beats != times[n] / 64.0 || value != values[n]) {
+			return test_fail("Incorrect event %u in merged beat sequence\n", n);
+		}
+		++n;
+	}
+	if (n != 6) {
+		return test_fail("Merged beat sequence has %u events != 6\n", n);
+	}
+
+	return 0;
+}
+
 int
 main(void)
 {
@@ -392,6 +2313,55 @@ main(void)
 		                                0);
 	}
 
+	// Test compiled query plans
+	const uint32_t plan_keys[] = { eg_seq, eg_one, eg_string, eg_Object };
+	LV2_Atom_Object_Plan plan;
+	if (!lv2_atom_object_plan_init(&plan, 4, plan_keys)) {
+		return test_fail("Failed to initialise query plan\n");
+	}
+
+	const LV2_Atom* plan_values[4];
+	n_matches = lv2_atom_object_plan_query(
+		&plan, (LV2_Atom_Object*)obj, plan_values);
+	if (n_matches != 3) {
+		return test_fail("Plan query failed, %u matches != 3\n", n_matches);
+	} else if (!lv2_atom_equals((LV2_Atom*)seq, plan_values[0])) {
+		return test_fail("Bad plan match sequence\n");
+	} else if (!lv2_atom_equals((LV2_Atom*)one, plan_values[1])) {
+		return test_fail("Bad plan match one\n");
+	} else if (!lv2_atom_equals((LV2_Atom*)string, plan_values[2])) {
+		return test_fail("Bad plan match string\n");
+	} else if (plan_values[3]) {
+		return test_fail("Plan matched missing key\n");
+	}
+
+	const uint32_t bad_keys[] = { eg_one, eg_two, eg_one };
+	if (lv2_atom_object_plan_init(&plan, 3, bad_keys)) {
+		return test_fail("Initialised query plan with duplicate keys\n");
+	}
+
+	if (test_sequence_merge(&forge) ||
+	    test_sequence_editor(&forge) ||
+	    test_sequence_index(&forge) ||
+	    test_sequence_slicer(&forge) ||
+	    test_event_dispatch(&forge) ||
+	    test_validate(&forge) ||
+	    test_codec(&forge) ||
+	    test_hash(&forge) ||
+	    test_sorted_object(&forge) ||
+	    test_ring(&forge) ||
+	    test_arena(&forge) ||
+	    test_checkpoint(&forge) ||
+	    test_vector_reserve(&forge) ||
+	    test_sequence_sort(&forge) ||
+	    test_template(&forge) ||
+	    test_fanout(&forge) ||
+	    test_tempo_map(&forge) ||
+	    test_sequence_slicer_beats(&forge) ||
+	    test_sequence_merge_tempo(&forge)) {
+		return 1;
+	}
+
 	printf("All tests passed.\n");
 	return 0;
 }
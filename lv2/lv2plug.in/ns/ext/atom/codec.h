@@ -0,0 +1,892 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file codec.h A portable binary encoding for LV2 atoms.
+
+   Atoms in memory are not portable: they contain URIDs which are only
+   meaningful to the host that mapped them, and numbers in native byte order.
+   This file provides a compact binary encoding for atoms which is portable
+   between hosts and machines, so atoms can be saved and loaded without
+   converting them to and from text.
+
+   Both directions are streaming, so no buffer for the whole document is
+   needed: the encoder writes output with an LV2_Atom_Forge_Sink function, and
+   the decoder reads input with a source function and writes atoms to a forge,
+   which may itself use a sink (see lv2_atom_forge_set_sink()).
+
+   A document is the 4 bytes "LV2A", a version byte (currently 1), and any
+   number of values.  All integers are unsigned LEB128 (7 bits per byte, least
+   significant group first, high bit set on all but the last byte), with
+   signed integers zig-zag encoded first.  Floating point numbers are IEEE 754
+   in little-endian byte order.  URIDs are written as URI references into a
+   table built as the document is written: a reference is 0 for no URI, `i`
+   for the `i`th URI already in the table, or one more than the size of the
+   table for a new URI, which is followed by its length and characters and
+   added to the table if it has fewer than LV2_ATOM_CODEC_MAX_URIS entries.
+
+   A value is a URI reference for its type, followed by a body:
+
+   <dl>
+   <dt>Int, Bool, Long</dt><dd>A signed integer.</dd>
+   <dt>Float, Double</dt><dd>A 4 or 8 byte floating point number.</dd>
+   <dt>URID</dt><dd>A URI reference.</dd>
+   <dt>String, Path, URI</dt><dd>A length and characters, without a
+   terminator.</dd>
+   <dt>Literal</dt><dd>URI references for the datatype and language, then a
+   string as above.</dd>
+   <dt>Vector</dt><dd>A URI reference for the child type, the child size, the
+   number of elements, then the bodies of the elements, which are raw bytes
+   unless the child type is one of the above scalars.</dd>
+   <dt>Tuple</dt><dd>A count, then that many values.</dd>
+   <dt>Object</dt><dd>URI references for the ID and object type, a count, then
+   that many properties, each a URI reference for the key, a URI reference for
+   the context, and a value.</dd>
+   <dt>Sequence</dt><dd>A URI reference for the unit, a count, then that many
+   events, each a time stamp and a value.  Time stamps are 8 byte floating
+   point numbers for atom:beatTime sequences, otherwise signed integers.</dd>
+   <dt>Other types</dt><dd>A size and the raw bytes of the body, which are only
+   portable if the type itself is.</dd>
+   </dl>
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_CODEC_H
+#define LV2_ATOM_CODEC_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/** The maximum number of URIs in the table of a document. */
+#define LV2_ATOM_CODEC_MAX_URIS 512
+
+/** The maximum length of a URI that can be decoded. */
+#define LV2_ATOM_CODEC_MAX_URI_LENGTH 1023
+
+/** The maximum depth of nested containers that can be encoded or decoded. */
+#define LV2_ATOM_CODEC_MAX_DEPTH 32
+
+/** The size of the internal buffer of an encoder or decoder. */
+#define LV2_ATOM_CODEC_BUF_SIZE 256
+
+/** The version of the encoding written by LV2_Atom_Encoder. */
+#define LV2_ATOM_CODEC_VERSION 1
+
+/**
+   @name Encoding
+   @{
+*/
+
+/** State for encoding atoms.  See lv2_atom_encoder_init(). */
+typedef struct {
+	const LV2_Atom_Forge*      forge;   /**< Forge for atom type URIDs */
+	LV2_URID_Unmap*            unmap;   /**< URID unmapper */
+	LV2_Atom_Forge_Sink        sink;    /**< Output function */
+	LV2_Atom_Forge_Sink_Handle handle;  /**< Output function handle */
+	bool                       error;   /**< True if encoding failed */
+	uint32_t                   n_uris;  /**< Number of URIs in table */
+	uint32_t                   n_buf;   /**< Number of bytes in buf */
+	uint32_t                   urids[2 * LV2_ATOM_CODEC_MAX_URIS];
+	uint32_t                   indices[2 * LV2_ATOM_CODEC_MAX_URIS];
+	uint8_t                    buf[LV2_ATOM_CODEC_BUF_SIZE];
+} LV2_Atom_Encoder;
+
+/**
+   Initialise an encoder.
+
+   @param encoder The encoder to initialise.
+   @param forge A forge initialised with lv2_atom_forge_init(), which is only
+   used for its type URIDs.
+   @param unmap Unmap feature for converting URIDs to URIs.
+   @param sink Function to write output, which returns 0 on failure.
+   @param handle Handle passed to `sink`.
+*/
+static inline void
+lv2_atom_encoder_init(LV2_Atom_Encoder*          encoder,
+                      const LV2_Atom_Forge*      forge,
+                      LV2_URID_Unmap*            unmap,
+                      LV2_Atom_Forge_Sink        sink,
+                      LV2_Atom_Forge_Sink_Handle handle)
+{
+	memset(encoder, 0, sizeof(LV2_Atom_Encoder));
+	encoder->forge  = forge;
+	encoder->unmap  = unmap;
+	encoder->sink   = sink;
+	encoder->handle = handle;
+}
+
+/** Write buffered output to the sink.  Used internally. */
+static inline void
+lv2_atom_encoder_flush(LV2_Atom_Encoder* encoder)
+{
+	if (encoder->n_buf && !encoder->error &&
+	    !encoder->sink(encoder->handle, encoder->buf, encoder->n_buf)) {
+		encoder->error = true;
+	}
+	encoder->n_buf = 0;
+}
+
+/** Write raw bytes.  Used internally. */
+static inline void
+lv2_atom_encoder_bytes(LV2_Atom_Encoder* encoder,
+                       const void*       data,
+                       uint32_t          size)
+{
+	if (encoder->n_buf + size > LV2_ATOM_CODEC_BUF_SIZE) {
+		lv2_atom_encoder_flush(encoder);
+		if (size > LV2_ATOM_CODEC_BUF_SIZE) {
+			if (!encoder->error &&
+			    !encoder->sink(encoder->handle, data, size)) {
+				encoder->error = true;
+			}
+			return;
+		}
+	}
+	memcpy(encoder->buf + encoder->n_buf, data, size);
+	encoder->n_buf += size;
+}
+
+/** Write an unsigned integer.  Used internally. */
+static inline void
+lv2_atom_encoder_uint(LV2_Atom_Encoder* encoder, uint64_t value)
+{
+	uint8_t  bytes[10];
+	uint32_t n = 0;
+	do {
+		bytes[n++] = (uint8_t)((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+		value >>= 7;
+	} while (value);
+	lv2_atom_encoder_bytes(encoder, bytes, n);
+}
+
+/** Write a signed integer.  Used internally. */
+static inline void
+lv2_atom_encoder_int(LV2_Atom_Encoder* encoder, int64_t value)
+{
+	lv2_atom_encoder_uint(
+		encoder, ((uint64_t)value << 1) ^ (uint64_t)(value < 0 ? -1 : 0));
+}
+
+/** Write `size` bytes of `value` in little-endian order.  Used internally. */
+static inline void
+lv2_atom_encoder_fixed(LV2_Atom_Encoder* encoder,
+                       uint64_t          value,
+                       uint32_t          size)
+{
+	uint8_t bytes[8];
+	for (uint32_t i = 0; i < size; ++i) {
+		bytes[i] = (uint8_t)(value >> (8 * i));
+	}
+	lv2_atom_encoder_bytes(encoder, bytes, size);
+}
+
+/** Write a URI reference for `urid`.  Used internally. */
+static inline void
+lv2_atom_encoder_uri(LV2_Atom_Encoder* encoder, LV2_URID urid)
+{
+	if (!urid) {
+		lv2_atom_encoder_uint(encoder, 0);
+		return;
+	}
+
+	// Search table for URID, stopping at the first empty slot
+	const uint32_t n_slots = 2 * LV2_ATOM_CODEC_MAX_URIS;
+	uint32_t       s       = (urid * 2654435769U) % n_slots;
+	while (encoder->urids[s] && encoder->urids[s] != urid) {
+		s = (s + 1) % n_slots;
+	}
+	if (encoder->urids[s]) {
+		lv2_atom_encoder_uint(encoder, encoder->indices[s]);
+		return;
+	}
+
+	// Not found, write complete URI
+	const char* uri = encoder->unmap->unmap(encoder->unmap->handle, urid);
+	if (!uri) {
+		encoder->error = true;
+		return;
+	}
+
+	const uint32_t len = (uint32_t)strlen(uri);
+	lv2_atom_encoder_uint(encoder, encoder->n_uris + 1);
+	lv2_atom_encoder_uint(encoder, len);
+	lv2_atom_encoder_bytes(encoder, uri, len);
+	if (encoder->n_uris < LV2_ATOM_CODEC_MAX_URIS) {
+		encoder->urids[s]   = urid;
+		encoder->indices[s] = ++encoder->n_uris;
+	}
+}
+
+/** Write a scalar body if `type` is a scalar type.  Used internally. */
+static inline bool
+lv2_atom_encoder_scalar(LV2_Atom_Encoder* encoder,
+                        uint32_t          type,
+                        uint32_t          size,
+                        const void*       body)
+{
+	const LV2_Atom_Forge* forge = encoder->forge;
+	if ((type == forge->Int || type == forge->Bool) && size == 4) {
+		lv2_atom_encoder_int(encoder, *(const int32_t*)body);
+	} else if (type == forge->Long && size == 8) {
+		lv2_atom_encoder_int(encoder, *(const int64_t*)body);
+	} else if (type == forge->Float && size == 4) {
+		uint32_t bits;
+		memcpy(&bits, body, sizeof(bits));
+		lv2_atom_encoder_fixed(encoder, bits, 4);
+	} else if (type == forge->Double && size == 8) {
+		uint64_t bits;
+		memcpy(&bits, body, sizeof(bits));
+		lv2_atom_encoder_fixed(encoder, bits, 8);
+	} else if (type == forge->URID && size == 4) {
+		lv2_atom_encoder_uri(encoder, *(const uint32_t*)body);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/** Write a value (without the type) of any type.  Used internally. */
+static inline void
+lv2_atom_encoder_body(LV2_Atom_Encoder* encoder,
+                      uint32_t          type,
+                      uint32_t          size,
+                      const void*       body,
+                      uint32_t          depth)
+{
+	const LV2_Atom_Forge* forge = encoder->forge;
+	if (depth > LV2_ATOM_CODEC_MAX_DEPTH) {
+		encoder->error = true;
+	} else if (lv2_atom_encoder_scalar(encoder, type, size, body)) {
+		return;
+	} else if ((type == forge->String || type == forge->Path ||
+	            type == forge->URI) && size > 0) {
+		lv2_atom_encoder_uint(encoder, size - 1);
+		lv2_atom_encoder_bytes(encoder, body, size - 1);
+	} else if (type == forge->Literal &&
+	           size > sizeof(LV2_Atom_Literal_Body)) {
+		const LV2_Atom_Literal_Body* lit = (const LV2_Atom_Literal_Body*)body;
+		const uint32_t len = size - (uint32_t)sizeof(*lit) - 1;
+		lv2_atom_encoder_uri(encoder, lit->datatype);
+		lv2_atom_encoder_uri(encoder, lit->lang);
+		lv2_atom_encoder_uint(encoder, len);
+		lv2_atom_encoder_bytes(encoder, lit + 1, len);
+	} else if (type == forge->Vector && size >= sizeof(LV2_Atom_Vector_Body)) {
+		const LV2_Atom_Vector_Body* vec = (const LV2_Atom_Vector_Body*)body;
+		const uint32_t n_bytes = size - (uint32_t)sizeof(*vec);
+		const uint32_t n_elems = vec->child_size ? n_bytes / vec->child_size : 0;
+		const uint8_t* elems   = (const uint8_t*)(vec + 1);
+		lv2_atom_encoder_uri(encoder, vec->child_type);
+		lv2_atom_encoder_uint(encoder, vec->child_size);
+		lv2_atom_encoder_uint(encoder, n_elems);
+		for (uint32_t i = 0; i < n_elems; ++i) {
+			const uint8_t* elem = elems + i * vec->child_size;
+			if (!lv2_atom_encoder_scalar(
+				    encoder, vec->child_type, vec->child_size, elem)) {
+				lv2_atom_encoder_bytes(encoder, elem, vec->child_size);
+			}
+		}
+	} else if (type == forge->Tuple) {
+		uint32_t n = 0;
+		LV2_ATOM_TUPLE_BODY_FOREACH(body, size, i) {
+			++n;
+		}
+		lv2_atom_encoder_uint(encoder, n);
+		LV2_ATOM_TUPLE_BODY_FOREACH(body, size, i) {
+			lv2_atom_encoder_uri(encoder, i->type);
+			lv2_atom_encoder_body(
+				encoder, i->type, i->size, LV2_ATOM_BODY_CONST(i), depth + 1);
+		}
+	} else if (lv2_atom_forge_is_object_type(forge, type) &&
+	           size >= sizeof(LV2_Atom_Object_Body)) {
+		const LV2_Atom_Object_Body* obj = (const LV2_Atom_Object_Body*)body;
+		uint32_t                    n   = 0;
+		LV2_ATOM_OBJECT_BODY_FOREACH(obj, size, p) {
+			++n;
+		}
+		lv2_atom_encoder_uri(encoder, obj->id);
+		lv2_atom_encoder_uri(encoder, obj->otype);
+		lv2_atom_encoder_uint(encoder, n);
+		LV2_ATOM_OBJECT_BODY_FOREACH(obj, size, p) {
+			lv2_atom_encoder_uri(encoder, p->key);
+			lv2_atom_encoder_uri(encoder, p->context);
+			lv2_atom_encoder_uri(encoder, p->value.type);
+			lv2_atom_encoder_body(encoder,
+			                      p->value.type,
+			                      p->value.size,
+			                      LV2_ATOM_BODY_CONST(&p->value),
+			                      depth + 1);
+		}
+	} else if (type == forge->Sequence &&
+	           size >= sizeof(LV2_Atom_Sequence_Body)) {
+		const LV2_Atom_Sequence_Body* seq = (const LV2_Atom_Sequence_Body*)body;
+		const char* unit = seq->unit
+			? encoder->unmap->unmap(encoder->unmap->handle, seq->unit)
+			: NULL;
+		const bool beats = unit && !strcmp(unit, LV2_ATOM__beatTime);
+		uint32_t   n     = 0;
+		LV2_ATOM_SEQUENCE_BODY_FOREACH(seq, size, ev) {
+			++n;
+		}
+		lv2_atom_encoder_uri(encoder, seq->unit);
+		lv2_atom_encoder_uint(encoder, n);
+		LV2_ATOM_SEQUENCE_BODY_FOREACH(seq, size, ev) {
+			if (beats) {
+				uint64_t bits;
+				memcpy(&bits, &ev->time.beats, sizeof(bits));
+				lv2_atom_encoder_fixed(encoder, bits, 8);
+			} else {
+				lv2_atom_encoder_int(encoder, ev->time.frames);
+			}
+			lv2_atom_encoder_uri(encoder, ev->body.type);
+			lv2_atom_encoder_body(encoder,
+			                      ev->body.type,
+			                      ev->body.size,
+			                      LV2_ATOM_BODY_CONST(&ev->body),
+			                      depth + 1);
+		}
+	} else {
+		lv2_atom_encoder_uint(encoder, size);
+		lv2_atom_encoder_bytes(encoder, body, size);
+	}
+}
+
+/**
+   Start a new document.
+
+   This writes the document header and clears the URI table.
+*/
+static inline void
+lv2_atom_encoder_begin(LV2_Atom_Encoder* encoder)
+{
+	static const uint8_t header[] = { 'L', 'V', '2', 'A',
+	                                  LV2_ATOM_CODEC_VERSION };
+
+	memset(encoder->urids, 0, sizeof(encoder->urids));
+	encoder->error  = false;
+	encoder->n_uris = 0;
+	encoder->n_buf  = 0;
+	lv2_atom_encoder_bytes(encoder, header, sizeof(header));
+}
+
+/**
+   Write an atom to the current document.
+
+   The atom must be valid, so untrusted atoms should be checked with
+   lv2_atom_validate() first.  Output is buffered, so some may not be written
+   to the sink until lv2_atom_encoder_end() is called.
+
+   @return True on success, or false if an error has occurred in the document.
+*/
+static inline bool
+lv2_atom_encoder_write(LV2_Atom_Encoder* encoder, const LV2_Atom* atom)
+{
+	lv2_atom_encoder_uri(encoder, atom->type);
+	lv2_atom_encoder_body(
+		encoder, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom), 0);
+	return !encoder->error;
+}
+
+/**
+   Finish the current document and flush any buffered output.
+
+   @return True on success, or false if an error has occurred in the document.
+*/
+static inline bool
+lv2_atom_encoder_end(LV2_Atom_Encoder* encoder)
+{
+	lv2_atom_encoder_flush(encoder);
+	return !encoder->error;
+}
+
+/**
+   @}
+   @name Decoding
+   @{
+*/
+
+/**
+   Function for reading decoder input.
+
+   This must read up to `size` bytes into `buf` and return the number of bytes
+   read, which is less than `size` only at the end of input.
+*/
+typedef uint32_t (*LV2_Atom_Decoder_Source)(void*    handle,
+                                            void*    buf,
+                                            uint32_t size);
+
+/** State for decoding atoms.  See lv2_atom_decoder_init(). */
+typedef struct {
+	LV2_Atom_Forge*         forge;      /**< Forge to write atoms to */
+	LV2_URID_Map*           map;        /**< URID mapper */
+	LV2_Atom_Decoder_Source source;     /**< Input function */
+	void*                   handle;     /**< Input function handle */
+	LV2_URID                beat_time;  /**< URID of atom:beatTime */
+	bool                    error;      /**< True if decoding failed */
+	uint32_t                n_uris;     /**< Number of URIs in table */
+	uint32_t                pos;        /**< Offset of next byte in buf */
+	uint32_t                n_buf;      /**< Number of bytes in buf */
+	LV2_URID                urids[LV2_ATOM_CODEC_MAX_URIS];
+	uint8_t                 buf[LV2_ATOM_CODEC_BUF_SIZE];
+	char                    uri[LV2_ATOM_CODEC_MAX_URI_LENGTH + 1];
+} LV2_Atom_Decoder;
+
+/**
+   Initialise a decoder.
+
+   @param decoder The decoder to initialise.
+   @param forge Forge to write decoded atoms to.
+   @param map Map feature for converting URIs to URIDs.
+   @param source Function to read input.
+   @param handle Handle passed to `source`.
+*/
+static inline void
+lv2_atom_decoder_init(LV2_Atom_Decoder*       decoder,
+                      LV2_Atom_Forge*         forge,
+                      LV2_URID_Map*           map,
+                      LV2_Atom_Decoder_Source source,
+                      void*                   handle)
+{
+	memset(decoder, 0, sizeof(LV2_Atom_Decoder));
+	decoder->forge     = forge;
+	decoder->map       = map;
+	decoder->source    = source;
+	decoder->handle    = handle;
+	decoder->beat_time = map->map(map->handle, LV2_ATOM__beatTime);
+}
+
+/** Ensure input is buffered, returning false at the end.  Used internally. */
+static inline bool
+lv2_atom_decoder_fill(LV2_Atom_Decoder* decoder)
+{
+	if (decoder->pos == decoder->n_buf) {
+		decoder->pos   = 0;
+		decoder->n_buf = decoder->source(
+			decoder->handle, decoder->buf, LV2_ATOM_CODEC_BUF_SIZE);
+	}
+	return decoder->pos < decoder->n_buf;
+}
+
+/** Read `size` raw bytes into `data`.  Used internally. */
+static inline bool
+lv2_atom_decoder_bytes(LV2_Atom_Decoder* decoder, void* data, uint32_t size)
+{
+	uint8_t* out = (uint8_t*)data;
+	while (size) {
+		if (!lv2_atom_decoder_fill(decoder)) {
+			return false;
+		}
+
+		const uint32_t avail = decoder->n_buf - decoder->pos;
+		const uint32_t n     = size < avail ? size : avail;
+		memcpy(out, decoder->buf + decoder->pos, n);
+		decoder->pos += n;
+		out          += n;
+		size         -= n;
+	}
+	return true;
+}
+
+/** Copy `size` raw bytes from the input to the forge.  Used internally. */
+static inline bool
+lv2_atom_decoder_copy(LV2_Atom_Decoder* decoder, uint32_t size)
+{
+	while (size) {
+		if (!lv2_atom_decoder_fill(decoder)) {
+			return false;
+		}
+
+		const uint32_t avail = decoder->n_buf - decoder->pos;
+		const uint32_t n     = size < avail ? size : avail;
+		if (!lv2_atom_forge_raw(
+			    decoder->forge, decoder->buf + decoder->pos, n)) {
+			return false;
+		}
+		decoder->pos += n;
+		size         -= n;
+	}
+	return true;
+}
+
+/** Read an unsigned integer.  Used internally. */
+static inline bool
+lv2_atom_decoder_uint(LV2_Atom_Decoder* decoder, uint64_t* value)
+{
+	*value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		if (!lv2_atom_decoder_fill(decoder)) {
+			return false;
+		}
+
+		const uint8_t byte = decoder->buf[decoder->pos++];
+		*value |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Read an unsigned integer that must fit in 32 bits.  Used internally. */
+static inline bool
+lv2_atom_decoder_uint32(LV2_Atom_Decoder* decoder, uint32_t* value)
+{
+	uint64_t v = 0;
+	if (!lv2_atom_decoder_uint(decoder, &v) || v > UINT32_MAX) {
+		return false;
+	}
+	*value = (uint32_t)v;
+	return true;
+}
+
+/** Read a signed integer.  Used internally. */
+static inline bool
+lv2_atom_decoder_int(LV2_Atom_Decoder* decoder, int64_t* value)
+{
+	uint64_t v = 0;
+	if (!lv2_atom_decoder_uint(decoder, &v)) {
+		return false;
+	}
+	*value = (int64_t)((v >> 1) ^ (~(v & 1) + 1));
+	return true;
+}
+
+/** Read a `size` byte little-endian number.  Used internally. */
+static inline bool
+lv2_atom_decoder_fixed(LV2_Atom_Decoder* decoder,
+                       uint64_t*         value,
+                       uint32_t          size)
+{
+	uint8_t bytes[8];
+	if (!lv2_atom_decoder_bytes(decoder, bytes, size)) {
+		return false;
+	}
+	*value = 0;
+	for (uint32_t i = 0; i < size; ++i) {
+		*value |= (uint64_t)bytes[i] << (8 * i);
+	}
+	return true;
+}
+
+/** Read a URI reference.  Used internally. */
+static inline bool
+lv2_atom_decoder_uri(LV2_Atom_Decoder* decoder, LV2_URID* urid)
+{
+	uint64_t ref = 0;
+	uint32_t len = 0;
+	if (!lv2_atom_decoder_uint(decoder, &ref) || ref > decoder->n_uris + 1) {
+		return false;
+	} else if (ref == 0) {
+		*urid = 0;
+		return true;
+	} else if (ref <= decoder->n_uris) {
+		*urid = decoder->urids[ref - 1];
+		return true;
+	} else if (!lv2_atom_decoder_uint32(decoder, &len) ||
+	           len > LV2_ATOM_CODEC_MAX_URI_LENGTH ||
+	           !lv2_atom_decoder_bytes(decoder, decoder->uri, len)) {
+		return false;
+	}
+
+	decoder->uri[len] = '\0';
+	*urid = decoder->map->map(decoder->map->handle, decoder->uri);
+	if (decoder->n_uris < LV2_ATOM_CODEC_MAX_URIS) {
+		decoder->urids[decoder->n_uris++] = *urid;
+	}
+	return *urid != 0;
+}
+
+/**
+   Read a scalar body of the given type into `body`.
+
+   @return 1 on success, 0 on error, or -1 if `type` is not a scalar type.
+   Used internally.
+*/
+static inline int
+lv2_atom_decoder_scalar(LV2_Atom_Decoder* decoder,
+                        uint32_t          type,
+                        uint32_t          size,
+                        void*             body)
+{
+	const LV2_Atom_Forge* forge = decoder->forge;
+	int64_t               i     = 0;
+	uint64_t              bits  = 0;
+	if ((type == forge->Int || type == forge->Bool) && size == 4) {
+		if (!lv2_atom_decoder_int(decoder, &i)) {
+			return 0;
+		}
+		const int32_t v = (int32_t)i;
+		memcpy(body, &v, sizeof(v));
+	} else if (type == forge->Long && size == 8) {
+		if (!lv2_atom_decoder_int(decoder, &i)) {
+			return 0;
+		}
+		memcpy(body, &i, sizeof(i));
+	} else if (type == forge->Float && size == 4) {
+		if (!lv2_atom_decoder_fixed(decoder, &bits, 4)) {
+			return 0;
+		}
+		const uint32_t v = (uint32_t)bits;
+		memcpy(body, &v, sizeof(v));
+	} else if (type == forge->Double && size == 8) {
+		if (!lv2_atom_decoder_fixed(decoder, &bits, 8)) {
+			return 0;
+		}
+		memcpy(body, &bits, sizeof(bits));
+	} else if (type == forge->URID && size == 4) {
+		LV2_URID urid = 0;
+		if (!lv2_atom_decoder_uri(decoder, &urid)) {
+			return 0;
+		}
+		memcpy(body, &urid, sizeof(urid));
+	} else {
+		return -1;
+	}
+	return 1;
+}
+
+/** Read a string body and write it to the forge.  Used internally. */
+static inline bool
+lv2_atom_decoder_string_body(LV2_Atom_Decoder* decoder, uint32_t len)
+{
+	if (!lv2_atom_decoder_copy(decoder, len) ||
+	    !lv2_atom_forge_raw(decoder->forge, "", 1)) {
+		return false;
+	}
+	lv2_atom_forge_pad(decoder->forge, len + 1);
+	return true;
+}
+
+/**
+   Return true if a vector of `n` elements of `child_size` bytes can be read.
+
+   The input is a stream, so its size is unknown, but elements of size zero
+   would be read forever without consuming any input, and the elements must
+   fit in the output.  Used internally.
+*/
+static inline bool
+lv2_atom_decoder_vector_fits(const LV2_Atom_Decoder* decoder,
+                             uint32_t                child_size,
+                             uint32_t                n)
+{
+	const LV2_Atom_Forge* const forge = decoder->forge;
+	const uint64_t              size  = (uint64_t)n * child_size;
+	if (n && !child_size) {
+		return false;
+	} else if (size > UINT32_MAX - sizeof(LV2_Atom_Vector)) {
+		return false;
+	}
+	return forge->sink || !forge->buf ||
+	       size + sizeof(LV2_Atom_Vector) <= forge->size - forge->offset;
+}
+
+/** Read a value of the given type and write it to the forge.  Internal. */
+static inline LV2_Atom_Forge_Ref
+lv2_atom_decoder_body(LV2_Atom_Decoder* decoder, uint32_t type, uint32_t depth)
+{
+	LV2_Atom_Forge* const forge = decoder->forge;
+	LV2_Atom_Forge_Frame  frame;
+	LV2_Atom_Forge_Ref    ref = 0;
+	uint64_t              scalar[1];
+	uint32_t              len = 0;
+	uint32_t              n   = 0;
+	bool                  ok  = false;
+	if (depth > LV2_ATOM_CODEC_MAX_DEPTH) {
+		return 0;
+	}
+
+	const uint32_t scalar_size = (type == forge->Long ||
+	                              type == forge->Double) ? 8 : 4;
+	const int      r = lv2_atom_decoder_scalar(
+		decoder, type, scalar_size, scalar);
+	if (r >= 0) {
+		const LV2_Atom a = { scalar_size, type };
+		if (r && (ref = lv2_atom_forge_raw(forge, &a, sizeof(a)))) {
+			ok = lv2_atom_forge_write(forge, scalar, scalar_size) != 0;
+		}
+	} else if (type == forge->String || type == forge->Path ||
+	           type == forge->URI) {
+		ok = (lv2_atom_decoder_uint32(decoder, &len) && len < UINT32_MAX &&
+		      (ref = lv2_atom_forge_atom(forge, len + 1, type)) != 0 &&
+		      lv2_atom_decoder_string_body(decoder, len));
+	} else if (type == forge->Literal) {
+		LV2_Atom_Literal_Body lit = { 0, 0 };
+		ok = (lv2_atom_decoder_uri(decoder, &lit.datatype) &&
+		      lv2_atom_decoder_uri(decoder, &lit.lang) &&
+		      lv2_atom_decoder_uint32(decoder, &len) &&
+		      len < UINT32_MAX - sizeof(lit) &&
+		      (ref = lv2_atom_forge_atom(
+			      forge, (uint32_t)sizeof(lit) + len + 1, type)) != 0 &&
+		      lv2_atom_forge_raw(forge, &lit, sizeof(lit)) != 0 &&
+		      lv2_atom_decoder_string_body(decoder, len));
+	} else if (type == forge->Vector) {
+		LV2_URID child_type = 0;
+		uint32_t child_size = 0;
+		if (lv2_atom_decoder_uri(decoder, &child_type) &&
+		    lv2_atom_decoder_uint32(decoder, &child_size) &&
+		    lv2_atom_decoder_uint32(decoder, &n) &&
+		    lv2_atom_decoder_vector_fits(decoder, child_size, n)) {
+			ref = lv2_atom_forge_vector_head(
+				forge, &frame, child_size, child_type);
+			ok = ref != 0;
+			for (uint32_t i = 0; ok && i < n; ++i) {
+				const int s = lv2_atom_decoder_scalar(
+					decoder, child_type, child_size, scalar);
+				if (s > 0) {
+					ok = lv2_atom_forge_raw(forge, scalar, child_size) != 0;
+				} else {
+					ok = s < 0 && lv2_atom_decoder_copy(decoder, child_size);
+				}
+			}
+			lv2_atom_forge_pop(forge, &frame);
+			if (ok) {
+				lv2_atom_forge_pad(forge, n * child_size);
+			}
+		}
+	} else if (type == forge->Tuple) {
+		if (lv2_atom_decoder_uint32(decoder, &n)) {
+			ok = (ref = lv2_atom_forge_tuple(forge, &frame)) != 0;
+			for (uint32_t i = 0; ok && i < n; ++i) {
+				ok = (lv2_atom_decoder_uri(decoder, &type) &&
+				      lv2_atom_decoder_body(decoder, type, depth + 1));
+			}
+			lv2_atom_forge_pop(forge, &frame);
+		}
+	} else if (lv2_atom_forge_is_object_type(forge, type)) {
+		LV2_Atom_Object a = { { sizeof(LV2_Atom_Object_Body), type }, { 0, 0 } };
+		if (!lv2_atom_decoder_uri(decoder, &a.body.id) ||
+		    !lv2_atom_decoder_uri(decoder, &a.body.otype) ||
+		    !lv2_atom_decoder_uint32(decoder, &n)) {
+			return 0;
+		}
+
+		ref = lv2_atom_forge_write(forge, &a, sizeof(a));
+		ok  = lv2_atom_forge_push(forge, &frame, ref) != 0;
+		for (uint32_t i = 0; ok && i < n; ++i) {
+			LV2_URID key     = 0;
+			LV2_URID context = 0;
+			ok = (lv2_atom_decoder_uri(decoder, &key) &&
+			      lv2_atom_decoder_uri(decoder, &context) &&
+			      lv2_atom_forge_property_head(forge, key, context) &&
+			      lv2_atom_decoder_uri(decoder, &type) &&
+			      lv2_atom_decoder_body(decoder, type, depth + 1));
+		}
+		lv2_atom_forge_pop(forge, &frame);
+	} else if (type == forge->Sequence) {
+		LV2_Atom_Sequence a = {
+			{ sizeof(LV2_Atom_Sequence_Body), type }, { 0, 0 }
+		};
+		if (!lv2_atom_decoder_uri(decoder, &a.body.unit) ||
+		    !lv2_atom_decoder_uint32(decoder, &n)) {
+			return 0;
+		}
+
+		ref = lv2_atom_forge_write(forge, &a, sizeof(a));
+		ok  = lv2_atom_forge_push(forge, &frame, ref) != 0;
+		for (uint32_t i = 0; ok && i < n; ++i) {
+			int64_t frames = 0;
+			if (a.body.unit && a.body.unit == decoder->beat_time) {
+				double beats = 0.0;
+				ok = lv2_atom_decoder_fixed(decoder, scalar, 8);
+				memcpy(&beats, scalar, sizeof(beats));
+				ok = ok && lv2_atom_forge_beat_time(forge, beats);
+			} else {
+				ok = (lv2_atom_decoder_int(decoder, &frames) &&
+				      lv2_atom_forge_frame_time(forge, frames));
+			}
+			ok = (ok &&
+			      lv2_atom_decoder_uri(decoder, &type) &&
+			      lv2_atom_decoder_body(decoder, type, depth + 1));
+		}
+		lv2_atom_forge_pop(forge, &frame);
+	} else {
+		ok = (lv2_atom_decoder_uint32(decoder, &len) &&
+		      (ref = lv2_atom_forge_atom(forge, len, type)) != 0 &&
+		      lv2_atom_decoder_copy(decoder, len));
+		if (ok) {
+			lv2_atom_forge_pad(forge, len);
+		}
+	}
+
+	return ok ? ref : 0;
+}
+
+/**
+   Start reading a document.
+
+   @return True on success, or false if the input is not a document in a
+   supported version of the encoding.
+*/
+static inline bool
+lv2_atom_decoder_begin(LV2_Atom_Decoder* decoder)
+{
+	uint8_t header[5];
+	decoder->error  = false;
+	decoder->n_uris = 0;
+	if (!lv2_atom_decoder_bytes(decoder, header, sizeof(header)) ||
+	    memcmp(header, "LV2A", 4) || header[4] != LV2_ATOM_CODEC_VERSION) {
+		decoder->error = true;
+	}
+	return !decoder->error;
+}
+
+/** Return true iff the end of the document has been reached. */
+static inline bool
+lv2_atom_decoder_at_end(LV2_Atom_Decoder* decoder)
+{
+	return !lv2_atom_decoder_fill(decoder);
+}
+
+/**
+   Read the next atom in the document and write it to the forge.
+
+   @return A reference to the written atom, or 0 on error, for example if the
+   input is invalid, or the forge is full.  After an error, the decoder can
+   not be used until lv2_atom_decoder_begin() is called for a new document.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_decoder_read(LV2_Atom_Decoder* decoder)
+{
+	LV2_URID           type = 0;
+	LV2_Atom_Forge_Ref ref  = 0;
+	if (decoder->error ||
+	    !lv2_atom_decoder_uri(decoder, &type) ||
+	    !(ref = lv2_atom_decoder_body(decoder, type, 0))) {
+		decoder->error = true;
+	}
+	return ref;
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_ATOM_CODEC_H */
@@ -0,0 +1,261 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file fanout.h A forge sink for writing one message to several outputs.
+
+   Hosts and plugins with several event outputs often send the same message to
+   all of them, for example a notification to both a UI port and a log port.
+   Rather than forging the message once for every output, a fanout is a forge
+   sink that the message is forged into once, which is then copied to every
+   target forge as an event when it is committed.
+
+   Only the fanout holds the message while it is being forged, so references
+   and lv2_atom_forge_deref() work as with any other sink, and every target
+   receives the same complete message.  Each target is written separately,
+   with its own bounds check, so a target that is full misses the message
+   without affecting the others.
+
+   For example, in run():
+   @code
+   lv2_atom_fanout_begin(&self->fanout, &self->forge);
+
+   LV2_Atom_Forge_Frame frame;
+   lv2_atom_forge_object(&self->forge, &frame, 0, uris->patch_Set);
+   ...
+   lv2_atom_forge_pop(&self->forge, &frame);
+
+   lv2_atom_fanout_commit(&self->fanout, offset);
+   @endcode
+
+   The buffer for the message is provided by the caller, and nothing is
+   allocated, so a fanout is realtime safe.  Note that forging to a sink is
+   slower than forging directly to a buffer, so this is only worthwhile for
+   more than two outputs.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_FANOUT_H
+#define LV2_ATOM_FANOUT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup fanout Fanout
+   @ingroup atom
+   @{
+*/
+
+/** An output of a fanout. */
+typedef struct {
+	LV2_Atom_Forge* forge;     /**< Forge writing to the output */
+	bool            overflow;  /**< Set if a message did not fit */
+} LV2_Atom_Fanout_Target;
+
+/** A forge sink which copies each message to several outputs. */
+typedef struct {
+	uint8_t*                buf;        /**< Buffer for the current message */
+	uint32_t                size;       /**< Number of bytes written to buf */
+	uint32_t                capacity;   /**< Size of buf */
+	LV2_Atom_Fanout_Target* targets;    /**< Outputs */
+	uint32_t                n_targets;  /**< Number of outputs */
+	bool                    error;      /**< True if the message overflowed */
+	bool                    dropped;    /**< True if last commit was invalid */
+} LV2_Atom_Fanout;
+
+/**
+   Initialise `fanout`.
+
+   @param fanout The fanout to initialise.
+   @param buf Buffer for messages, which must be 64-bit aligned and as large
+   as the largest message to be sent.
+   @param capacity Size of `buf` in bytes.
+   @param targets Outputs to copy messages to.  The forge of every target must
+   write to a buffer set with lv2_atom_forge_set_buffer(), not to a sink such
+   as a ring or arena, since a message that does not fit is rolled back.  The
+   buffer may be set later, but must be set to the output, with a sequence
+   open, before a message is committed.
+   @param n_targets Number of elements in `targets`.
+   @return True on success, or false if the forge of a target writes to a
+   sink.
+*/
+static inline bool
+lv2_atom_fanout_init(LV2_Atom_Fanout*        fanout,
+                     void*                   buf,
+                     uint32_t                capacity,
+                     LV2_Atom_Fanout_Target* targets,
+                     uint32_t                n_targets)
+{
+	fanout->buf       = (uint8_t*)buf;
+	fanout->size      = 0;
+	fanout->capacity  = capacity;
+	fanout->targets   = targets;
+	fanout->n_targets = n_targets;
+	fanout->error     = false;
+	fanout->dropped   = false;
+	for (uint32_t i = 0; i < n_targets; ++i) {
+		if (targets[i].forge->sink) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+   Forge sink that appends to the message of a fanout.
+
+   References are offsets from the start of the message, plus one.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_fanout_sink(LV2_Atom_Forge_Sink_Handle handle,
+                     const void*                data,
+                     uint32_t                   size)
+{
+	LV2_Atom_Fanout* const fanout = (LV2_Atom_Fanout*)handle;
+	if (fanout->error ||
+	    (uint64_t)fanout->size + size > fanout->capacity) {
+		fanout->error = true;
+		return 0;
+	}
+
+	const uint32_t offset = fanout->size;
+	memcpy(fanout->buf + offset, data, size);
+	fanout->size += size;
+	return (LV2_Atom_Forge_Ref)offset + 1;
+}
+
+/** Forge deref function for a fanout, see lv2_atom_fanout_sink(). */
+static inline LV2_Atom*
+lv2_atom_fanout_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
+{
+	LV2_Atom_Fanout* const fanout = (LV2_Atom_Fanout*)handle;
+	return (LV2_Atom*)(fanout->buf + (ref - 1));
+}
+
+/**
+   Clear the message of `fanout` and set it as the sink for `forge`.
+
+   The forge must not be used for anything else until the message is
+   committed, but may be used for any number of messages in a row, since
+   committing clears the message again.
+*/
+static inline void
+lv2_atom_fanout_begin(LV2_Atom_Fanout* fanout, LV2_Atom_Forge* forge)
+{
+	fanout->size  = 0;
+	fanout->error = false;
+	lv2_atom_forge_set_sink(
+		forge, lv2_atom_fanout_sink, lv2_atom_fanout_deref, fanout);
+}
+
+/**
+   Write the message of `fanout` to every target as an event.
+
+   This is the implementation of lv2_atom_fanout_commit() and
+   lv2_atom_fanout_commit_beats(), which should be used instead.
+*/
+static inline uint32_t
+lv2_atom_fanout_commit_time(LV2_Atom_Fanout* fanout,
+                            bool             is_beats,
+                            int64_t          frames,
+                            double           beats)
+{
+	const LV2_Atom* const msg = (const LV2_Atom*)fanout->buf;
+	const bool valid = !fanout->error && fanout->size >= sizeof(LV2_Atom) &&
+		lv2_atom_pad_size(lv2_atom_total_size(msg)) == fanout->size;
+
+	fanout->size    = 0;
+	fanout->error   = false;
+	fanout->dropped = !valid;
+	if (!valid) {
+		return 0;
+	}
+
+	uint32_t n_written = 0;
+	for (uint32_t i = 0; i < fanout->n_targets; ++i) {
+		LV2_Atom_Fanout_Target* const   target = &fanout->targets[i];
+		LV2_Atom_Forge* const           forge  = target->forge;
+		const LV2_Atom_Forge_Checkpoint checkpoint =
+			lv2_atom_forge_checkpoint(forge);
+
+		if (!forge->buf) {
+			target->overflow = true;  // No buffer to roll back
+		} else if ((is_beats ? lv2_atom_forge_beat_time(forge, beats)
+		              : lv2_atom_forge_frame_time(forge, frames)) &&
+		    lv2_atom_forge_write(forge, msg, lv2_atom_total_size(msg))) {
+			++n_written;
+		} else {
+			lv2_atom_forge_rollback(forge, &checkpoint);
+			target->overflow = true;
+		}
+	}
+
+	return n_written;
+}
+
+/**
+   Write the message of `fanout` to every target as an event at `frames`.
+
+   The message must be a single complete atom, with all containers popped.
+   A target that does not have enough space is left as it was and its
+   `overflow` flag is set, so each output may be checked separately.  If the
+   message itself is invalid, because it overflowed the buffer of the fanout
+   or is incomplete, it is not written to any target and no target is
+   flagged, but the `dropped` flag of the fanout is set until the next
+   commit.  In any case, the message is cleared so the next one can be
+   forged.
+
+   @return The number of targets the message was written to.
+*/
+static inline uint32_t
+lv2_atom_fanout_commit(LV2_Atom_Fanout* fanout, int64_t frames)
+{
+	return lv2_atom_fanout_commit_time(fanout, false, frames, 0.0);
+}
+
+/**
+   Write the message of `fanout` to every target as an event at `beats`.
+
+   This is like lv2_atom_fanout_commit(), for targets with sequences in beat
+   time.
+*/
+static inline uint32_t
+lv2_atom_fanout_commit_beats(LV2_Atom_Fanout* fanout, double beats)
+{
+	return lv2_atom_fanout_commit_time(fanout, true, 0, beats);
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_ATOM_FANOUT_H */
@@ -43,6 +43,7 @@
 #define LV2_ATOM_FORGE_H
 
 #include <assert.h>
+#include <float.h>
 
 #include "lv2/lv2plug.in/ns/ext/atom/atom.h"
 #include "lv2/lv2plug.in/ns/ext/atom/util.h"
@@ -224,6 +225,77 @@ lv2_atom_forge_is_blank(const LV2_Atom_Forge*       forge,
 	        (type == forge->Object && body->id == 0));
 }
 
+/**
+   @}
+   @name Checkpoints
+   @{
+*/
+
+/**
+   A saved forge position, to roll back to if writing fails.
+
+   When writing to a buffer, a write that does not fit fails without changing
+   the output, but earlier writes are kept, so the output can be left with an
+   incomplete container.  Taking a checkpoint before writing an event and
+   rolling back to it if any write fails removes the partial event, so output
+   buffers can be filled to their exact capacity, and an event that does not
+   fit is dropped rather than corrupted.
+
+   For example:
+   @code
+   const LV2_Atom_Forge_Checkpoint checkpoint = lv2_atom_forge_checkpoint(forge);
+   LV2_Atom_Forge_Frame            frame;
+   if (lv2_atom_forge_frame_time(forge, 0) &&
+       lv2_atom_forge_object(forge, &frame, 0, eg_Message) &&
+       lv2_atom_forge_key(forge, eg_value) &&
+       lv2_atom_forge_float(forge, 1.0f)) {
+       lv2_atom_forge_pop(forge, &frame);
+   } else {
+       lv2_atom_forge_rollback(forge, &checkpoint);
+   }
+   @endcode
+*/
+typedef struct {
+	uint32_t              offset;  /**< Offset in buffer */
+	LV2_Atom_Forge_Frame* stack;   /**< Top of stack */
+} LV2_Atom_Forge_Checkpoint;
+
+/**
+   Return a checkpoint at the current position of `forge`.
+
+   Checkpoints are only supported when writing to a buffer.  Frames which are
+   open at the checkpoint must not be popped until the checkpoint is no longer
+   needed.
+*/
+static inline LV2_Atom_Forge_Checkpoint
+lv2_atom_forge_checkpoint(const LV2_Atom_Forge* forge)
+{
+	const LV2_Atom_Forge_Checkpoint checkpoint = { forge->offset, forge->stack };
+	return checkpoint;
+}
+
+/**
+   Roll `forge` back to `checkpoint`.
+
+   Everything written since the checkpoint is discarded, frames pushed since
+   then are popped, and the sizes of the containers which were open at the
+   checkpoint are restored.  This function is realtime safe.
+*/
+static inline void
+lv2_atom_forge_rollback(LV2_Atom_Forge*                  forge,
+                        const LV2_Atom_Forge_Checkpoint* checkpoint)
+{
+	assert(forge->buf);
+	const uint32_t written = forge->offset - checkpoint->offset;
+	forge->offset = checkpoint->offset;
+	forge->stack  = checkpoint->stack;
+	for (LV2_Atom_Forge_Frame* f = forge->stack; f; f = f->parent) {
+		if (f->ref) {
+			lv2_atom_forge_deref(forge, f->ref)->size -= written;
+		}
+	}
+}
+
 /**
    @}
    @name Output Configuration
@@ -287,7 +359,9 @@ lv2_atom_forge_raw(LV2_Atom_Forge* forge, const void* data, uint32_t size)
 {
 	LV2_Atom_Forge_Ref out = 0;
 	if (forge->sink) {
-		out = forge->sink(forge->handle, data, size);
+		if (!(out = forge->sink(forge->handle, data, size))) {
+			return 0;
+		}
 	} else {
 		out = (LV2_Atom_Forge_Ref)forge->buf + forge->offset;
 		uint8_t* mem = forge->buf + forge->offset;
@@ -298,18 +372,51 @@ lv2_atom_forge_raw(LV2_Atom_Forge* forge, const void* data, uint32_t size)
 		memcpy(mem, data, size);
 	}
 	for (LV2_Atom_Forge_Frame* f = forge->stack; f; f = f->parent) {
-		lv2_atom_forge_deref(forge, f->ref)->size += size;
+		if (f->ref) {  // Skip containers whose header did not fit
+			lv2_atom_forge_deref(forge, f->ref)->size += size;
+		}
 	}
 	return out;
 }
 
+/**
+   Reserve raw output to be written in place.
+
+   This is like lv2_atom_forge_raw(), but only makes room for `size` bytes,
+   which the caller must then fill via the returned pointer.  This is only
+   possible when writing to a buffer, not to a sink.  Note the caller is
+   responsible for ensuring the output is approriately padded.
+
+   @return A pointer to the reserved output, or NULL if there is not enough
+   space or the forge writes to a sink.
+*/
+static inline void*
+lv2_atom_forge_reserve(LV2_Atom_Forge* forge, uint32_t size)
+{
+	if (forge->sink || !forge->buf ||
+	    (uint64_t)forge->offset + size > forge->size) {
+		return NULL;
+	}
+
+	uint8_t* const mem = forge->buf + forge->offset;
+	forge->offset += size;
+	for (LV2_Atom_Forge_Frame* f = forge->stack; f; f = f->parent) {
+		if (f->ref) {
+			lv2_atom_forge_deref(forge, f->ref)->size += size;
+		}
+	}
+	return mem;
+}
+
 /** Pad output accordingly so next write is 64-bit aligned. */
 static inline void
 lv2_atom_forge_pad(LV2_Atom_Forge* forge, uint32_t written)
 {
 	const uint64_t pad      = 0;
 	const uint32_t pad_size = lv2_atom_pad_size(written) - written;
-	lv2_atom_forge_raw(forge, &pad, pad_size);
+	if (pad_size) {
+		lv2_atom_forge_raw(forge, &pad, pad_size);
+	}
 }
 
 /** Write raw output, padding to 64-bits as necessary. */
@@ -509,11 +616,105 @@ lv2_atom_forge_vector(LV2_Atom_Forge* forge,
 	};
 	LV2_Atom_Forge_Ref out = lv2_atom_forge_write(forge, &a, sizeof(a));
 	if (out) {
-		lv2_atom_forge_write(forge, elems, child_size * n_elems);
+		if (!lv2_atom_forge_write(forge, elems, child_size * n_elems)) {
+			LV2_Atom* atom = lv2_atom_forge_deref(forge, out);
+			atom->size = atom->type = 0;
+			out = 0;
+		}
 	}
 	return out;
 }
 
+/**
+   Reserve an atom:Vector to be filled in place.
+
+   This writes the header of a vector with room for `n_elems` elements, and
+   returns a pointer to the first element, so the caller can compute the
+   elements directly into the output rather than into a temporary array that
+   is then copied by lv2_atom_forge_vector().  To complete the vector, fill in
+   the elements, then call lv2_atom_forge_vector_commit() with the number of
+   elements actually written, which may be less than reserved.
+
+   For example:
+   @code
+   // Write a vector of the peaks of each block of 64 samples
+   LV2_Atom_Forge_Frame frame;
+   float* peaks = (float*)lv2_atom_forge_vector_reserve(
+       forge, &frame, sizeof(float), forge->Float, n_samples / 64);
+   if (peaks) {
+       uint32_t n_peaks = 0;
+       ...
+       lv2_atom_forge_vector_commit(forge, &frame, n_peaks);
+   }
+   @endcode
+
+   Since the elements are written in place, this is only possible when the
+   forge writes to a buffer, and nothing else may be written to the forge
+   until the vector is committed.  The elements are not initialised.
+
+   @param forge The forge to write to.
+   @param frame Frame which is initialised to represent the vector.
+   @param child_size Size of each element in bytes.
+   @param child_type Type of each element.
+   @param n_elems Maximum number of elements.
+   @return A pointer to the first element, or NULL if the vector does not fit
+   (including padding) or the forge writes to a sink, in which case nothing is
+   written and the frame must not be committed.
+*/
+static inline void*
+lv2_atom_forge_vector_reserve(LV2_Atom_Forge*       forge,
+                              LV2_Atom_Forge_Frame* frame,
+                              uint32_t              child_size,
+                              uint32_t              child_type,
+                              uint32_t              n_elems)
+{
+	const uint64_t size  = (uint64_t)child_size * n_elems;
+	const uint64_t total = (sizeof(LV2_Atom_Vector) + size + 7) & ~(uint64_t)7;
+	if (forge->sink || !forge->buf || forge->offset + total > forge->size) {
+		return NULL;
+	}
+
+	const LV2_Atom_Vector a = {
+		{ sizeof(LV2_Atom_Vector_Body), forge->Vector },
+		{ child_size, child_type }
+	};
+	lv2_atom_forge_push(forge, frame, lv2_atom_forge_raw(forge, &a, sizeof(a)));
+	return lv2_atom_forge_reserve(forge, (uint32_t)size);
+}
+
+/**
+   Complete a vector started with lv2_atom_forge_vector_reserve().
+
+   The vector is shrunk to `n_elems` elements, which must be at most the
+   number reserved, then padded, and the frame is popped.
+
+   @return A reference to the vector.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_forge_vector_commit(LV2_Atom_Forge*       forge,
+                             LV2_Atom_Forge_Frame* frame,
+                             uint32_t              n_elems)
+{
+	LV2_Atom_Vector* const vec = (LV2_Atom_Vector*)lv2_atom_forge_deref(
+		forge, frame->ref);
+
+	const uint64_t size     = (uint64_t)vec->body.child_size * n_elems;
+	const uint32_t reserved = vec->atom.size - sizeof(LV2_Atom_Vector_Body);
+	if (size < reserved) {
+		const uint32_t excess = reserved - (uint32_t)size;
+		forge->offset -= excess;
+		for (LV2_Atom_Forge_Frame* f = forge->stack; f; f = f->parent) {
+			if (f->ref) {
+				lv2_atom_forge_deref(forge, f->ref)->size -= excess;
+			}
+		}
+	}
+
+	lv2_atom_forge_pop(forge, frame);
+	lv2_atom_forge_pad(forge, vec->atom.size);
+	return frame->ref;
+}
+
 /**
    Write the header of an atom:Tuple.
 
@@ -647,6 +848,31 @@ lv2_atom_forge_property_head(LV2_Atom_Forge* forge,
 	return lv2_atom_forge_write(forge, &a, 2 * (uint32_t)sizeof(uint32_t));
 }
 
+/**
+   Pop an object frame, sorting the properties of the finished object.
+
+   This is used in place of lv2_atom_forge_pop() to write an object in the
+   canonical sorted form (see lv2_atom_object_sort()), so properties can be
+   written in any order.  If they are written in order, sorting is a single
+   scan.  The object must be stored contiguously, which is always the case
+   when writing to a buffer, or to a sink that supports dereferencing.
+
+   @return True on success, or false if the frame is not an object (for
+   example because the output overflowed before the object header).
+*/
+static inline bool
+lv2_atom_forge_pop_sorted(LV2_Atom_Forge* forge, LV2_Atom_Forge_Frame* frame)
+{
+	lv2_atom_forge_pop(forge, frame);
+	if (!frame->ref) {
+		return false;
+	}
+
+	LV2_Atom* const atom = lv2_atom_forge_deref(forge, frame->ref);
+	return (lv2_atom_forge_is_object_type(forge, atom->type) &&
+	        lv2_atom_object_sort((LV2_Atom_Object*)atom));
+}
+
 /**
    Write the header for a Sequence.
 */
@@ -685,6 +911,293 @@ lv2_atom_forge_beat_time(LV2_Atom_Forge* forge, double beats)
 	return lv2_atom_forge_write(forge, &beats, sizeof(beats));
 }
 
+/**
+   Write the time stamp header of an Event (in a Sequence) at `frames`.
+
+   If `tempo` is NULL, this is the same as lv2_atom_forge_frame_time().
+   Otherwise, the time stamp is written in beats, converted from `frames` with
+   `tempo`.  This allows events to be written at frame times in either unit,
+   for example by passing a tempo map only if the output sequence is in beats.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_forge_event_time(LV2_Atom_Forge*           forge,
+                          const LV2_Atom_Tempo_Map* tempo,
+                          int64_t                   frames)
+{
+	return tempo
+		? lv2_atom_forge_beat_time(
+			forge, lv2_atom_tempo_map_frames_to_beats(tempo, frames))
+		: lv2_atom_forge_frame_time(forge, frames);
+}
+
+/**
+   Pop a sequence frame and sort its events by time.
+
+   This allows events to be written to a sequence in any order, for example
+   one voice at a time in a polyphonic synth, and still produce a valid
+   sequence.  The free space remaining in the forge buffer is used as scratch
+   space for lv2_atom_sequence_sort(), so this does not allocate memory and is
+   realtime safe.  Sorting is fastest if the buffer has room for another copy
+   of the events, otherwise they are sorted in place.
+
+   @param forge The forge.
+   @param frame The frame of the sequence, as written by
+   lv2_atom_forge_sequence_head().
+   @param beat_time URID of atom:beatTime, or 0 if beat time is not supported.
+   @return True on success, or false if the sequence could not be sorted (for
+   example because the output overflowed before the sequence header).
+*/
+static inline bool
+lv2_atom_forge_pop_sequence_sorted(LV2_Atom_Forge*       forge,
+                                   LV2_Atom_Forge_Frame* frame,
+                                   uint32_t              beat_time)
+{
+	lv2_atom_forge_pop(forge, frame);
+	if (!frame->ref) {
+		return false;
+	}
+
+	LV2_Atom* const atom = lv2_atom_forge_deref(forge, frame->ref);
+	if (atom->type != forge->Sequence) {
+		return false;
+	}
+
+	// Use the rest of the buffer as scratch space (there is none with a sink)
+	return lv2_atom_sequence_sort(
+		(LV2_Atom_Sequence*)atom,
+		beat_time,
+		forge->buf ? forge->buf + forge->offset : NULL,
+		forge->buf ? forge->size - forge->offset : 0);
+}
+
+/**
+   @}
+   @name Validation
+   @{
+*/
+
+/** The maximum depth of nested containers accepted by lv2_atom_validate(). */
+#define LV2_ATOM_VALIDATE_MAX_DEPTH 32
+
+/**
+   Return true iff the body of `atom`, which is not a container, is valid.
+   Used internally.
+*/
+static inline bool
+lv2_atom_validate_leaf(const LV2_Atom_Forge* forge, const LV2_Atom* atom)
+{
+	const uint32_t    type = atom->type;
+	const uint32_t    size = atom->size;
+	const char* const body = (const char*)LV2_ATOM_BODY_CONST(atom);
+	if (type == forge->Int || type == forge->Float ||
+	    type == forge->Bool || type == forge->URID) {
+		return size == sizeof(int32_t);
+	} else if (type == forge->Long || type == forge->Double) {
+		return size == sizeof(int64_t);
+	} else if (type == forge->String || type == forge->Path ||
+	           type == forge->URI) {
+		return size > 0 && body[size - 1] == '\0';
+	} else if (type == forge->Literal) {
+		return (size > sizeof(LV2_Atom_Literal_Body) &&
+		        body[size - 1] == '\0');
+	} else if (type == forge->Vector) {
+		const LV2_Atom_Vector_Body* vec = (const LV2_Atom_Vector_Body*)body;
+		if (size < sizeof(LV2_Atom_Vector_Body)) {
+			return false;
+		}
+		const uint32_t n_bytes = size - (uint32_t)sizeof(LV2_Atom_Vector_Body);
+		return (vec->child_size ? n_bytes % vec->child_size == 0
+		        : n_bytes == 0);
+	}
+	return true;
+}
+
+/**
+   Check that `atom` is well-formed, with time units.
+
+   This is like lv2_atom_validate(), but sequences with unit `frame_time` are
+   checked like those with a unit of 0, and events in sequences with unit
+   `beat_time` must be in beat time order.  Sequences with any other unit are
+   not checked for order.
+
+   @param forge A forge initialised with lv2_atom_forge_init().
+   @param atom The atom to check.
+   @param capacity The number of bytes available at `atom`.
+   @param frame_time URID of atom:frameTime, or 0.
+   @param beat_time URID of atom:beatTime, or 0.
+   @return True iff `atom` is valid.
+*/
+static inline bool
+lv2_atom_validate_units(const LV2_Atom_Forge* forge,
+                        const LV2_Atom*       atom,
+                        uint32_t              capacity,
+                        uint32_t              frame_time,
+                        uint32_t              beat_time)
+{
+	struct {
+		const uint8_t* body;    // Start of container body
+		uint32_t       offset;  // Offset of next child in body
+		uint32_t       size;    // Size of body
+		uint32_t       type;    // Container type (forge->Tuple, Object, ...)
+		bool           beats;   // Sequence is in beat time
+		int64_t        time;    // Time of last event in a frame sequence
+		double         beat;    // Time of last event in a beat sequence
+	} stack[LV2_ATOM_VALIDATE_MAX_DEPTH];
+
+	if (capacity < sizeof(LV2_Atom) ||
+	    atom->size > capacity - (uint32_t)sizeof(LV2_Atom)) {
+		return false;
+	}
+
+	uint32_t depth = 0;
+	for (const LV2_Atom* child = atom; child;) {
+		// Check the bounds of `child`, then push it if it is a container
+		uint32_t type = child->type;
+		if (lv2_atom_forge_is_object_type(forge, type)) {
+			type = forge->Object;
+		}
+		if (type == forge->Tuple || type == forge->Object ||
+		    type == forge->Sequence) {
+			const uint32_t head = (type == forge->Tuple)
+				? 0 : (uint32_t)sizeof(LV2_Atom_Object_Body);
+			if (depth == LV2_ATOM_VALIDATE_MAX_DEPTH || child->size < head) {
+				return false;
+			}
+			stack[depth].body   = (const uint8_t*)(child + 1);
+			stack[depth].offset = head;
+			stack[depth].size   = child->size;
+			stack[depth].type   = type;
+			stack[depth].beats  = false;
+			stack[depth].time   = INT64_MIN;
+			stack[depth].beat   = -DBL_MAX;
+			if (type == forge->Sequence) {
+				const uint32_t unit =
+					((const LV2_Atom_Sequence*)child)->body.unit;
+				if (unit && unit == beat_time) {
+					stack[depth].beats = true;
+				} else if (unit && unit != frame_time) {
+					stack[depth].type = 0;  // Sequence with unknown time unit
+				}
+			}
+			++depth;
+		} else if (!lv2_atom_validate_leaf(forge, child)) {
+			return false;
+		}
+
+		// Find the next child, popping any finished containers
+		for (child = NULL; depth && !child;) {
+			const uint32_t offset = stack[depth - 1].offset;
+			const uint32_t size   = stack[depth - 1].size;
+			const uint8_t* pos    = stack[depth - 1].body + offset;
+			if (offset >= size) {
+				--depth;
+				continue;
+			}
+
+			// Find the child atom in the next record of the container
+			uint32_t head = 0;
+			if (stack[depth - 1].type == forge->Object) {
+				head = 2 * (uint32_t)sizeof(uint32_t);  // Key and context
+			} else if (stack[depth - 1].type != forge->Tuple) {
+				head = (uint32_t)sizeof(int64_t);  // Time stamp
+			}
+			if (size - offset < head + (uint32_t)sizeof(LV2_Atom)) {
+				return false;
+			}
+
+			child = (const LV2_Atom*)(pos + head);
+			if (child->size > size - offset - head - sizeof(LV2_Atom)) {
+				return false;
+			} else if (stack[depth - 1].beats) {
+				const double beat = ((const LV2_Atom_Event*)pos)->time.beats;
+				if (!(beat >= stack[depth - 1].beat)) {
+					return false;  // Out of order, or NaN
+				}
+				stack[depth - 1].beat = beat;
+			} else if (stack[depth - 1].type == forge->Sequence) {
+				const int64_t time = ((const LV2_Atom_Event*)pos)->time.frames;
+				if (time < stack[depth - 1].time) {
+					return false;
+				}
+				stack[depth - 1].time = time;
+			}
+
+			// Advance to the next record, which is padded to 64 bits
+			const uint64_t next =
+				((uint64_t)offset + head + lv2_atom_total_size(child) + 7U) &
+				~(uint64_t)7U;
+			stack[depth - 1].offset = (next < size) ? (uint32_t)next : size;
+		}
+	}
+
+	return true;
+}
+
+/**
+   Check that `atom` is well-formed and fits within `capacity` bytes.
+
+   This checks that the size of every atom fits within its container (and the
+   top level atom fits in `capacity`), that containers have valid headers,
+   that events in sequences with frame time stamps are in time order, and that
+   the bodies of standard types have valid sizes: for example, that an Int is
+   4 bytes and a String is null terminated.  The types of property values are
+   not checked, since they depend on the application.
+
+   The forge does not know the URIDs of time units, so the order of events is
+   only checked in sequences with a unit of 0, which is frame time.  Use
+   lv2_atom_validate_units() to also check sequences with an explicit unit.
+
+   Atoms are checked in a single linear pass without recursion, so this is
+   realtime safe and fast enough to call on every incoming message, for
+   example on control ports that receive data from a UI or the network.  If
+   this returns true, the unchecked iterators in util.h can safely be used on
+   the atom, and any strings in it can safely be used as C strings.
+
+   The forge is only used for its type URIDs, so it does not need a buffer.
+
+   @param forge A forge initialised with lv2_atom_forge_init().
+   @param atom The atom to check.
+   @param capacity The number of bytes available at `atom`, including the
+   header.  For an input port, this is usually lv2_atom_total_size(atom).
+   @return True iff `atom` is valid.  Containers nested more than
+   LV2_ATOM_VALIDATE_MAX_DEPTH levels deep are considered invalid.
+*/
+static inline bool
+lv2_atom_validate(const LV2_Atom_Forge* forge,
+                  const LV2_Atom*       atom,
+                  uint32_t              capacity)
+{
+	return lv2_atom_validate_units(forge, atom, capacity, 0, 0);
+}
+
+/**
+   Check that `seq` is a well-formed Sequence that fits in `capacity` bytes.
+   See lv2_atom_validate() for details.
+*/
+static inline bool
+lv2_atom_sequence_validate(const LV2_Atom_Forge*    forge,
+                           const LV2_Atom_Sequence* seq,
+                           uint32_t                 capacity)
+{
+	return (capacity >= sizeof(LV2_Atom) &&
+	        seq->atom.type == forge->Sequence &&
+	        lv2_atom_validate(forge, &seq->atom, capacity));
+}
+
+/**
+   Check that `obj` is a well-formed Object that fits in `capacity` bytes.
+   See lv2_atom_validate() for details.
+*/
+static inline bool
+lv2_atom_object_validate(const LV2_Atom_Forge*  forge,
+                         const LV2_Atom_Object* obj,
+                         uint32_t               capacity)
+{
+	return (capacity >= sizeof(LV2_Atom) &&
+	        lv2_atom_forge_is_object_type(forge, obj->atom.type) &&
+	        lv2_atom_validate(forge, &obj->atom, capacity));
+}
+
 /**
    @}
 */
@@ -0,0 +1,415 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file forge.hpp A typed forge and reader for fixed-shape objects in C++.
+
+   Many messages always have the same shape: an object with a fixed set of
+   properties that have scalar values, like a UI state update or a transport
+   position.  Building these with the C forge checks space, pads, and updates
+   the parent frames once per property.  This header describes such a message
+   as a C++ type, so its exact size and layout are known at compile time, and
+   it is written with a single space check followed by direct stores.
+
+   The schema is the list of value types, which must be int32_t (Int),
+   int64_t (Long), float (Float), double (Double), bool (Bool), or uint32_t
+   (URID).  Keys and the object type are URIDs, so they are given when the
+   schema is instantiated, typically after mapping URIs in instantiate().
+
+   For example:
+   @code
+   // An object with a Float bar beat, Float tempo, and Long frame
+   typedef lv2::atom::Object<float, float, int64_t> PositionMessage;
+
+   const LV2_URID   keys[] = { uris.time_barBeat,
+                               uris.time_beatsPerMinute,
+                               uris.time_frame };
+   PositionMessage  position(&forge, uris.time_Position, keys);
+
+   // In run()
+   position.write_event(&forge, offset, beat, bpm, frame);
+
+   // When reading
+   float   beat, bpm;
+   int64_t frame;
+   if (position.read(obj, beat, bpm, frame)) {
+       ...
+   }
+   @endcode
+
+   Reading is zero-copy: if an object has exactly the layout the schema would
+   write, every value is loaded from a fixed offset, otherwise the properties
+   are searched by key, so objects written by other code are still read
+   correctly.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_FORGE_HPP
+#define LV2_ATOM_FORGE_HPP
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+namespace lv2 {
+namespace atom {
+
+/**
+   @defgroup forge_hpp Typed Forge
+   @ingroup atom
+   @{
+*/
+
+namespace detail {
+
+/** Pad a size to a multiple of 64 bits at compile time. */
+constexpr uint32_t
+pad_size(uint32_t size)
+{
+	return (size + 7U) & (~7U);
+}
+
+/** The atom type of a C++ value type, and how it is stored. */
+template<typename T> struct Scalar;
+
+template<> struct Scalar<int32_t> {
+	typedef int32_t Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Int; }
+};
+
+template<> struct Scalar<int64_t> {
+	typedef int64_t Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Long; }
+};
+
+template<> struct Scalar<float> {
+	typedef float Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Float; }
+};
+
+template<> struct Scalar<double> {
+	typedef double Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Double; }
+};
+
+template<> struct Scalar<bool> {
+	typedef int32_t Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Bool; }
+};
+
+template<> struct Scalar<uint32_t> {
+	typedef uint32_t Body;
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->URID; }
+};
+
+/** A property with a value of type `T`. */
+template<typename T>
+struct Property {
+	typedef typename Scalar<T>::Body Body;
+
+	/** Total size of the property, including padding. */
+	static constexpr uint32_t size =
+		pad_size(sizeof(LV2_Atom_Property_Body) + sizeof(Body));
+
+	static void store(uint8_t* out, LV2_URID key, LV2_URID type, T value)
+	{
+		LV2_Atom_Property_Body* const prop = (LV2_Atom_Property_Body*)out;
+		const Body                    body = static_cast<Body>(value);
+
+		prop->key        = key;
+		prop->context    = 0;
+		prop->value.size = sizeof(Body);
+		prop->value.type = type;
+		memcpy(out + sizeof(LV2_Atom_Property_Body), &body, sizeof(Body));
+		memset(out + sizeof(LV2_Atom_Property_Body) + sizeof(Body), 0,
+		       size - sizeof(LV2_Atom_Property_Body) - sizeof(Body));
+	}
+
+	static bool matches(const LV2_Atom_Property_Body* prop, LV2_URID type)
+	{
+		return prop->value.type == type && prop->value.size == sizeof(Body);
+	}
+
+	static T load(const LV2_Atom_Property_Body* prop)
+	{
+		Body body;
+		memcpy(&body, prop + 1, sizeof(Body));
+		return static_cast<T>(body);
+	}
+};
+
+/** A list of properties, which are laid out in order. */
+template<typename... Ts> struct Properties;
+
+template<>
+struct Properties<> {
+	static constexpr uint32_t size = 0;
+
+	static void store(uint8_t*, const LV2_URID*, const LV2_URID*) {}
+
+	static bool matches(const uint8_t*, const LV2_URID*, const LV2_URID*)
+	{
+		return true;
+	}
+
+	static void load(const uint8_t*) {}
+
+	static bool assign(uint32_t, const LV2_Atom_Property_Body*, const LV2_URID*)
+	{
+		return false;
+	}
+};
+
+template<typename T, typename... Ts>
+struct Properties<T, Ts...> {
+	typedef Property<T>       Head;
+	typedef Properties<Ts...> Tail;
+
+	static constexpr uint32_t size = Head::size + Tail::size;
+
+	static void store(uint8_t*        out,
+	                  const LV2_URID* keys,
+	                  const LV2_URID* types,
+	                  T               value,
+	                  Ts...           values)
+	{
+		Head::store(out, keys[0], types[0], value);
+		Tail::store(out + Head::size, keys + 1, types + 1, values...);
+	}
+
+	static bool matches(const uint8_t*  in,
+	                    const LV2_URID* keys,
+	                    const LV2_URID* types)
+	{
+		const LV2_Atom_Property_Body* prop = (const LV2_Atom_Property_Body*)in;
+		return prop->key == keys[0] && prop->context == 0 &&
+			Head::matches(prop, types[0]) &&
+			Tail::matches(in + Head::size, keys + 1, types + 1);
+	}
+
+	static void load(const uint8_t* in, T& value, Ts&... values)
+	{
+		value = Head::load((const LV2_Atom_Property_Body*)in);
+		Tail::load(in + Head::size, values...);
+	}
+
+	/** Load the `i`th value from `prop` if it has the expected type. */
+	static bool assign(uint32_t                      i,
+	                   const LV2_Atom_Property_Body* prop,
+	                   const LV2_URID*               types,
+	                   T&                            value,
+	                   Ts&...                        values)
+	{
+		if (i == 0) {
+			if (Head::matches(prop, types[0])) {
+				value = Head::load(prop);
+				return true;
+			}
+			return false;
+		}
+		return Tail::assign(i - 1, prop, types + 1, values...);
+	}
+};
+
+}  // namespace detail
+
+/**
+   An object with properties of the given value types, in order.
+
+   An instance holds the URIDs of the object type and keys, and writes or
+   reads objects with exactly those properties.  Writing is realtime safe.
+*/
+template<typename... Fields>
+class Object {
+public:
+	static_assert(sizeof...(Fields) > 0, "Object schema has no fields");
+	static_assert(sizeof...(Fields) <= 32, "Object schema has too many fields");
+
+	typedef detail::Properties<Fields...> Properties;
+
+	/** Number of properties. */
+	static constexpr uint32_t n_fields = sizeof...(Fields);
+
+	/** Size of the object body, which is the `size` of the atom. */
+	static constexpr uint32_t body_size =
+		sizeof(LV2_Atom_Object_Body) + Properties::size;
+
+	/** Total size of the object, including the atom header. */
+	static constexpr uint32_t size = sizeof(LV2_Atom) + body_size;
+
+	/** Total size of the object as an event in a sequence. */
+	static constexpr uint32_t event_size = sizeof(LV2_Atom_Event) + body_size;
+
+	/**
+	   Set up a schema instance.
+
+	   @param forge Forge with mapped URIDs, which is only used here to get
+	   the atom types of the values.
+	   @param otype Object type written by write().
+	   @param keys Keys of the properties, in order.
+	*/
+	Object(const LV2_Atom_Forge* forge,
+	       LV2_URID              otype,
+	       const LV2_URID        (&keys)[sizeof...(Fields)])
+		: _object(forge->Object)
+		, _otype(otype)
+		, _types{ detail::Scalar<Fields>::type(forge)... }
+	{
+		memcpy(_keys, keys, sizeof(_keys));
+	}
+
+	/**
+	   Write an object with the given property values.
+
+	   If the forge writes to a buffer, this checks for space once then stores
+	   directly into it, otherwise the object is built on the stack and written
+	   to the sink at once.
+
+	   @return A reference to the object, or 0 if there is not enough space,
+	   in which case nothing is written.
+	*/
+	LV2_Atom_Forge_Ref write(LV2_Atom_Forge* forge, Fields... values) const
+	{
+		if (!forge->buf) {
+			uint64_t buf[size / sizeof(uint64_t)];
+			store((uint8_t*)buf, values...);
+			return lv2_atom_forge_raw(forge, buf, size);
+		}
+
+		uint8_t* const out = (uint8_t*)lv2_atom_forge_reserve(forge, size);
+		if (out) {
+			store(out, values...);
+		}
+		return (LV2_Atom_Forge_Ref)out;
+	}
+
+	/**
+	   Write an event with a time in frames and an object with the given
+	   property values.
+
+	   This is equivalent to lv2_atom_forge_frame_time() followed by write(),
+	   but the event is written in one step, so either all of it is written or
+	   nothing is.
+
+	   @return A reference to the event, or 0 if there is not enough space.
+	*/
+	LV2_Atom_Forge_Ref write_event(LV2_Atom_Forge* forge,
+	                               int64_t         frames,
+	                               Fields...       values) const
+	{
+		if (!forge->buf) {
+			uint64_t buf[event_size / sizeof(uint64_t)];
+			memcpy(buf, &frames, sizeof(frames));
+			store((uint8_t*)(buf + 1), values...);
+			return lv2_atom_forge_raw(forge, buf, event_size);
+		}
+
+		uint8_t* const out =
+			(uint8_t*)lv2_atom_forge_reserve(forge, event_size);
+		if (out) {
+			memcpy(out, &frames, sizeof(frames));
+			store(out + sizeof(frames), values...);
+		}
+		return (LV2_Atom_Forge_Ref)out;
+	}
+
+	/**
+	   Read the property values of `obj`.
+
+	   This does not check the type or otype of `obj`, and ignores any
+	   properties that are not in the schema.  Values with the wrong type are
+	   treated as missing, and the corresponding output is not changed.
+
+	   @return True if every property was found.
+	*/
+	bool read(const LV2_Atom_Object* obj, Fields&... values) const
+	{
+		const uint8_t* const props = (const uint8_t*)(obj + 1);
+		if (obj->atom.size == body_size &&
+		    Properties::matches(props, _keys, _types)) {
+			// Exact layout, load directly from fixed offsets
+			Properties::load(props, values...);
+			return true;
+		}
+
+		// Search for each property by key
+		const uint32_t all   = UINT32_MAX >> (32 - n_fields);
+		uint32_t       found = 0;
+		for (const LV2_Atom_Property_Body* prop = lv2_atom_object_begin(&obj->body);
+		     !lv2_atom_object_is_end(&obj->body, obj->atom.size, prop);
+		     prop = lv2_atom_object_next(prop)) {
+			for (uint32_t i = 0; i < n_fields; ++i) {
+				if (prop->key == _keys[i] && !(found & (1U << i))) {
+					if (Properties::assign(i, prop, _types, values...)) {
+						found |= (1U << i);
+					}
+					break;
+				}
+			}
+			if (found == all) {
+				break;
+			}
+		}
+		return found == all;
+	}
+
+	/** Object type written by write(). */
+	LV2_URID otype() const { return _otype; }
+
+	/** Key of the `i`th property. */
+	LV2_URID key(uint32_t i) const { return _keys[i]; }
+
+private:
+	void store(uint8_t* out, Fields... values) const
+	{
+		LV2_Atom_Object* const obj = (LV2_Atom_Object*)out;
+		obj->atom.size  = body_size;
+		obj->atom.type  = _object;
+		obj->body.id    = 0;
+		obj->body.otype = _otype;
+		Properties::store(out + sizeof(LV2_Atom_Object), _keys, _types, values...);
+	}
+
+	LV2_URID _object;
+	LV2_URID _otype;
+	LV2_URID _types[sizeof...(Fields)];
+	LV2_URID _keys[sizeof...(Fields)];
+};
+
+template<typename... Fields>
+constexpr uint32_t Object<Fields...>::n_fields;
+
+template<typename... Fields>
+constexpr uint32_t Object<Fields...>::body_size;
+
+template<typename... Fields>
+constexpr uint32_t Object<Fields...>::size;
+
+template<typename... Fields>
+constexpr uint32_t Object<Fields...>::event_size;
+
+/**
+   @}
+*/
+
+}  // namespace atom
+}  // namespace lv2
+
+#endif  /* LV2_ATOM_FORGE_HPP */
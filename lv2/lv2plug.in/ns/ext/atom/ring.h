@@ -0,0 +1,335 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file ring.h A ring buffer of atoms for passing messages between threads.
+
+   This is a wait-free single-producer single-consumer queue of atoms, which
+   works as a forge sink, so atoms can be forged directly into the queue (for
+   example in run()) and read in place by another thread (for example a worker
+   or UI thread), without any intermediate copies.
+
+   Every atom in the ring is contiguous in memory.  If a message would cross
+   the end of the buffer, the part already written is moved to the start of
+   the buffer, which is safe since forge references are relative to the start
+   of the message.  Messages are only visible to the reader once they have
+   been committed, so a message that overflows the ring is simply discarded.
+
+   For example, the writer does:
+   @code
+   lv2_atom_ring_begin(&self->ring, &self->forge);
+   LV2_Atom_Forge_Frame frame;
+   lv2_atom_forge_object(&self->forge, &frame, 0, uris->eg_Message);
+   ...
+   lv2_atom_forge_pop(&self->forge, &frame);
+   lv2_atom_ring_commit(&self->ring);
+   @endcode
+
+   And the reader does:
+   @code
+   for (const LV2_Atom* msg; (msg = lv2_atom_ring_peek(&self->ring));) {
+       handle_message(msg);
+       lv2_atom_ring_pop(&self->ring);
+   }
+   @endcode
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_RING_H
+#define LV2_ATOM_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup ring Ring
+   @ingroup atom
+   @{
+*/
+
+/** Size of the marker written where a message wraps to the start. */
+#define LV2_ATOM_RING_MARKER_SIZE ((uint32_t)sizeof(LV2_Atom))
+
+/**
+   A single-producer single-consumer ring buffer of atoms.
+
+   Positions are free running counters, so the ring is empty when the heads
+   are equal and full when they differ by the size of the buffer.  Fields are
+   private, only one thread may write and only one thread may read.
+*/
+typedef struct {
+	uint8_t*          buf;         /**< Buffer */
+	uint32_t          size;        /**< Size of buffer, a power of two */
+	volatile uint32_t write_head;  /**< End of committed messages */
+	volatile uint32_t read_head;   /**< Start of unread messages */
+	uint32_t          msg_start;   /**< Start of message being written */
+	uint32_t          msg_end;     /**< End of message being written */
+	bool              overflow;    /**< Message being written did not fit */
+} LV2_Atom_Ring;
+
+/** Load a head written by the other thread.  Used internally. */
+static inline uint32_t
+lv2_atom_ring_load(const volatile uint32_t* head)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n(head, __ATOMIC_ACQUIRE);
+#else
+	return (uint32_t)_InterlockedOr((volatile long*)head, 0);
+#endif
+}
+
+/** Store a head read by the other thread.  Used internally. */
+static inline void
+lv2_atom_ring_store(volatile uint32_t* head, uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__atomic_store_n(head, value, __ATOMIC_RELEASE);
+#else
+	_InterlockedExchange((volatile long*)head, (long)value);
+#endif
+}
+
+/**
+   Initialise `ring` to use `buf` for storage.
+
+   @param ring The ring to initialise.
+   @param buf Buffer, which must be 64-bit aligned.
+   @param size Size of `buf`, which must be a power of two at least 16.
+   @return True on success, or false if `size` is invalid.
+*/
+static inline bool
+lv2_atom_ring_init(LV2_Atom_Ring* ring, void* buf, uint32_t size)
+{
+	memset(ring, 0, sizeof(LV2_Atom_Ring));
+	if (size < 2 * LV2_ATOM_RING_MARKER_SIZE || (size & (size - 1))) {
+		return false;
+	}
+
+	ring->buf  = (uint8_t*)buf;
+	ring->size = size;
+	return true;
+}
+
+/** Return the number of bytes of committed messages not yet read. */
+static inline uint32_t
+lv2_atom_ring_read_space(const LV2_Atom_Ring* ring)
+{
+	return lv2_atom_ring_load(&ring->write_head) - ring->read_head;
+}
+
+/** Return the number of bytes free for writing. */
+static inline uint32_t
+lv2_atom_ring_write_space(const LV2_Atom_Ring* ring)
+{
+	return ring->size - (ring->write_head - lv2_atom_ring_load(&ring->read_head));
+}
+
+/**
+   @name Writing
+   @{
+*/
+
+/**
+   Forge sink that writes to the current message in a ring.
+
+   This makes room for `size` more bytes in the message, moving it to the
+   start of the buffer if it would otherwise cross the end, then copies `data`
+   into it.  References are offsets from the start of the message, plus one.
+*/
+static inline LV2_Atom_Forge_Ref
+lv2_atom_ring_sink(LV2_Atom_Forge_Sink_Handle handle,
+                   const void*                data,
+                   uint32_t                   size)
+{
+	LV2_Atom_Ring* const ring = (LV2_Atom_Ring*)handle;
+	if (ring->overflow) {
+		return 0;
+	}
+
+	const uint32_t mask  = ring->size - 1;
+	const uint32_t read  = lv2_atom_ring_load(&ring->read_head);
+	const uint32_t start = ring->msg_start & mask;
+	const uint32_t len   = ring->msg_end - ring->msg_start;
+	const uint32_t used  = ring->msg_end - read;
+	if ((uint64_t)start + len + size <= ring->size) {
+		// Enough space before the end of the buffer
+		if ((uint64_t)used + size > ring->size) {
+			ring->overflow = true;
+			return 0;
+		}
+	} else {
+		// Move the message to the start of the buffer, if it is free
+		const uint32_t tail = ring->size - start;
+		if (start == 0 ||
+		    (uint64_t)used + tail + size > ring->size) {
+			ring->overflow = true;
+			return 0;
+		}
+
+		memcpy(ring->buf, ring->buf + start, len);
+
+		LV2_Atom* const marker = (LV2_Atom*)(ring->buf + start);
+		marker->size = UINT32_MAX;
+		marker->type = 0;
+
+		ring->msg_start += tail;
+		ring->msg_end   += tail;
+	}
+
+	memcpy(ring->buf + (ring->msg_end & mask), data, size);
+	ring->msg_end += size;
+	return (LV2_Atom_Forge_Ref)(ring->msg_end - size - ring->msg_start) + 1;
+}
+
+/** Forge deref function for a ring, see lv2_atom_ring_sink(). */
+static inline LV2_Atom*
+lv2_atom_ring_deref(LV2_Atom_Forge_Sink_Handle handle, LV2_Atom_Forge_Ref ref)
+{
+	LV2_Atom_Ring* const ring  = (LV2_Atom_Ring*)handle;
+	const uint32_t       start = ring->msg_start & (ring->size - 1);
+	return (LV2_Atom*)(ring->buf + start + (uint32_t)(ref - 1));
+}
+
+/**
+   Begin writing a message to `ring` with `forge`.
+
+   This sets the sink of `forge`, so the next atom written to it (typically a
+   container, with everything inside it) becomes the message.  Any message
+   that was begun but not committed is discarded.  This is only called by the
+   writing thread, and is realtime safe.
+*/
+static inline void
+lv2_atom_ring_begin(LV2_Atom_Ring* ring, LV2_Atom_Forge* forge)
+{
+	ring->msg_start = ring->msg_end = ring->write_head;
+	ring->overflow  = false;
+	lv2_atom_forge_set_sink(forge, lv2_atom_ring_sink, lv2_atom_ring_deref, ring);
+}
+
+/**
+   Commit the message being written to `ring`, making it visible to the reader.
+
+   All frames in the message must be popped first.  This is only called by the
+   writing thread, and is realtime safe.
+
+   @return True on success, or false if the message overflowed the ring and was
+   discarded, or is empty.
+*/
+static inline bool
+lv2_atom_ring_commit(LV2_Atom_Ring* ring)
+{
+	if (ring->overflow || ring->msg_end == ring->msg_start) {
+		ring->msg_end = ring->msg_start;
+		return false;
+	}
+
+	lv2_atom_ring_store(&ring->write_head, ring->msg_end);
+	ring->msg_start = ring->msg_end;
+	return true;
+}
+
+/**
+   Write a copy of `atom` to `ring` as a message.
+
+   This is a convenience for sending an atom that already exists, it is
+   equivalent to lv2_atom_ring_begin(), lv2_atom_forge_write(), and
+   lv2_atom_ring_commit().
+*/
+static inline bool
+lv2_atom_ring_write(LV2_Atom_Ring*  ring,
+                    LV2_Atom_Forge* forge,
+                    const LV2_Atom* atom)
+{
+	lv2_atom_ring_begin(ring, forge);
+	lv2_atom_forge_write(forge, atom, lv2_atom_total_size(atom));
+	return lv2_atom_ring_commit(ring);
+}
+
+/**
+   @}
+   @name Reading
+   @{
+*/
+
+/**
+   Return the next message in `ring`, or NULL if there are none.
+
+   The returned atom is contiguous in memory, and remains valid until
+   lv2_atom_ring_pop() is called.  This is only called by the reading thread,
+   and is realtime safe.
+*/
+static inline const LV2_Atom*
+lv2_atom_ring_peek(LV2_Atom_Ring* ring)
+{
+	const uint32_t write = lv2_atom_ring_load(&ring->write_head);
+	if (ring->read_head == write) {
+		return NULL;
+	}
+
+	const uint32_t  offset = ring->read_head & (ring->size - 1);
+	const LV2_Atom* atom   = (const LV2_Atom*)(ring->buf + offset);
+	if (atom->type == 0 && atom->size == UINT32_MAX) {
+		// Skip marker to the message at the start of the buffer
+		lv2_atom_ring_store(&ring->read_head,
+		                    ring->read_head + ring->size - offset);
+		atom = (const LV2_Atom*)ring->buf;
+	}
+	return atom;
+}
+
+/**
+   Remove the next message from `ring`, after reading it with
+   lv2_atom_ring_peek().
+
+   This frees the space used by the message for writing.  This is only called
+   by the reading thread, and is realtime safe.
+*/
+static inline void
+lv2_atom_ring_pop(LV2_Atom_Ring* ring)
+{
+	const LV2_Atom* atom = lv2_atom_ring_peek(ring);
+	if (atom) {
+		lv2_atom_ring_store(
+			&ring->read_head,
+			ring->read_head + lv2_atom_pad_size(lv2_atom_total_size(atom)));
+	}
+}
+
+/**
+   @}
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_ATOM_RING_H */
@@ -0,0 +1,344 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file template.h Pre-forged messages with fields patched when sent.
+
+   Plugins often send messages with the same structure many times, where only
+   a few values change, like a UI state update or a patch:Set of some
+   property.  A template is such a message forged once, for example in
+   instantiate(), along with the offsets of the values that change.  Sending
+   it is then a single copy of the whole message and a store to each field,
+   rather than a forge call for every atom in it.
+
+   The last atom in the message may have a variable size, like the path in a
+   patch:Set message for a file.  This "tail" is given when the message is
+   sent, and the size of every container around it is adjusted accordingly.
+
+   For example, to build a template:
+   @code
+   LV2_Atom_Forge_Frame frame;
+   lv2_atom_template_begin(&self->tmpl, &self->forge);
+   lv2_atom_forge_object(&self->forge, &frame, 0, uris->patch_Set);
+   lv2_atom_forge_key(&self->forge, uris->patch_property);
+   lv2_atom_forge_urid(&self->forge, uris->eg_gain);
+   lv2_atom_forge_key(&self->forge, uris->patch_value);
+   self->gain_field = lv2_atom_template_field(
+       &self->tmpl, lv2_atom_forge_float(&self->forge, 0.0f));
+   lv2_atom_forge_pop(&self->forge, &frame);
+   if (!lv2_atom_template_end(&self->tmpl)) {
+       // Error
+   }
+   @endcode
+
+   Then to send it, in run():
+   @code
+   LV2_Atom* msg = lv2_atom_template_write(&self->tmpl, &self->forge);
+   if (msg) {
+       lv2_atom_template_set_float(msg, self->gain_field, self->gain);
+   }
+   @endcode
+
+   Templates are built in an LV2_Atom_Arena, so building is not realtime
+   safe, but writing is.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_ATOM_TEMPLATE_H
+#define LV2_ATOM_TEMPLATE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/arena.h"
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup template Template
+   @ingroup atom
+   @{
+*/
+
+/** The maximum number of containers around the tail of a template. */
+#define LV2_ATOM_TEMPLATE_MAX_DEPTH 8
+
+/** A pre-forged message.  Fields are private. */
+typedef struct {
+	LV2_Atom_Arena arena;      /**< Storage for the message */
+	uint32_t       tail;       /**< Offset of the tail atom, or 0 */
+	uint32_t       n_parents;  /**< Number of containers around the tail */
+	uint32_t       parents[LV2_ATOM_TEMPLATE_MAX_DEPTH];  /**< Their offsets */
+	bool           error;      /**< True if the template is invalid */
+} LV2_Atom_Template;
+
+/**
+   @name Building
+   @{
+*/
+
+/**
+   Begin building a template with `forge`.
+
+   This sets `forge` to write to the template, so the next atom written to it
+   (typically an object, with everything inside it) becomes the message.  The
+   forge must be set to some other output again before it is used to write
+   anything else.
+
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+lv2_atom_template_begin(LV2_Atom_Template* tmpl, LV2_Atom_Forge* forge)
+{
+	memset(tmpl, 0, sizeof(LV2_Atom_Template));
+	if (!lv2_atom_arena_init(&tmpl->arena, 64)) {
+		tmpl->error = true;
+		return false;
+	}
+
+	lv2_atom_arena_begin(&tmpl->arena, forge);
+	return true;
+}
+
+/**
+   Return the field for the value of the atom written to a template at `ref`.
+
+   This is typically called with the return value of a forge method, for
+   example `lv2_atom_template_field(tmpl, lv2_atom_forge_int(forge, 0))`.  The
+   value may be set when the template is written with the setter for its type,
+   like lv2_atom_template_set_int(), so the type of the value must not change.
+
+   @return The offset of the body of the atom in the message.
+*/
+static inline uint32_t
+lv2_atom_template_field(LV2_Atom_Template* tmpl, LV2_Atom_Forge_Ref ref)
+{
+	if (!ref) {
+		tmpl->error = true;
+		return 0;
+	}
+	return (uint32_t)(ref - 1) + (uint32_t)sizeof(LV2_Atom);
+}
+
+/**
+   Mark the next atom written to a template as the tail.
+
+   The tail is the atom at the end of the message that is replaced when the
+   template is written with lv2_atom_template_write_tail().  It must be the
+   last atom written, apart from closing the containers around it, and may not
+   be the message itself.  The type of the tail is kept, only its body is
+   replaced.
+*/
+static inline void
+lv2_atom_template_mark_tail(LV2_Atom_Template* tmpl, LV2_Atom_Forge* forge)
+{
+	tmpl->tail      = tmpl->arena.size;
+	tmpl->n_parents = 0;
+	for (LV2_Atom_Forge_Frame* f = forge->stack; f; f = f->parent) {
+		if (!f->ref || tmpl->n_parents == LV2_ATOM_TEMPLATE_MAX_DEPTH) {
+			tmpl->error = true;
+			return;
+		}
+		tmpl->parents[tmpl->n_parents++] = (uint32_t)(f->ref - 1);
+	}
+
+	if (!tmpl->tail || !tmpl->n_parents) {
+		tmpl->error = true;
+	}
+}
+
+/**
+   Finish building a template.
+
+   All containers in the message must be popped first.
+
+   @return The message, or NULL if the template is invalid, for example because
+   allocation failed or the tail is not at the end of the message.
+*/
+static inline const LV2_Atom*
+lv2_atom_template_end(LV2_Atom_Template* tmpl)
+{
+	const LV2_Atom* const atom = lv2_atom_arena_get(&tmpl->arena);
+	if (!atom ||
+	    lv2_atom_pad_size(lv2_atom_total_size(atom)) != tmpl->arena.size) {
+		tmpl->error = true;
+	} else if (tmpl->tail) {
+		const LV2_Atom* const tail = (const LV2_Atom*)(
+			(const uint8_t*)atom + tmpl->tail);
+		if (tmpl->tail + sizeof(LV2_Atom) + lv2_atom_pad_size(tail->size) !=
+		    tmpl->arena.size) {
+			tmpl->error = true;
+		}
+	}
+
+	return tmpl->error ? NULL : atom;
+}
+
+/** Free the memory used by a template. */
+static inline void
+lv2_atom_template_free(LV2_Atom_Template* tmpl)
+{
+	lv2_atom_arena_free(&tmpl->arena);
+	tmpl->error = true;
+}
+
+/**
+   @}
+   @name Writing
+   @{
+*/
+
+/**
+   Write a copy of a template to `forge`.
+
+   The fields of the returned message should then be set to the values to
+   send.  This is realtime safe.
+
+   @return A pointer to the written message, which is valid until the next
+   write to `forge`, or NULL if there is not enough space or the template is
+   invalid.
+*/
+static inline LV2_Atom*
+lv2_atom_template_write(const LV2_Atom_Template* tmpl, LV2_Atom_Forge* forge)
+{
+	if (tmpl->error) {
+		return NULL;
+	}
+
+	const LV2_Atom* const    atom = (const LV2_Atom*)tmpl->arena.buf;
+	const LV2_Atom_Forge_Ref ref  = lv2_atom_forge_write(
+		forge, atom, lv2_atom_total_size(atom));
+	return ref ? lv2_atom_forge_deref(forge, ref) : NULL;
+}
+
+/**
+   Write a copy of a template to `forge` with a new tail.
+
+   The body of the tail atom is replaced with `size` bytes at `body`, and the
+   size of every container around it is adjusted.  For a string or path, the
+   body must include the null terminator.  This is realtime safe.
+
+   When writing to a buffer, nothing is written if the message does not fit.
+   A sink can not be rolled back, so if the sink fails part way through, the
+   part of the message already written is left in the output, as with any
+   other forge write.  The ring and arena sinks handle this themselves: the
+   ring discards a message that overflows when it is committed, and the arena
+   only fails when it can not allocate.
+
+   @return A pointer to the written message, which is valid until the next
+   write to `forge`, or NULL if there is not enough space or the template is
+   invalid or has no tail.
+*/
+static inline LV2_Atom*
+lv2_atom_template_write_tail(const LV2_Atom_Template* tmpl,
+                             LV2_Atom_Forge*          forge,
+                             const void*              body,
+                             uint32_t                 size)
+{
+	if (tmpl->error || !tmpl->tail) {
+		return NULL;
+	}
+
+	const uint8_t* const  atom   = tmpl->arena.buf;
+	const uint32_t        prefix = tmpl->tail + (uint32_t)sizeof(LV2_Atom);
+	const LV2_Atom* const tail   = (const LV2_Atom*)(atom + tmpl->tail);
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(forge);
+
+	const LV2_Atom_Forge_Ref ref = lv2_atom_forge_raw(forge, atom, prefix);
+	if (!ref || !lv2_atom_forge_write(forge, body, size)) {
+		if (forge->buf) {
+			lv2_atom_forge_rollback(forge, &checkpoint);
+		}
+		return NULL;
+	}
+
+	// Set the size of the tail and adjust the size of its containers
+	uint8_t* const copy     = (uint8_t*)lv2_atom_forge_deref(forge, ref);
+	const uint32_t old_size = lv2_atom_pad_size(tail->size);
+	const uint32_t new_size = lv2_atom_pad_size(size);
+	((LV2_Atom*)(copy + tmpl->tail))->size = size;
+	for (uint32_t i = 0; i < tmpl->n_parents; ++i) {
+		LV2_Atom* const parent = (LV2_Atom*)(copy + tmpl->parents[i]);
+		parent->size = parent->size - old_size + new_size;
+	}
+
+	return (LV2_Atom*)copy;
+}
+
+/** Set a field of a written template to `size` bytes at `value`. */
+static inline void
+lv2_atom_template_set(LV2_Atom*   msg,
+                      uint32_t    field,
+                      const void* value,
+                      uint32_t    size)
+{
+	memcpy((uint8_t*)msg + field, value, size);
+}
+
+/** Set an Int field of a written template. */
+static inline void
+lv2_atom_template_set_int(LV2_Atom* msg, uint32_t field, int32_t value)
+{
+	lv2_atom_template_set(msg, field, &value, sizeof(value));
+}
+
+/** Set a Long field of a written template. */
+static inline void
+lv2_atom_template_set_long(LV2_Atom* msg, uint32_t field, int64_t value)
+{
+	lv2_atom_template_set(msg, field, &value, sizeof(value));
+}
+
+/** Set a Float field of a written template. */
+static inline void
+lv2_atom_template_set_float(LV2_Atom* msg, uint32_t field, float value)
+{
+	lv2_atom_template_set(msg, field, &value, sizeof(value));
+}
+
+/** Set a Double field of a written template. */
+static inline void
+lv2_atom_template_set_double(LV2_Atom* msg, uint32_t field, double value)
+{
+	lv2_atom_template_set(msg, field, &value, sizeof(value));
+}
+
+/** Set a URID field of a written template. */
+static inline void
+lv2_atom_template_set_urid(LV2_Atom* msg, uint32_t field, LV2_URID value)
+{
+	lv2_atom_template_set(msg, field, &value, sizeof(value));
+}
+
+/**
+   @}
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_ATOM_TEMPLATE_H */
@@ -117,16 +117,220 @@ lv2_atom_sequence_next(const LV2_Atom_Event* i)
    @endcode
 */
 #define LV2_ATOM_SEQUENCE_FOREACH(seq, iter) \
-	for (LV2_Atom_Event* (iter) = lv2_atom_sequence_begin(&(seq)->body); \
+	for (LV2_Atom_Event* iter = lv2_atom_sequence_begin(&(seq)->body); \
 	     !lv2_atom_sequence_is_end(&(seq)->body, (seq)->atom.size, (iter)); \
 	     (iter) = lv2_atom_sequence_next(iter))
 
 /** Like LV2_ATOM_SEQUENCE_FOREACH but for a headerless sequence body. */
 #define LV2_ATOM_SEQUENCE_BODY_FOREACH(body, size, iter) \
-	for (LV2_Atom_Event* (iter) = lv2_atom_sequence_begin(body); \
+	for (LV2_Atom_Event* iter = lv2_atom_sequence_begin(body); \
 	     !lv2_atom_sequence_is_end(body, size, (iter)); \
 	     (iter) = lv2_atom_sequence_next(iter))
 
+/**
+   @}
+   @name Tempo Map
+   @{
+*/
+
+/**
+   A span of time with a constant tempo, which starts at a given frame and beat
+   time and lasts until the start of the next segment.
+*/
+typedef struct {
+	int64_t frames;           /**< Frame time at the start of the segment */
+	double  beats;            /**< Beat time at the start of the segment */
+	double  beats_per_frame;  /**< Tempo in beats per frame */
+	double  frames_per_beat;  /**< Tempo in frames per beat */
+} LV2_Atom_Tempo_Segment;
+
+/**
+   A map between frame and beat time, for converting event time stamps.
+
+   Plugins and hosts often need to handle sequences with time stamps in beats,
+   but render audio in frames.  A tempo map describes how the two relate, as a
+   series of segments with a constant tempo, which can change at any frame.
+   Frames and beats in the map have the same base as the time stamps of the
+   sequences it is used with, so for events in run() the map typically starts
+   at frame 0 and beat 0 at the start of the cycle.
+
+   The tempo of each segment is stored in both directions, so converting a
+   time stamp is a single multiply and add, without any division.  The
+   segments are stored in a buffer provided by the caller, and nothing here
+   allocates memory, so all of these functions are realtime safe.
+*/
+typedef struct {
+	LV2_Atom_Tempo_Segment* segments;    /**< Segments, ordered by time */
+	uint32_t                n_segments;  /**< Number of segments */
+	uint32_t                capacity;    /**< Size of segments */
+	double                  rate;        /**< Sample rate in Hz */
+} LV2_Atom_Tempo_Map;
+
+/**
+   Initialise an empty tempo map.
+
+   lv2_atom_tempo_map_reset() must be called to set the initial tempo before
+   the map is used.
+
+   @param map The map to initialise.
+   @param segments Buffer for segments, with space for `capacity` segments.
+   @param capacity The maximum number of tempo changes, plus one.
+   @param rate The sample rate in Hz.
+*/
+static inline void
+lv2_atom_tempo_map_init(LV2_Atom_Tempo_Map*     map,
+                        LV2_Atom_Tempo_Segment* segments,
+                        uint32_t                capacity,
+                        double                  rate)
+{
+	map->segments   = segments;
+	map->n_segments = 0;
+	map->capacity   = capacity;
+	map->rate       = rate;
+}
+
+/** Set the tempo of `seg` to `bpm` beats per minute. */
+static inline void
+lv2_atom_tempo_segment_set_bpm(LV2_Atom_Tempo_Segment* seg,
+                               double                  rate,
+                               double                  bpm)
+{
+	seg->beats_per_frame = bpm / (60.0 * rate);
+	seg->frames_per_beat = (60.0 * rate) / bpm;
+}
+
+/**
+   Clear `map` and start it at `frames` and `beats` with a constant tempo.
+
+   @return True on success, or false if the tempo is not positive or the map
+   has no space for segments.
+*/
+static inline bool
+lv2_atom_tempo_map_reset(LV2_Atom_Tempo_Map* map,
+                         int64_t             frames,
+                         double              beats,
+                         double              bpm)
+{
+	if (!(bpm > 0.0) || !map->capacity) {
+		return false;
+	}
+
+	map->segments[0].frames = frames;
+	map->segments[0].beats  = beats;
+	lv2_atom_tempo_segment_set_bpm(&map->segments[0], map->rate, bpm);
+	map->n_segments = 1;
+	return true;
+}
+
+/**
+   Change the tempo to `bpm` beats per minute from `frames` onwards.
+
+   Tempo changes must be added in order, so `frames` must not be earlier than
+   the last change.  A change at the same frame as the last one replaces it.
+
+   @return True on success, or false if the map is empty or full, the change is
+   out of order, or the tempo is not positive.
+*/
+static inline bool
+lv2_atom_tempo_map_set_tempo(LV2_Atom_Tempo_Map* map,
+                             int64_t             frames,
+                             double              bpm)
+{
+	if (!map->n_segments || !(bpm > 0.0)) {
+		return false;
+	}
+
+	LV2_Atom_Tempo_Segment* last = &map->segments[map->n_segments - 1];
+	if (frames < last->frames) {
+		return false;
+	} else if (frames > last->frames) {
+		if (map->n_segments == map->capacity) {
+			return false;
+		}
+
+		LV2_Atom_Tempo_Segment* const next = last + 1;
+		next->frames = frames;
+		next->beats  = last->beats + (double)(frames - last->frames) *
+			last->beats_per_frame;
+		last = next;
+		++map->n_segments;
+	}
+
+	lv2_atom_tempo_segment_set_bpm(last, map->rate, bpm);
+	return true;
+}
+
+/**
+   Return the segment that contains `frames`.
+
+   Times before the start of the map are in the first segment.  The map must
+   not be empty.
+*/
+static inline const LV2_Atom_Tempo_Segment*
+lv2_atom_tempo_map_segment_at_frames(const LV2_Atom_Tempo_Map* map,
+                                     int64_t                   frames)
+{
+	uint32_t lo = 1;
+	uint32_t hi = map->n_segments;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (map->segments[mid].frames <= frames) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return &map->segments[lo - 1];
+}
+
+/**
+   Return the segment that contains `beats`.
+
+   Times before the start of the map are in the first segment.  The map must
+   not be empty.
+*/
+static inline const LV2_Atom_Tempo_Segment*
+lv2_atom_tempo_map_segment_at_beats(const LV2_Atom_Tempo_Map* map,
+                                    double                    beats)
+{
+	uint32_t lo = 1;
+	uint32_t hi = map->n_segments;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (map->segments[mid].beats <= beats) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return &map->segments[lo - 1];
+}
+
+/** Convert a frame time to beats.  The map must not be empty. */
+static inline double
+lv2_atom_tempo_map_frames_to_beats(const LV2_Atom_Tempo_Map* map,
+                                   int64_t                   frames)
+{
+	const LV2_Atom_Tempo_Segment* const seg =
+		lv2_atom_tempo_map_segment_at_frames(map, frames);
+	return seg->beats + (double)(frames - seg->frames) * seg->beats_per_frame;
+}
+
+/**
+   Convert a beat time to frames, rounded to the nearest frame.  The map must
+   not be empty.
+*/
+static inline int64_t
+lv2_atom_tempo_map_beats_to_frames(const LV2_Atom_Tempo_Map* map,
+                                   double                    beats)
+{
+	const LV2_Atom_Tempo_Segment* const seg =
+		lv2_atom_tempo_map_segment_at_beats(map, beats);
+	const double offset = (beats - seg->beats) * seg->frames_per_beat;
+	return seg->frames + ((offset < 0.0) ? -(int64_t)(0.5 - offset)
+	                                     : (int64_t)(offset + 0.5));
+}
+
 /**
    @}
    @name Sequence Utilities
@@ -161,7 +365,7 @@ lv2_atom_sequence_append_event(LV2_Atom_Sequence*    seq,
                                const LV2_Atom_Event* event)
 {
 	const uint32_t total_size = (uint32_t)sizeof(*event) + event->body.size;
-	if (capacity - seq->atom.size < total_size) {
+	if (seq->atom.size > capacity || capacity - seq->atom.size < total_size) {
 		return NULL;
 	}
 
@@ -174,148 +378,1032 @@ lv2_atom_sequence_append_event(LV2_Atom_Sequence*    seq,
 }
 
 /**
-   @}
-   @name Tuple Iterator
-   @{
+   Return true iff event `a` is strictly earlier than event `b`.
+
+   @param beats If true, compare beat time stamps, otherwise frame time stamps.
 */
+static inline bool
+lv2_atom_event_is_before(const LV2_Atom_Event* a,
+                         const LV2_Atom_Event* b,
+                         bool                  beats)
+{
+	return beats ? (a->time.beats < b->time.beats)
+	             : (a->time.frames < b->time.frames);
+}
 
-/** Get an iterator pointing to the first element in `tup`. */
-static inline LV2_Atom*
-lv2_atom_tuple_begin(const LV2_Atom_Tuple* tup)
+/** The maximum number of inputs to lv2_atom_sequence_merge(). */
+#define LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS 64
+
+/**
+   Return the time stamp of `ev` in the unit of a merge output.
+
+   @param in_beats True iff the time stamp of `ev` is in beats.
+   @param out_beats True iff the output time unit is beats.
+   @param tempo Tempo map for converting between units, used only if they
+   differ.
+*/
+static inline double
+lv2_atom_sequence_merge_key(const LV2_Atom_Event*     ev,
+                            bool                      in_beats,
+                            bool                      out_beats,
+                            const LV2_Atom_Tempo_Map* tempo)
 {
-	return (LV2_Atom*)(LV2_ATOM_BODY(tup));
+	if (in_beats == out_beats) {
+		return in_beats ? ev->time.beats : (double)ev->time.frames;
+	}
+
+	return out_beats
+		? lv2_atom_tempo_map_frames_to_beats(tempo, ev->time.frames)
+		: (double)lv2_atom_tempo_map_beats_to_frames(tempo, ev->time.beats);
 }
 
-/** Return true iff `i` has reached the end of `body`. */
+/**
+   Merge several sequences into one, ordered by time, converting time units.
+
+   This is like lv2_atom_sequence_merge(), but the inputs may have different
+   time units.  Events are written with the time unit of `out`, which must be
+   set by the caller: if it is `beat_time`, events are written with beat time
+   stamps, otherwise with frame time stamps.  Time stamps of events in other
+   units are converted with `tempo`, which must not be empty.  Events are
+   still copied in blocks, and time stamps are only rewritten where the units
+   differ.
+
+   If `tempo` is NULL, this is exactly lv2_atom_sequence_merge(): all
+   non-empty inputs must have the same time unit, and the unit of `out` is
+   ignored.
+
+   @return True on success, or false if the inputs are invalid or the output is
+   full.  On failure, `out` is still a valid sequence, but may only contain
+   some of the events.
+*/
 static inline bool
-lv2_atom_tuple_is_end(const void* body, uint32_t size, const LV2_Atom* i)
+lv2_atom_sequence_merge_tempo(LV2_Atom_Sequence*              out,
+                              uint32_t                        capacity,
+                              uint32_t                        n_inputs,
+                              const LV2_Atom_Sequence* const* inputs,
+                              uint32_t                        beat_time,
+                              const LV2_Atom_Tempo_Map*       tempo)
 {
-	return (const uint8_t*)i >= ((const uint8_t*)body + size);
+	const LV2_Atom_Event* iters[LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS];
+	const uint8_t*        ends[LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS];
+	double                keys[LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS];
+	bool                  in_beats[LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS];
+	if (n_inputs > LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS ||
+	    (tempo && !tempo->n_segments)) {
+		return false;
+	}
+
+	/* Set up an iterator for every input, and check that units match */
+	const LV2_Atom_Sequence* first = NULL;
+	for (uint32_t i = 0; i < n_inputs; ++i) {
+		const LV2_Atom_Sequence* in = inputs[i];
+		iters[i] = lv2_atom_sequence_begin(&in->body);
+		ends[i]  = (const uint8_t*)&in->body + in->atom.size;
+		if ((const uint8_t*)iters[i] >= ends[i]) {
+			iters[i] = NULL;  // Empty input
+		} else if (!first) {
+			first = in;
+		} else if (!tempo && in->body.unit != first->body.unit) {
+			return false;
+		}
+	}
+
+	/* Determine the unit of the output and every input, and the first keys */
+	const LV2_Atom_Sequence* const unit_seq  = tempo ? out : first;
+	const bool                     out_beats = unit_seq && beat_time &&
+		unit_seq->body.unit == beat_time;
+	for (uint32_t i = 0; i < n_inputs; ++i) {
+		in_beats[i] = tempo
+			? (beat_time && inputs[i]->body.unit == beat_time)
+			: out_beats;
+		if (iters[i]) {
+			keys[i] = lv2_atom_sequence_merge_key(
+				iters[i], in_beats[i], out_beats, tempo);
+		}
+	}
+
+	for (;;) {
+		/* Find the input with the earliest event (the first wins ties) */
+		uint32_t m = n_inputs;
+		for (uint32_t i = 0; i < n_inputs; ++i) {
+			if (iters[i] && (m == n_inputs || keys[i] < keys[m])) {
+				m = i;
+			}
+		}
+		if (m == n_inputs) {
+			return true;  // All inputs are finished
+		}
+
+		/* Extend to a run of events from this input that fits in the output
+		   and precedes the next event in every other input */
+		const uint8_t* const begin = (const uint8_t*)iters[m];
+		const uint8_t*       end   = begin;
+		const uint32_t       space = capacity - out->atom.size;
+		for (const LV2_Atom_Event* e = iters[m]; (const uint8_t*)e < ends[m];
+		     e = lv2_atom_sequence_next(e)) {
+			const uint8_t* next = (const uint8_t*)lv2_atom_sequence_next(e);
+			if (next > ends[m]) {
+				next = ends[m];  // Last event in input is not padded
+			}
+			if (lv2_atom_pad_size((uint32_t)(next - begin)) > space) {
+				break;
+			}
+
+			const double key = (e == iters[m])
+				? keys[m]
+				: lv2_atom_sequence_merge_key(e, in_beats[m], out_beats, tempo);
+
+			bool precedes = true;
+			for (uint32_t i = 0; i < n_inputs && precedes; ++i) {
+				if (i < m && iters[i]) {
+					precedes = key < keys[i];
+				} else if (i > m && iters[i]) {
+					precedes = !(keys[i] < key);
+				}
+			}
+			if (!precedes) {
+				break;
+			}
+
+			end = next;
+		}
+
+		if (end == begin) {
+			return false;  // Insufficient space for next event
+		}
+
+		/* Copy run to output and advance input iterator */
+		const uint32_t  size = (uint32_t)(end - begin);
+		LV2_Atom_Event* dst  = lv2_atom_sequence_end(&out->body, out->atom.size);
+		memcpy(dst, begin, size);
+		out->atom.size += lv2_atom_pad_size(size);
+		iters[m] = (end < ends[m]) ? (const LV2_Atom_Event*)end : NULL;
+		if (iters[m]) {
+			keys[m] = lv2_atom_sequence_merge_key(
+				iters[m], in_beats[m], out_beats, tempo);
+		}
+
+		/* Convert the time stamps of the copied events if necessary */
+		if (in_beats[m] != out_beats) {
+			const uint8_t* const copy_end = (const uint8_t*)dst + size;
+			for (; (const uint8_t*)dst < copy_end;
+			     dst = lv2_atom_sequence_next(dst)) {
+				if (out_beats) {
+					dst->time.beats = lv2_atom_tempo_map_frames_to_beats(
+						tempo, dst->time.frames);
+				} else {
+					dst->time.frames = lv2_atom_tempo_map_beats_to_frames(
+						tempo, dst->time.beats);
+				}
+			}
+		}
+	}
 }
 
-/** Return an iterator to the element following `i`. */
-static inline LV2_Atom*
-lv2_atom_tuple_next(const LV2_Atom* i)
+/**
+   Merge several sequences into one, ordered by time.
+
+   Events from all inputs are appended to `out` in a single pass, ordered by
+   time stamp.  Events with equal time stamps are written in input order, so
+   the merge is stable, and events from the same input are never reordered.
+   Consecutive events from the same input are copied in a single block.
+
+   All non-empty inputs must have the same time unit.  If this is
+   `beat_time`, events are ordered by beats, otherwise by frames.  The header
+   of `out` is not modified (except the size), so the caller must set its type
+   and unit, and any events already in `out` must precede the merged events.
+   To merge inputs with different units, use lv2_atom_sequence_merge_tempo().
+
+   This function does not allocate memory and is realtime safe.
+
+   @param out Sequence to append events to.
+   @param capacity Total capacity of `out`, as in
+   lv2_atom_sequence_append_event().
+   @param n_inputs Number of input sequences, at most
+   LV2_ATOM_SEQUENCE_MERGE_MAX_INPUTS.
+   @param inputs Input sequences, which must each be ordered by time.
+   @param beat_time URID of atom:beatTime, or 0 if beat time is not supported.
+
+   @return True on success, or false if the inputs are invalid or the output is
+   full.  On failure, `out` is still a valid sequence, but may only contain
+   some of the events.
+*/
+static inline bool
+lv2_atom_sequence_merge(LV2_Atom_Sequence*              out,
+                        uint32_t                        capacity,
+                        uint32_t                        n_inputs,
+                        const LV2_Atom_Sequence* const* inputs,
+                        uint32_t                        beat_time)
 {
-	return (LV2_Atom*)(
-		(const uint8_t*)i + sizeof(LV2_Atom) + lv2_atom_pad_size(i->size));
+	return lv2_atom_sequence_merge_tempo(
+		out, capacity, n_inputs, inputs, beat_time, NULL);
 }
 
 /**
-   A macro for iterating over all properties of a Tuple.
-   @param tuple The tuple to iterate over
-   @param iter The name of the iterator
+   @}
+   @name Sequence Editor
+   @{
+*/
+
+/**
+   An editor for modifying a sequence in place.
+
+   This allows removing, modifying, and inserting events in a sequence without
+   copying it to another buffer, which is useful for plugins that modify a few
+   events in a sequence that is otherwise passed through unchanged.  For
+   example, to remove all events of some type in place:
 
-   This macro is used similarly to a for loop (which it expands to), e.g.:
    @code
-   LV2_ATOMO_TUPLE_FOREACH(tuple, elem) {
-       // Do something with elem (an LV2_Atom*) here...
+   LV2_Atom_Sequence_Editor editor;
+   lv2_atom_sequence_editor_init(&editor, seq, capacity);
+   for (LV2_Atom_Event* ev = NULL;
+        (ev = lv2_atom_sequence_editor_current(&editor));) {
+       if (ev->body.type == uris->eg_Garbage) {
+           lv2_atom_sequence_editor_drop(&editor);
+       } else {
+           lv2_atom_sequence_editor_keep(&editor);
+       }
    }
+   lv2_atom_sequence_editor_finish(&editor);
    @endcode
-*/
-#define LV2_ATOM_TUPLE_FOREACH(tuple, iter) \
-	for (LV2_Atom* (iter) = lv2_atom_tuple_begin(tuple); \
-	     !lv2_atom_tuple_is_end(LV2_ATOM_BODY(tuple), (tuple)->size, (iter)); \
-	     (iter) = lv2_atom_tuple_next(iter))
 
-/** Like LV2_ATOM_TUPLE_FOREACH but for a headerless tuple body. */
-#define LV2_ATOM_TUPLE_BODY_FOREACH(body, size, iter) \
-	for (LV2_Atom* (iter) = (LV2_Atom*)body; \
-	     !lv2_atom_tuple_is_end(body, size, (iter)); \
-	     (iter) = lv2_atom_tuple_next(iter))
+   The editor visits every event once, in order.  For each, the caller may
+   insert events before it, then either keep it or drop it.  A kept event may
+   be modified first, as long as its size does not change.  All edits are done
+   in a single pass over the buffer: events are only moved if something before
+   them was removed or inserted, and consecutive kept events are moved in a
+   single block.
+
+   Inserting events requires space after the end of the sequence.  The
+   contract is that the edited sequence must fit in `capacity` at all times,
+   that is, the size of the events written so far plus the size of the events
+   not yet visited must not exceed `capacity`.  The first insertion that needs
+   more space than was freed by dropped events moves the events not yet visited
+   to the end of the buffer, which opens a gap for any later insertions.
+
+   The sequence is not valid while it is being edited, until
+   lv2_atom_sequence_editor_finish() is called.
+*/
+typedef struct {
+	LV2_Atom_Sequence* seq;    /**< Sequence being edited */
+	uint8_t*           out;    /**< End of edited events */
+	uint8_t*           run;    /**< Start of kept events not yet moved */
+	uint8_t*           read;   /**< Current event */
+	uint8_t*           end;    /**< End of events not yet visited */
+	uint8_t*           limit;  /**< End of buffer */
+} LV2_Atom_Sequence_Editor;
 
 /**
-   @}
-   @name Object Iterator
-   @{
+   Start editing `seq` in place.
+
+   @param editor Editor to initialise.
+   @param seq Sequence to edit.
+   @param capacity Total capacity of the sequence atom, as in
+   lv2_atom_sequence_append_event().  This may be `seq->atom.size` if no
+   events will be inserted.  Only whole multiples of 8 bytes are used, so
+   events stay aligned if they are moved to the end of the buffer.
 */
+static inline void
+lv2_atom_sequence_editor_init(LV2_Atom_Sequence_Editor* editor,
+                              LV2_Atom_Sequence*        seq,
+                              uint32_t                  capacity)
+{
+	uint8_t* const body  = (uint8_t*)&seq->body;
+	const uint32_t size  = seq->atom.size;
+	const uint32_t limit = capacity & ~7U;
+	editor->seq   = seq;
+	editor->out   = (uint8_t*)lv2_atom_sequence_begin(&seq->body);
+	editor->run   = editor->out;
+	editor->read  = editor->out;
+	editor->end   = body + size;
+	editor->limit = body + (limit > size ? limit : size);
+}
 
-/** Return a pointer to the first property in `body`. */
-static inline LV2_Atom_Property_Body*
-lv2_atom_object_begin(const LV2_Atom_Object_Body* body)
+/** Return the current event, or NULL if every event has been visited. */
+static inline LV2_Atom_Event*
+lv2_atom_sequence_editor_current(const LV2_Atom_Sequence_Editor* editor)
 {
-	return (LV2_Atom_Property_Body*)(body + 1);
+	return (editor->read < editor->end) ? (LV2_Atom_Event*)editor->read : NULL;
 }
 
-/** Return true iff `i` has reached the end of `obj`. */
-static inline bool
-lv2_atom_object_is_end(const LV2_Atom_Object_Body*   body,
-                       uint32_t                      size,
-                       const LV2_Atom_Property_Body* i)
+/** Return the padded size of the current event.  Used internally. */
+static inline uint32_t
+lv2_atom_sequence_editor_current_size(const LV2_Atom_Sequence_Editor* editor)
 {
-	return (const uint8_t*)i >= ((const uint8_t*)body + size);
+	const LV2_Atom_Event* ev   = (const LV2_Atom_Event*)editor->read;
+	const uint32_t        size = lv2_atom_pad_size(
+		(uint32_t)sizeof(LV2_Atom_Event) + ev->body.size);
+	const uint32_t rest = (uint32_t)(editor->end - editor->read);
+	return size < rest ? size : rest;
 }
 
-/** Return an iterator to the property following `i`. */
-static inline LV2_Atom_Property_Body*
-lv2_atom_object_next(const LV2_Atom_Property_Body* i)
+/** Move pending kept events to the output.  Used internally. */
+static inline void
+lv2_atom_sequence_editor_flush(LV2_Atom_Sequence_Editor* editor)
 {
-	const LV2_Atom* const value = (const LV2_Atom*)(
-		(const uint8_t*)i + 2 * sizeof(uint32_t));
-	return (LV2_Atom_Property_Body*)(
-		(const uint8_t*)i + lv2_atom_pad_size(
-			(uint32_t)sizeof(LV2_Atom_Property_Body) + value->size));
+	const uint32_t size = (uint32_t)(editor->read - editor->run);
+	if (editor->run != editor->out) {
+		memmove(editor->out, editor->run, size);
+	}
+	editor->out += size;
+	editor->run  = editor->read;
 }
 
 /**
-   A macro for iterating over all properties of an Object.
-   @param obj The object to iterate over
-   @param iter The name of the iterator
+   Keep the current event and advance to the next.
 
-   This macro is used similarly to a for loop (which it expands to), e.g.:
-   @code
-   LV2_ATOM_OBJECT_FOREACH(object, i) {
-       // Do something with prop (an LV2_Atom_Property_Body*) here...
-   }
-   @endcode
+   The current event may have been modified before calling this, but its size
+   must not have changed.
 */
-#define LV2_ATOM_OBJECT_FOREACH(obj, iter) \
-	for (LV2_Atom_Property_Body* (iter) = lv2_atom_object_begin(&(obj)->body); \
-	     !lv2_atom_object_is_end(&(obj)->body, (obj)->atom.size, (iter)); \
-	     (iter) = lv2_atom_object_next(iter))
+static inline void
+lv2_atom_sequence_editor_keep(LV2_Atom_Sequence_Editor* editor)
+{
+	editor->read += lv2_atom_sequence_editor_current_size(editor);
+}
 
-/** Like LV2_ATOM_OBJECT_FOREACH but for a headerless object body. */
-#define LV2_ATOM_OBJECT_BODY_FOREACH(body, size, iter) \
-	for (LV2_Atom_Property_Body* (iter) = lv2_atom_object_begin(body); \
-	     !lv2_atom_object_is_end(body, size, (iter)); \
-	     (iter) = lv2_atom_object_next(iter))
+/** Remove the current event and advance to the next. */
+static inline void
+lv2_atom_sequence_editor_drop(LV2_Atom_Sequence_Editor* editor)
+{
+	lv2_atom_sequence_editor_flush(editor);
+	editor->read += lv2_atom_sequence_editor_current_size(editor);
+	editor->run   = editor->read;
+}
+
+/**
+   Insert an event before the current event.
+
+   If every event has been visited, the event is inserted at the end.  The
+   caller is responsible for keeping the sequence in time order.
+
+   @return A pointer to the newly written event in the sequence, or NULL on
+   failure (insufficient space), in which case the sequence is unchanged.
+*/
+static inline LV2_Atom_Event*
+lv2_atom_sequence_editor_insert(LV2_Atom_Sequence_Editor* editor,
+                                const LV2_Atom_Event*     event)
+{
+	const uint32_t total_size = (uint32_t)sizeof(*event) + event->body.size;
+	const uint32_t size       = lv2_atom_pad_size(total_size);
+
+	lv2_atom_sequence_editor_flush(editor);
+	if ((uint32_t)(editor->read - editor->out) < size) {
+		// Not enough space, move events not yet visited to the end to make some
+		const uint32_t rest = (uint32_t)(editor->end - editor->read);
+		const uint32_t room = lv2_atom_pad_size(rest) + size;
+		if ((uint32_t)(editor->limit - editor->out) < room) {
+			return NULL;
+		}
+
+		// The last event may be unpadded, so keep the moved events aligned
+		uint8_t* const read = editor->limit - lv2_atom_pad_size(rest);
+		memmove(read, editor->read, rest);
+		editor->read = editor->run = read;
+		editor->end  = read + rest;
+	}
+
+	LV2_Atom_Event* const e = (LV2_Atom_Event*)editor->out;
+	memcpy(e, event, total_size);
+	editor->out += size;
+	return e;
+}
+
+/**
+   Finish editing.
+
+   Any events not yet visited are kept, and the size of the sequence is updated
+   so it is valid again.
+*/
+static inline void
+lv2_atom_sequence_editor_finish(LV2_Atom_Sequence_Editor* editor)
+{
+	editor->read = editor->end;
+	lv2_atom_sequence_editor_flush(editor);
+	editor->seq->atom.size = (uint32_t)(editor->out -
+	                                    (uint8_t*)&editor->seq->body);
+}
 
 /**
    @}
-   @name Object Query
+   @name Sequence Index
    @{
 */
 
-/** A single entry in an Object query. */
-typedef struct {
-	uint32_t         key;    /**< Key to query (input set by user) */
-	const LV2_Atom** value;  /**< Found value (output set by query function) */
-} LV2_Atom_Object_Query;
+/**
+   An index of the events in a Sequence for random access.
 
-static const LV2_Atom_Object_Query LV2_ATOM_OBJECT_QUERY_END = { 0, NULL };
+   The Sequence iterators can only move forwards, so finding the event at a
+   given time requires scanning from the start.  An index stores the offset of
+   every event, so events can be accessed by ordinal, or found by time with a
+   binary search.  The offsets are stored in a buffer provided by the caller,
+   the sequence itself is not modified and must outlive the index.
+*/
+typedef struct {
+	const LV2_Atom_Sequence_Body* body;      /**< Indexed sequence body */
+	const uint32_t*               offsets;   /**< Event offsets from body */
+	uint32_t                      n_events;  /**< Number of events */
+} LV2_Atom_Sequence_Index;
 
 /**
-   Get an object's values for various keys.
+   Build an index of the events in `seq`.
 
-   The value pointer of each item in `query` will be set to the location of
-   the corresponding value in `object`.  Every value pointer in `query` MUST
-   be initialised to NULL.  This function reads `object` in a single linear
-   sweep.  By allocating `query` on the stack, objects can be "queried"
-   quickly without allocating any memory.  This function is realtime safe.
+   This scans the sequence once, writing the offset of each event to
+   `offsets`.  This function is realtime safe.
 
-   This function can only do "flat" queries, it is not smart enough to match
-   variables in nested objects.
+   @param index The index to initialise.
+   @param seq The sequence to index.
+   @param offsets Buffer for event offsets, with space for `max_events`.
+   @param max_events The maximum number of events that can be indexed.
 
-   For example:
-   @code
-   const LV2_Atom* name = NULL;
-   const LV2_Atom* age  = NULL;
-   LV2_Atom_Object_Query q[] = {
-       { urids.eg_name, &name },
-       { urids.eg_age,  &age },
-       LV2_ATOM_OBJECT_QUERY_END
-   };
-   lv2_atom_object_query(obj, q);
+   @return True on success.  If the sequence contains more than `max_events`
+   events, false is returned, and only the first `max_events` events are
+   indexed, so the index is still safe to use.
+*/
+static inline bool
+lv2_atom_sequence_index_init(LV2_Atom_Sequence_Index* index,
+                             const LV2_Atom_Sequence* seq,
+                             uint32_t*                offsets,
+                             uint32_t                 max_events)
+{
+	const uint8_t* const body = (const uint8_t*)&seq->body;
+
+	uint32_t n = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (n < max_events) {
+			offsets[n] = (uint32_t)((const uint8_t*)ev - body);
+		}
+		++n;
+	}
+
+	index->body     = &seq->body;
+	index->offsets  = offsets;
+	index->n_events = n < max_events ? n : max_events;
+	return n <= max_events;
+}
+
+/** Return the event at ordinal `i`, or NULL if `i` is out of range. */
+static inline const LV2_Atom_Event*
+lv2_atom_sequence_index_get(const LV2_Atom_Sequence_Index* index, uint32_t i)
+{
+	return (i < index->n_events)
+		? (const LV2_Atom_Event*)((const uint8_t*)index->body
+		                          + index->offsets[i])
+		: NULL;
+}
+
+/**
+   Return the ordinal of the first event at or after `frames`.
+
+   The sequence must be ordered by frame time.  If all events are before
+   `frames`, `index->n_events` is returned.
+*/
+static inline uint32_t
+lv2_atom_sequence_index_seek_frames(const LV2_Atom_Sequence_Index* index,
+                                    int64_t                        frames)
+{
+	uint32_t lo = 0;
+	uint32_t hi = index->n_events;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (lv2_atom_sequence_index_get(index, mid)->time.frames < frames) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+   Return the ordinal of the first event at or after `beats`.
+
+   The sequence must be ordered by beat time.  If all events are before
+   `beats`, `index->n_events` is returned.
+*/
+static inline uint32_t
+lv2_atom_sequence_index_seek_beats(const LV2_Atom_Sequence_Index* index,
+                                   double                         beats)
+{
+	uint32_t lo = 0;
+	uint32_t hi = index->n_events;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (lv2_atom_sequence_index_get(index, mid)->time.beats < beats) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+   @}
+   @name Sequence Slicer
+   @{
+*/
+
+/**
+   A slice of a cycle: a range of frames, and the events that start it.
+
+   The events in a slice should be processed first, then audio rendered for
+   the range [begin, end).
+*/
+typedef struct {
+	uint32_t        begin;       /**< First frame in slice */
+	uint32_t        end;         /**< End of slice (one past the last frame) */
+	LV2_Atom_Event* events;      /**< First event in slice */
+	LV2_Atom_Event* events_end;  /**< End of events (first event after slice) */
+} LV2_Atom_Slice;
+
+/**
+   An iterator that splits a cycle into slices between events.
+
+   This implements the common pattern of processing events in run(), where
+   audio is rendered in chunks between events so that every event takes
+   effect at the correct time.  For example:
+
+   @code
+   LV2_Atom_Slicer slicer;
+   LV2_Atom_Slice  slice;
+   lv2_atom_slicer_init(&slicer, self->control_port, sample_count, 0);
+   while (lv2_atom_slicer_next(&slicer, &slice)) {
+       LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+           // Handle ev (an LV2_Atom_Event*) here...
+       }
+       render(self, slice.begin, slice.end);
+   }
+   @endcode
+
+   All events with the same time stamp are delivered in a single slice.  If a
+   minimum slice length is given, all events that occur within that many
+   frames of the start of a slice are also delivered at the start of that
+   slice, so audio is never split into more pieces than necessary.  This
+   trades some timing accuracy for longer runs of uninterrupted processing,
+   which is often worthwhile with dense input.
+
+   Events with time stamps before the current slice are delivered with the
+   next slice, and events at or after the end of the cycle are delivered in a
+   final empty slice, so no event is ever skipped.  The slicer does not
+   allocate memory and is realtime safe.
+
+   Sequences with beat time stamps can be sliced by setting a tempo map with
+   lv2_atom_slicer_set_tempo(), which is used to find the frame of each event.
+*/
+typedef struct {
+	LV2_Atom_Event*           ev;        /**< Next event */
+	const uint8_t*            end;       /**< End of sequence body */
+	const LV2_Atom_Tempo_Map* tempo;     /**< Map for beat time, or NULL */
+	uint32_t                  offset;    /**< Start of next slice */
+	uint32_t                  n_frames;  /**< Number of frames in cycle */
+	uint32_t                  min_len;   /**< Minimum length of slices */
+	bool                      done;      /**< True after the last slice */
+} LV2_Atom_Slicer;
+
+/**
+   Initialise `slicer` to slice a cycle of `n_frames` frames with events in
+   `seq`, with slices at least `min_len` frames long (except the last).
+*/
+static inline void
+lv2_atom_slicer_init(LV2_Atom_Slicer*         slicer,
+                     const LV2_Atom_Sequence* seq,
+                     uint32_t                 n_frames,
+                     uint32_t                 min_len)
+{
+	slicer->ev       = lv2_atom_sequence_begin(&seq->body);
+	slicer->end      = (const uint8_t*)&seq->body + seq->atom.size;
+	slicer->tempo    = NULL;
+	slicer->offset   = 0;
+	slicer->n_frames = n_frames;
+	slicer->min_len  = min_len ? min_len : 1;
+	slicer->done     = false;
+}
+
+/**
+   Set the tempo map used to slice a sequence with beat time stamps.
+
+   This must be called after lv2_atom_slicer_init() if the unit of the
+   sequence is atom:beatTime.  The frame of each event is found with `tempo`
+   when it is reached, so the map may be changed while slicing, for example to
+   add a tempo change when a time:Position event is handled.  Such a change
+   affects the following slices, but not the end of the current one, which
+   has already been found.
+
+   @param slicer The slicer.
+   @param tempo Tempo map, which must not be empty, or NULL to use frame time
+   stamps again.
+*/
+static inline void
+lv2_atom_slicer_set_tempo(LV2_Atom_Slicer*          slicer,
+                          const LV2_Atom_Tempo_Map* tempo)
+{
+	slicer->tempo = tempo;
+}
+
+/**
+   Get the next slice from `slicer`.
+
+   @return True if `slice` was set to the next slice, or false if the end of
+   the cycle has been reached.
+*/
+static inline bool
+lv2_atom_slicer_next(LV2_Atom_Slicer* slicer, LV2_Atom_Slice* slice)
+{
+	if (slicer->done) {
+		return false;
+	}
+
+	/* Gather events that occur before the minimum end of this slice */
+	const int64_t limit = (slicer->offset < slicer->n_frames)
+		? (int64_t)slicer->offset + slicer->min_len
+		: INT64_MAX;
+	LV2_Atom_Event* ev     = slicer->ev;
+	int64_t         frames = 0;
+	if (slicer->tempo) {
+		/* The tempo may have changed since the last slice, so the event that
+		   ended it is converted again */
+		while ((const uint8_t*)ev < slicer->end &&
+		       (frames = lv2_atom_tempo_map_beats_to_frames(
+			        slicer->tempo, ev->time.beats)) < limit) {
+			ev = lv2_atom_sequence_next(ev);
+		}
+	} else {
+		if (slicer->offset && (const uint8_t*)ev < slicer->end) {
+			/* After the first slice, the next event is the one that ended
+			   the last slice, so it starts this one and need not be checked */
+			ev = lv2_atom_sequence_next(ev);
+		}
+		while ((const uint8_t*)ev < slicer->end &&
+		       (frames = ev->time.frames) < limit) {
+			ev = lv2_atom_sequence_next(ev);
+		}
+	}
+
+	/* End slice at the next event, or the end of the cycle */
+	const bool more = (const uint8_t*)ev < slicer->end;
+	slice->begin      = slicer->offset;
+	slice->end        = slicer->n_frames;
+	slice->events     = slicer->ev;
+	slice->events_end = ev;
+	if (more && frames < slicer->n_frames) {
+		slice->end = (uint32_t)frames;
+	}
+
+	slicer->ev     = ev;
+	slicer->offset = slice->end;
+	slicer->done   = !more && slice->end == slicer->n_frames;
+
+	return slice->end > slice->begin || slice->events != slice->events_end;
+}
+
+/**
+   A macro for iterating over all events in a slice.
+   @param slice The slice to iterate over
+   @param iter The name of the iterator
+
+   This macro is used similarly to a for loop (which it expands to), e.g.:
+   @code
+   LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+       // Do something with ev (an LV2_Atom_Event*) here...
+   }
+   @endcode
+*/
+#define LV2_ATOM_SLICE_FOREACH(slice, iter) \
+	for (LV2_Atom_Event* iter = (slice)->events; \
+	     (iter) != (slice)->events_end; \
+	     (iter) = lv2_atom_sequence_next(iter))
+
+/**
+   @}
+   @name Event Dispatch
+   @{
+*/
+
+/** The number of handler slots in an LV2_Atom_Dispatch. */
+#define LV2_ATOM_DISPATCH_N_SLOTS 64
+
+/** A function that handles an event.  See lv2_atom_dispatch_add(). */
+typedef void (*LV2_Atom_Event_Handler)(void* handle, const LV2_Atom_Event* ev);
+
+/** An entry in an event dispatch table. */
+typedef struct {
+	uint32_t               type;     /**< Event type, or 0 if slot is empty */
+	uint32_t               otype;    /**< Object type, or 0 for any */
+	LV2_Atom_Event_Handler handler;  /**< Handler function */
+	uint32_t               count;    /**< Number of events dispatched */
+} LV2_Atom_Dispatch_Entry;
+
+/**
+   A table of event handlers keyed by event type and object type.
+
+   This replaces chains of comparisons against event and object types (the
+   usual way of handling incoming events in run()) with a hash table lookup,
+   so adding more message types does not make dispatch slower.  The table is
+   built once with lv2_atom_dispatch_init() and lv2_atom_dispatch_add(),
+   typically in instantiate(), then events are dispatched with
+   lv2_atom_dispatch_event() or lv2_atom_dispatch_sequence(), for example:
+
+   @code
+   // In instantiate()
+   lv2_atom_dispatch_init(&self->dispatch,
+                          uris->atom_Object, uris->atom_Blank, 0);
+   lv2_atom_dispatch_add(&self->dispatch, uris->midi_Event, 0, on_midi);
+   lv2_atom_dispatch_add(&self->dispatch, uris->atom_Object, uris->patch_Set,
+                         on_patch_set);
+
+   // In run()
+   lv2_atom_dispatch_sequence(&self->dispatch, self, self->control_port);
+   @endcode
+
+   Each entry counts the events dispatched to it, and events with no handler
+   are counted in `n_unhandled`, which is useful for instrumentation.  These
+   counts are never reset automatically.
+*/
+typedef struct {
+	LV2_Atom_Dispatch_Entry entries[LV2_ATOM_DISPATCH_N_SLOTS];
+	LV2_Atom_Event_Handler  fallback;     /**< Handler for other events */
+	uint32_t                n_unhandled;  /**< Number of unhandled events */
+	uint32_t                object;       /**< URID of atom:Object */
+	uint32_t                blank;        /**< Alias for atom:Object */
+	uint32_t                resource;     /**< Alias for atom:Object */
+} LV2_Atom_Dispatch;
+
+/**
+   Initialise an empty dispatch table.
+
+   Events with type `object` are dispatched by object type as well as event
+   type.  Events with type `blank` or `resource` are treated as if they have
+   type `object`, to support the deprecated atom:Blank and atom:Resource types.
+   Either may be zero if there is no such alias.
+*/
+static inline void
+lv2_atom_dispatch_init(LV2_Atom_Dispatch* dispatch,
+                       uint32_t           object,
+                       uint32_t           blank,
+                       uint32_t           resource)
+{
+	memset(dispatch, 0, sizeof(LV2_Atom_Dispatch));
+	dispatch->object   = object;
+	dispatch->blank    = blank ? blank : object;
+	dispatch->resource = resource ? resource : object;
+}
+
+/** Return the slot where the search for an entry starts.  Used internally. */
+static inline uint32_t
+lv2_atom_dispatch_slot(uint32_t type, uint32_t otype)
+{
+	const uint32_t h = (type * 2654435769U) ^ (otype * 2246822519U);
+	return h % LV2_ATOM_DISPATCH_N_SLOTS;
+}
+
+/** Find the entry for an event and object type, or return NULL. */
+static inline LV2_Atom_Dispatch_Entry*
+lv2_atom_dispatch_find(LV2_Atom_Dispatch* dispatch,
+                       uint32_t           type,
+                       uint32_t           otype)
+{
+	uint32_t s = lv2_atom_dispatch_slot(type, otype);
+	for (uint32_t n = 0; n < LV2_ATOM_DISPATCH_N_SLOTS; ++n) {
+		LV2_Atom_Dispatch_Entry* const e = &dispatch->entries[s];
+		if (!e->type) {
+			return NULL;
+		} else if (e->type == type && e->otype == otype) {
+			return e;
+		}
+		s = (s + 1) % LV2_ATOM_DISPATCH_N_SLOTS;
+	}
+	return NULL;
+}
+
+/**
+   Add a handler to a dispatch table.
+
+   @param dispatch The table to add the handler to.
+   @param type The event type, e.g. the URID of midi:MidiEvent or atom:Object.
+   @param otype The object type, or 0 to handle all events of type `type` that
+   have no more specific handler.
+   @param handler Function to call for matching events.
+
+   @return True on success, or false if all LV2_ATOM_DISPATCH_N_SLOTS slots
+   are in use.  If a handler for these types is already present, it is
+   replaced, even if the table is full.
+*/
+static inline bool
+lv2_atom_dispatch_add(LV2_Atom_Dispatch*     dispatch,
+                      uint32_t               type,
+                      uint32_t               otype,
+                      LV2_Atom_Event_Handler handler)
+{
+	uint32_t s = lv2_atom_dispatch_slot(type, otype);
+	for (uint32_t n = 0; n < LV2_ATOM_DISPATCH_N_SLOTS; ++n) {
+		LV2_Atom_Dispatch_Entry* const e = &dispatch->entries[s];
+		if (!e->type || (e->type == type && e->otype == otype)) {
+			e->type    = type;
+			e->otype   = otype;
+			e->handler = handler;
+			return true;
+		}
+		s = (s + 1) % LV2_ATOM_DISPATCH_N_SLOTS;
+	}
+	return false;
+}
+
+/**
+   Dispatch a single event to the appropriate handler.
+
+   The handler for the event and object type is called if present, otherwise
+   the handler for the event type (with object type 0), otherwise the
+   fallback handler.  This function is realtime safe if the handler is.
+
+   @return True iff a handler other than the fallback was called.
+*/
+static inline bool
+lv2_atom_dispatch_event(LV2_Atom_Dispatch*    dispatch,
+                        void*                 handle,
+                        const LV2_Atom_Event* ev)
+{
+	uint32_t type  = ev->body.type;
+	uint32_t otype = 0;
+	if (type && (type == dispatch->object ||
+	             type == dispatch->blank ||
+	             type == dispatch->resource) &&
+	    ev->body.size >= sizeof(LV2_Atom_Object_Body)) {
+		type  = dispatch->object;
+		otype = ((const LV2_Atom_Object*)&ev->body)->body.otype;
+	}
+
+	LV2_Atom_Dispatch_Entry* e = lv2_atom_dispatch_find(dispatch, type, otype);
+	if (!e && otype) {
+		e = lv2_atom_dispatch_find(dispatch, type, 0);
+	}
+
+	if (e) {
+		++e->count;
+		e->handler(handle, ev);
+		return true;
+	}
+
+	++dispatch->n_unhandled;
+	if (dispatch->fallback) {
+		dispatch->fallback(handle, ev);
+	}
+	return false;
+}
+
+/** Dispatch every event in `seq`.  See lv2_atom_dispatch_event(). */
+static inline void
+lv2_atom_dispatch_sequence(LV2_Atom_Dispatch*       dispatch,
+                           void*                    handle,
+                           const LV2_Atom_Sequence* seq)
+{
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		lv2_atom_dispatch_event(dispatch, handle, ev);
+	}
+}
+
+/**
+   @}
+   @name Tuple Iterator
+   @{
+*/
+
+/** Get an iterator pointing to the first element in `tup`. */
+static inline LV2_Atom*
+lv2_atom_tuple_begin(const LV2_Atom_Tuple* tup)
+{
+	return (LV2_Atom*)(LV2_ATOM_BODY(tup));
+}
+
+/** Return true iff `i` has reached the end of `body`. */
+static inline bool
+lv2_atom_tuple_is_end(const void* body, uint32_t size, const LV2_Atom* i)
+{
+	return (const uint8_t*)i >= ((const uint8_t*)body + size);
+}
+
+/** Return an iterator to the element following `i`. */
+static inline LV2_Atom*
+lv2_atom_tuple_next(const LV2_Atom* i)
+{
+	return (LV2_Atom*)(
+		(const uint8_t*)i + sizeof(LV2_Atom) + lv2_atom_pad_size(i->size));
+}
+
+/**
+   A macro for iterating over all properties of a Tuple.
+   @param tuple The tuple to iterate over
+   @param iter The name of the iterator
+
+   This macro is used similarly to a for loop (which it expands to), e.g.:
+   @code
+   LV2_ATOMO_TUPLE_FOREACH(tuple, elem) {
+       // Do something with elem (an LV2_Atom*) here...
+   }
+   @endcode
+*/
+#define LV2_ATOM_TUPLE_FOREACH(tuple, iter) \
+	for (LV2_Atom* iter = lv2_atom_tuple_begin(tuple); \
+	     !lv2_atom_tuple_is_end(LV2_ATOM_BODY(tuple), (tuple)->size, (iter)); \
+	     (iter) = lv2_atom_tuple_next(iter))
+
+/** Like LV2_ATOM_TUPLE_FOREACH but for a headerless tuple body. */
+#define LV2_ATOM_TUPLE_BODY_FOREACH(body, size, iter) \
+	for (LV2_Atom* iter = (LV2_Atom*)body; \
+	     !lv2_atom_tuple_is_end(body, size, (iter)); \
+	     (iter) = lv2_atom_tuple_next(iter))
+
+/**
+   @}
+   @name Object Iterator
+   @{
+*/
+
+/** Return a pointer to the first property in `body`. */
+static inline LV2_Atom_Property_Body*
+lv2_atom_object_begin(const LV2_Atom_Object_Body* body)
+{
+	return (LV2_Atom_Property_Body*)(body + 1);
+}
+
+/** Return true iff `i` has reached the end of `obj`. */
+static inline bool
+lv2_atom_object_is_end(const LV2_Atom_Object_Body*   body,
+                       uint32_t                      size,
+                       const LV2_Atom_Property_Body* i)
+{
+	return (const uint8_t*)i >= ((const uint8_t*)body + size);
+}
+
+/** Return an iterator to the property following `i`. */
+static inline LV2_Atom_Property_Body*
+lv2_atom_object_next(const LV2_Atom_Property_Body* i)
+{
+	const LV2_Atom* const value = (const LV2_Atom*)(
+		(const uint8_t*)i + 2 * sizeof(uint32_t));
+	return (LV2_Atom_Property_Body*)(
+		(const uint8_t*)i + lv2_atom_pad_size(
+			(uint32_t)sizeof(LV2_Atom_Property_Body) + value->size));
+}
+
+/**
+   A macro for iterating over all properties of an Object.
+   @param obj The object to iterate over
+   @param iter The name of the iterator
+
+   This macro is used similarly to a for loop (which it expands to), e.g.:
+   @code
+   LV2_ATOM_OBJECT_FOREACH(object, i) {
+       // Do something with prop (an LV2_Atom_Property_Body*) here...
+   }
+   @endcode
+*/
+#define LV2_ATOM_OBJECT_FOREACH(obj, iter) \
+	for (LV2_Atom_Property_Body* iter = lv2_atom_object_begin(&(obj)->body); \
+	     !lv2_atom_object_is_end(&(obj)->body, (obj)->atom.size, (iter)); \
+	     (iter) = lv2_atom_object_next(iter))
+
+/** Like LV2_ATOM_OBJECT_FOREACH but for a headerless object body. */
+#define LV2_ATOM_OBJECT_BODY_FOREACH(body, size, iter) \
+	for (LV2_Atom_Property_Body* iter = lv2_atom_object_begin(body); \
+	     !lv2_atom_object_is_end(body, size, (iter)); \
+	     (iter) = lv2_atom_object_next(iter))
+
+/**
+   @}
+   @name Object Query
+   @{
+*/
+
+/** A single entry in an Object query. */
+typedef struct {
+	uint32_t         key;    /**< Key to query (input set by user) */
+	const LV2_Atom** value;  /**< Found value (output set by query function) */
+} LV2_Atom_Object_Query;
+
+static const LV2_Atom_Object_Query LV2_ATOM_OBJECT_QUERY_END = { 0, NULL };
+
+/**
+   Get an object's values for various keys.
+
+   The value pointer of each item in `query` will be set to the location of
+   the corresponding value in `object`.  Every value pointer in `query` MUST
+   be initialised to NULL.  This function reads `object` in a single linear
+   sweep.  By allocating `query` on the stack, objects can be "queried"
+   quickly without allocating any memory.  This function is realtime safe.
+
+   This function can only do "flat" queries, it is not smart enough to match
+   variables in nested objects.
+
+   For example:
+   @code
+   const LV2_Atom* name = NULL;
+   const LV2_Atom* age  = NULL;
+   LV2_Atom_Object_Query q[] = {
+       { urids.eg_name, &name },
+       { urids.eg_age,  &age },
+       LV2_ATOM_OBJECT_QUERY_END
+   };
+   lv2_atom_object_query(obj, q);
    // name and age are now set to the appropriate values in obj, or NULL.
    @endcode
 */
@@ -342,97 +1430,885 @@ lv2_atom_object_query(const LV2_Atom_Object* object,
 			}
 		}
 	}
-	return matches;
+	return matches;
+}
+
+/**
+   Body only version of lv2_atom_object_get().
+*/
+static inline int
+lv2_atom_object_body_get(uint32_t size, const LV2_Atom_Object_Body* body, ...)
+{
+	int matches   = 0;
+	int n_queries = 0;
+
+	/* Count number of keys so we can short-circuit when done */
+	va_list args;
+	va_start(args, body);
+	for (n_queries = 0; va_arg(args, uint32_t); ++n_queries) {
+		if (!va_arg(args, const LV2_Atom**)) {
+			return -1;
+		}
+	}
+	va_end(args);
+
+	LV2_ATOM_OBJECT_BODY_FOREACH(body, size, prop) {
+		va_start(args, body);
+		for (int i = 0; i < n_queries; ++i) {
+			uint32_t         qkey = va_arg(args, uint32_t);
+			const LV2_Atom** qval = va_arg(args, const LV2_Atom**);
+			if (qkey == prop->key && !*qval) {
+				*qval = &prop->value;
+				if (++matches == n_queries) {
+					return matches;
+				}
+				break;
+			}
+		}
+		va_end(args);
+	}
+	return matches;
+}
+
+/**
+   Variable argument version of lv2_atom_object_query().
+
+   This is nicer-looking in code, but a bit more error-prone since it is not
+   type safe and the argument list must be terminated.
+
+   The arguments should be a series of uint32_t key and const LV2_Atom** value
+   pairs, terminated by a zero key.  The value pointers MUST be initialized to
+   NULL.  For example:
+
+   @code
+   const LV2_Atom* name = NULL;
+   const LV2_Atom* age  = NULL;
+   lv2_atom_object_get(obj,
+                       uris.name_key, &name,
+                       uris.age_key,  &age,
+                       0);
+   @endcode
+*/
+static inline int
+lv2_atom_object_get(const LV2_Atom_Object* object, ...)
+{
+	int matches   = 0;
+	int n_queries = 0;
+
+	/* Count number of keys so we can short-circuit when done */
+	va_list args;
+	va_start(args, object);
+	for (n_queries = 0; va_arg(args, uint32_t); ++n_queries) {
+		if (!va_arg(args, const LV2_Atom**)) {
+			return -1;
+		}
+	}
+	va_end(args);
+
+	LV2_ATOM_OBJECT_FOREACH(object, prop) {
+		va_start(args, object);
+		for (int i = 0; i < n_queries; ++i) {
+			uint32_t         qkey = va_arg(args, uint32_t);
+			const LV2_Atom** qval = va_arg(args, const LV2_Atom**);
+			if (qkey == prop->key && !*qval) {
+				*qval = &prop->value;
+				if (++matches == n_queries) {
+					return matches;
+				}
+				break;
+			}
+		}
+		va_end(args);
+	}
+	return matches;
+}
+
+/**
+   @}
+   @name Object Query Plan
+   @{
+*/
+
+/** The maximum number of keys in an LV2_Atom_Object_Plan. */
+#define LV2_ATOM_OBJECT_PLAN_MAX_KEYS 32
+
+/** The number of hash table slots in an LV2_Atom_Object_Plan. */
+#define LV2_ATOM_OBJECT_PLAN_N_SLOTS (2 * LV2_ATOM_OBJECT_PLAN_MAX_KEYS)
+
+/**
+   A compiled Object query for a fixed set of keys.
+
+   A plan is built once with lv2_atom_object_plan_init(), typically in
+   instantiate(), and can then be used to query any number of objects with
+   lv2_atom_object_plan_query().  The keys are stored in a small hash table, so
+   each property in the object is matched with (usually) a single probe,
+   instead of a scan over every key as in lv2_atom_object_query().
+
+   This is plain old data which contains no pointers, it may be copied freely.
+*/
+typedef struct {
+	uint32_t n_keys;  /**< Number of keys in the query */
+	uint32_t bits;    /**< Number of bits in hash (log2 of table size) */
+	uint32_t keys[LV2_ATOM_OBJECT_PLAN_N_SLOTS];    /**< Key, or 0 if empty */
+	uint8_t  indices[LV2_ATOM_OBJECT_PLAN_N_SLOTS]; /**< Index of key */
+} LV2_Atom_Object_Plan;
+
+/** Return the hash table slot where the search for `key` starts. */
+static inline uint32_t
+lv2_atom_object_plan_slot(const LV2_Atom_Object_Plan* plan, uint32_t key)
+{
+	return (uint32_t)(key * 2654435769U) >> (32U - plan->bits);
+}
+
+/**
+   Initialise `plan` to query the `n_keys` keys in `keys`.
+
+   @return True on success, or false if there are more than
+   LV2_ATOM_OBJECT_PLAN_MAX_KEYS keys, or any key is zero or a duplicate.
+*/
+static inline bool
+lv2_atom_object_plan_init(LV2_Atom_Object_Plan* plan,
+                          uint32_t              n_keys,
+                          const uint32_t*       keys)
+{
+	memset(plan, 0, sizeof(LV2_Atom_Object_Plan));
+	if (n_keys > LV2_ATOM_OBJECT_PLAN_MAX_KEYS) {
+		return false;
+	}
+
+	/* Use the smallest table that is at most half full */
+	plan->n_keys = n_keys;
+	plan->bits   = 2;
+	while ((1U << plan->bits) < 2 * n_keys) {
+		++plan->bits;
+	}
+
+	const uint32_t mask = (1U << plan->bits) - 1U;
+	for (uint32_t i = 0; i < n_keys; ++i) {
+		if (!keys[i]) {
+			return false;  // Invalid key
+		}
+
+		uint32_t s = lv2_atom_object_plan_slot(plan, keys[i]);
+		for (; plan->keys[s]; s = (s + 1) & mask) {
+			if (plan->keys[s] == keys[i]) {
+				return false;  // Duplicate key
+			}
+		}
+		plan->keys[s]    = keys[i];
+		plan->indices[s] = (uint8_t)i;
+	}
+	return true;
 }
 
 /**
-   Body only version of lv2_atom_object_get().
+   Body only version of lv2_atom_object_plan_query().
 */
 static inline int
-lv2_atom_object_body_get(uint32_t size, const LV2_Atom_Object_Body* body, ...)
+lv2_atom_object_plan_body_query(const LV2_Atom_Object_Plan* plan,
+                                uint32_t                    size,
+                                const LV2_Atom_Object_Body* body,
+                                const LV2_Atom**            values)
 {
-	int matches   = 0;
-	int n_queries = 0;
+	const uint32_t mask    = (1U << plan->bits) - 1U;
+	const int      n_keys  = (int)plan->n_keys;
+	int            matches = 0;
 
-	/* Count number of keys so we can short-circuit when done */
-	va_list args;
-	va_start(args, body);
-	for (n_queries = 0; va_arg(args, uint32_t); ++n_queries) {
-		if (!va_arg(args, const LV2_Atom**)) {
-			return -1;
-		}
+	memset(values, 0, plan->n_keys * sizeof(const LV2_Atom*));
+	if (!n_keys) {
+		return 0;
 	}
-	va_end(args);
 
 	LV2_ATOM_OBJECT_BODY_FOREACH(body, size, prop) {
-		va_start(args, body);
-		for (int i = 0; i < n_queries; ++i) {
-			uint32_t         qkey = va_arg(args, uint32_t);
-			const LV2_Atom** qval = va_arg(args, const LV2_Atom**);
-			if (qkey == prop->key && !*qval) {
-				*qval = &prop->value;
-				if (++matches == n_queries) {
-					return matches;
+		uint32_t s = lv2_atom_object_plan_slot(plan, prop->key);
+		for (; plan->keys[s]; s = (s + 1) & mask) {
+			if (plan->keys[s] == prop->key) {
+				const LV2_Atom** value = &values[plan->indices[s]];
+				if (!*value) {
+					*value = &prop->value;
+					if (++matches == n_keys) {
+						return matches;
+					}
 				}
 				break;
 			}
 		}
-		va_end(args);
 	}
 	return matches;
 }
 
 /**
-   Variable argument version of lv2_atom_object_query().
-
-   This is nicer-looking in code, but a bit more error-prone since it is not
-   type safe and the argument list must be terminated.
+   Get an object's values for the keys in a compiled query plan.
 
-   The arguments should be a series of uint32_t key and const LV2_Atom** value
-   pairs, terminated by a zero key.  The value pointers MUST be initialized to
-   NULL.  For example:
+   This is equivalent to lv2_atom_object_query(), but faster since the keys do
+   not need to be counted or scanned for every property.  The value for the
+   plan's key at index `i` will be written to `values[i]`, or set to NULL if
+   the key is not present in `object`.  If a key occurs several times, the
+   first value is used.  This function is realtime safe.
 
+   For example:
    @code
-   const LV2_Atom* name = NULL;
-   const LV2_Atom* age  = NULL;
-   lv2_atom_object_get(obj,
-                       uris.name_key, &name,
-                       uris.age_key,  &age,
-                       0);
+   // In instantiate()
+   const uint32_t keys[] = { uris.time_barBeat, uris.time_speed };
+   lv2_atom_object_plan_init(&self->position_plan, 2, keys);
+
+   // In run()
+   const LV2_Atom* values[2];
+   lv2_atom_object_plan_query(&self->position_plan, obj, values);
+   // values[0] and values[1] are now the bar beat and speed in obj, or NULL.
    @endcode
+
+   @param plan Query plan built with lv2_atom_object_plan_init().
+   @param object Object to query.
+   @param values Array of at least `plan->n_keys` value pointers to set.
+   @return The number of keys found.
 */
 static inline int
-lv2_atom_object_get(const LV2_Atom_Object* object, ...)
+lv2_atom_object_plan_query(const LV2_Atom_Object_Plan* plan,
+                           const LV2_Atom_Object*      object,
+                           const LV2_Atom**            values)
 {
-	int matches   = 0;
-	int n_queries = 0;
+	return lv2_atom_object_plan_body_query(
+		plan, object->atom.size, &object->body, values);
+}
 
-	/* Count number of keys so we can short-circuit when done */
-	va_list args;
-	va_start(args, object);
-	for (n_queries = 0; va_arg(args, uint32_t); ++n_queries) {
-		if (!va_arg(args, const LV2_Atom**)) {
-			return -1;
+/**
+   @}
+   @name Sorted Objects
+   @{
+*/
+
+/**
+   Compare two properties by key, then context.
+
+   @return Less than, equal to, or greater than zero if `a` sorts before, the
+   same as, or after `b`, respectively.
+*/
+static inline int
+lv2_atom_property_compare(const LV2_Atom_Property_Body* a,
+                          const LV2_Atom_Property_Body* b)
+{
+	if (a->key != b->key) {
+		return a->key < b->key ? -1 : 1;
+	} else if (a->context != b->context) {
+		return a->context < b->context ? -1 : 1;
+	}
+	return 0;
+}
+
+/** Return the size of property `prop`, including padding. */
+static inline uint32_t
+lv2_atom_property_size(const LV2_Atom_Property_Body* prop)
+{
+	return lv2_atom_pad_size(
+		(uint32_t)sizeof(LV2_Atom_Property_Body) + prop->value.size);
+}
+
+/** Body only version of lv2_atom_object_is_sorted(). */
+static inline bool
+lv2_atom_object_body_is_sorted(uint32_t size, const LV2_Atom_Object_Body* body)
+{
+	const LV2_Atom_Property_Body* prev = NULL;
+	LV2_ATOM_OBJECT_BODY_FOREACH(body, size, prop) {
+		if (prev && lv2_atom_property_compare(prev, prop) > 0) {
+			return false;
 		}
+		prev = prop;
 	}
-	va_end(args);
+	return true;
+}
+
+/**
+   Return true iff the properties of `object` are sorted.
+
+   An object is sorted if its properties are in ascending order by key, then
+   context, as produced by lv2_atom_object_sort().  Sorted objects are a
+   canonical form: two sorted objects with the same properties are
+   byte-for-byte identical, so lv2_atom_equals() compares them correctly
+   (unless they have properties with the same key and context in a different
+   order, which a well-formed object does not).  This is a single scan over
+   the properties, there is no flag in the object to indicate sorting.
+*/
+static inline bool
+lv2_atom_object_is_sorted(const LV2_Atom_Object* object)
+{
+	return lv2_atom_object_body_is_sorted(object->atom.size, &object->body);
+}
+
+/** Reverse `size` bytes at `buf`.  Used internally. */
+static inline void
+lv2_atom_reverse_bytes(uint8_t* buf, uint32_t size)
+{
+	for (uint8_t* l = buf, *r = buf + size - 1; l < r; ++l, --r) {
+		const uint8_t c = *l;
+		*l = *r;
+		*r = c;
+	}
+}
+
+/**
+   Move `size` bytes at `src` back to `dst`, shifting the bytes in between
+   forward to make room.  Used internally.
+*/
+static inline void
+lv2_atom_move_back(uint8_t* dst, uint8_t* src, uint32_t size)
+{
+	uint64_t tmp[32];
+	if (size <= sizeof(tmp)) {
+		memcpy(tmp, src, size);
+		memmove(dst + size, dst, (size_t)(src - dst));
+		memcpy(dst, tmp, size);
+	} else {
+		// Rotate [dst, src + size) by reversing in place
+		lv2_atom_reverse_bytes(dst, (uint32_t)(src - dst));
+		lv2_atom_reverse_bytes(src, size);
+		lv2_atom_reverse_bytes(dst, (uint32_t)(src + size - dst));
+	}
+}
+
+/** Body only version of lv2_atom_object_sort(). */
+static inline bool
+lv2_atom_object_body_sort(uint32_t size, LV2_Atom_Object_Body* body)
+{
+	uint8_t* const begin = (uint8_t*)lv2_atom_object_begin(body);
+	uint8_t* const end   = (uint8_t*)body + size;
+	uint8_t*       last  = NULL;  // Last property in the sorted prefix
+
+	for (uint8_t* p = begin; p < end;) {
+		const LV2_Atom_Property_Body* prop = (const LV2_Atom_Property_Body*)p;
+		const uint32_t prop_size = lv2_atom_property_size(prop);
+		if (last && lv2_atom_property_compare(
+			    (const LV2_Atom_Property_Body*)last, prop) > 0) {
+			if (p + prop_size > end) {
+				return false;  // Unpadded last property, can not be moved
+			}
+
+			// Find the first property that sorts after this one (stable)
+			uint8_t* pos = begin;
+			while (lv2_atom_property_compare(
+				       (const LV2_Atom_Property_Body*)pos, prop) <= 0) {
+				pos += lv2_atom_property_size((LV2_Atom_Property_Body*)pos);
+			}
+
+			lv2_atom_move_back(pos, p, prop_size);
+			last += prop_size;
+		} else {
+			last = p;
+		}
+		p += prop_size;
+	}
+	return true;
+}
+
+/**
+   Sort the properties of `object` in place.
+
+   Properties are sorted by key, then context, and properties which compare
+   equal stay in their original order.  This is realtime safe and does not
+   allocate, properties are moved within the object.  It takes linear time if
+   the object is already (nearly) sorted, and quadratic time in the worst case,
+   which is fast enough for objects with hundreds of properties.
+
+   Every property except the last must be padded to 64 bits, as those written
+   by the forge are.
+
+   @return True on success, or false if the last property is not padded and
+   would need to be moved, in which case the object is partially sorted.
+*/
+static inline bool
+lv2_atom_object_sort(LV2_Atom_Object* object)
+{
+	return lv2_atom_object_body_sort(object->atom.size, &object->body);
+}
+
+/**
+   An index of the properties in an Object for lookup by key.
 
+   Like LV2_Atom_Sequence_Index, this stores property offsets in a buffer
+   provided by the caller.  The offsets are in sorted order, so properties can
+   be found with a binary search.  The object is not modified and must outlive
+   the index.
+*/
+typedef struct {
+	const LV2_Atom_Object_Body* body;     /**< Indexed object body */
+	const uint32_t*             offsets;  /**< Sorted property offsets */
+	uint32_t                    n_props;  /**< Number of properties */
+	bool                        sorted;   /**< True iff object is sorted */
+} LV2_Atom_Object_Index;
+
+/** Return the indexed property at offset `offset`.  Used internally. */
+static inline const LV2_Atom_Property_Body*
+lv2_atom_object_index_at(const LV2_Atom_Object_Body* body, uint32_t offset)
+{
+	return (const LV2_Atom_Property_Body*)((const uint8_t*)body + offset);
+}
+
+/**
+   Build an index of the properties in `object`.
+
+   This scans the object once, and then sorts the offsets if the object is not
+   already sorted.  Building an index is only worthwhile for large objects that
+   are queried several times, it is cheapest for objects made canonical with
+   lv2_atom_object_sort() or lv2_atom_forge_pop_sorted().  This function is
+   realtime safe.
+
+   @param index The index to initialise.
+   @param object The object to index.
+   @param offsets Buffer for property offsets, with space for `max_props`.
+   @param max_props The maximum number of properties that can be indexed.
+
+   @return True on success.  If the object contains more than `max_props`
+   properties, false is returned, and only the first `max_props` properties
+   are indexed, so the index is still safe to use, but may not find every key.
+*/
+static inline bool
+lv2_atom_object_index_init(LV2_Atom_Object_Index* index,
+                           const LV2_Atom_Object* object,
+                           uint32_t*              offsets,
+                           uint32_t               max_props)
+{
+	const LV2_Atom_Object_Body* const body = &object->body;
+
+	uint32_t n      = 0;
+	bool     sorted = true;
 	LV2_ATOM_OBJECT_FOREACH(object, prop) {
-		va_start(args, object);
-		for (int i = 0; i < n_queries; ++i) {
-			uint32_t         qkey = va_arg(args, uint32_t);
-			const LV2_Atom** qval = va_arg(args, const LV2_Atom**);
-			if (qkey == prop->key && !*qval) {
-				*qval = &prop->value;
-				if (++matches == n_queries) {
-					return matches;
-				}
-				break;
+		if (n < max_props) {
+			offsets[n] = (uint32_t)((const uint8_t*)prop - (const uint8_t*)body);
+			sorted     = sorted && (n == 0 || lv2_atom_property_compare(
+				lv2_atom_object_index_at(body, offsets[n - 1]), prop) <= 0);
+		}
+		++n;
+	}
+
+	const uint32_t n_indexed = n < max_props ? n : max_props;
+
+	index->body    = body;
+	index->offsets = offsets;
+	index->n_props = n_indexed;
+	index->sorted  = sorted && n == n_indexed;
+
+	if (!sorted) {
+		// Insertion sort offsets, which is stable and fast for nearly sorted
+		for (uint32_t i = 1; i < n_indexed; ++i) {
+			const uint32_t                offset = offsets[i];
+			const LV2_Atom_Property_Body* prop   =
+				lv2_atom_object_index_at(body, offset);
+
+			uint32_t j = i;
+			for (; j > 0 && lv2_atom_property_compare(
+				     lv2_atom_object_index_at(body, offsets[j - 1]), prop) > 0;
+			     --j) {
+				offsets[j] = offsets[j - 1];
 			}
+			offsets[j] = offset;
 		}
-		va_end(args);
 	}
-	return matches;
+	return n == n_indexed;
+}
+
+/**
+   Return the first property with `key` in `index`, or NULL.
+
+   This is a binary search, so takes logarithmic time in the number of
+   properties.  If several properties have `key`, the one with the lowest
+   context is returned.
+*/
+static inline const LV2_Atom_Property_Body*
+lv2_atom_object_index_find(const LV2_Atom_Object_Index* index, uint32_t key)
+{
+	uint32_t lo = 0;
+	uint32_t hi = index->n_props;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (lv2_atom_object_index_at(index->body, index->offsets[mid])->key <
+		    key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo < index->n_props) {
+		const LV2_Atom_Property_Body* prop = lv2_atom_object_index_at(
+			index->body, index->offsets[lo]);
+		if (prop->key == key) {
+			return prop;
+		}
+	}
+	return NULL;
+}
+
+/** Return the value of the first property with `key` in `index`, or NULL. */
+static inline const LV2_Atom*
+lv2_atom_object_index_get(const LV2_Atom_Object_Index* index, uint32_t key)
+{
+	const LV2_Atom_Property_Body* prop = lv2_atom_object_index_find(index, key);
+	return prop ? &prop->value : NULL;
+}
+
+/**
+   @}
+   @name Sequence Sorting
+   @{
+*/
+
+/**
+   Return the size of event `ev` in `seq`, including padding if present.
+
+   This is the size of the event with its body padded to 64 bits, unless it is
+   the last event and the sequence is not padded.  Used internally.
+*/
+static inline uint32_t
+lv2_atom_sequence_event_size(const LV2_Atom_Sequence* seq,
+                             const LV2_Atom_Event*    ev)
+{
+	const uint8_t* const end    = (const uint8_t*)&seq->body + seq->atom.size;
+	const uint32_t       rest   = (uint32_t)(end - (const uint8_t*)ev);
+	const uint32_t       padded = (uint32_t)sizeof(LV2_Atom_Event) +
+		lv2_atom_pad_size(ev->body.size);
+	return padded < rest ? padded : rest;
+}
+
+/**
+   Return true iff the events in `seq` are ordered by time.
+
+   @param seq The sequence to check.
+   @param beat_time URID of atom:beatTime, or 0 if beat time is not supported.
+*/
+static inline bool
+lv2_atom_sequence_is_sorted(const LV2_Atom_Sequence* seq, uint32_t beat_time)
+{
+	const bool            beats = beat_time && seq->body.unit == beat_time;
+	const LV2_Atom_Event* prev  = NULL;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		if (prev && lv2_atom_event_is_before(ev, prev, beats)) {
+			return false;
+		}
+		prev = ev;
+	}
+	return true;
+}
+
+/**
+   Sort the events of `seq` in place by moving them within the sequence.
+
+   This is a stable insertion sort that moves each event back within the
+   sequence, so it needs no extra space, but takes quadratic time if many
+   events are out of order.  Used internally, see lv2_atom_sequence_sort().
+*/
+static inline bool
+lv2_atom_sequence_sort_in_place(LV2_Atom_Sequence* seq, bool beats)
+{
+	uint8_t* const begin = (uint8_t*)lv2_atom_sequence_begin(&seq->body);
+	uint8_t* const end   = (uint8_t*)&seq->body + seq->atom.size;
+	uint8_t*       last  = NULL;  // Last event in the sorted prefix
+
+	for (uint8_t* p = begin; p < end;) {
+		const LV2_Atom_Event* ev      = (const LV2_Atom_Event*)p;
+		const uint32_t        ev_size = lv2_atom_sequence_event_size(seq, ev);
+		if (last && lv2_atom_event_is_before(
+			    ev, (const LV2_Atom_Event*)last, beats)) {
+			if (ev_size % 8) {
+				return false;  // Unpadded last event, can not be moved
+			}
+
+			// Find the first event that is after this one (stable)
+			uint8_t* pos = begin;
+			while (!lv2_atom_event_is_before(
+				       ev, (const LV2_Atom_Event*)pos, beats)) {
+				pos += lv2_atom_sequence_event_size(
+					seq, (const LV2_Atom_Event*)pos);
+			}
+
+			lv2_atom_move_back(pos, p, ev_size);
+			last += ev_size;
+		} else {
+			last = p;
+		}
+		p += ev_size;
+	}
+	return true;
+}
+
+/**
+   Return the scratch space lv2_atom_sequence_sort() needs to sort `seq` with
+   an index.
+*/
+static inline uint64_t
+lv2_atom_sequence_sort_scratch_size(const LV2_Atom_Sequence* seq)
+{
+	uint64_t n_events = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		++n_events;
+	}
+	return lv2_atom_pad_size((uint32_t)(n_events * sizeof(uint32_t))) +
+		seq->atom.size - sizeof(LV2_Atom_Sequence_Body);
+}
+
+/**
+   Sort the events of `seq` by time.
+
+   Events with equal time stamps stay in their original order, so the sort is
+   stable.  This makes it possible to write events out of order, for example
+   one voice at a time in a polyphonic synth, then sort them once at the end.
+
+   If `scratch` is large enough, an index of the events is sorted there (with
+   a merge sort), then the events are copied to the scratch space in order and
+   back into the sequence, so every event is only moved twice.  Otherwise,
+   events are sorted in place, which is slower if there are many events out of
+   order.  The space required is 4 bytes per event (padded to 64 bits), plus
+   the size of the events, see lv2_atom_sequence_sort_scratch_size().
+
+   This does not allocate memory and is realtime safe.  Any pointers to events
+   in `seq` are invalidated.
+
+   @param seq The sequence to sort.
+   @param beat_time URID of atom:beatTime, or 0 if beat time is not supported.
+   If the unit of `seq` is `beat_time`, events are sorted by beats, otherwise by
+   frames.
+   @param scratch Scratch space, which must be 64-bit aligned, or NULL.
+   @param scratch_size Size of `scratch` in bytes.
+   @return True on success, or false if the last event is not padded and would
+   need to be moved, in which case the sequence may be partially sorted.
+*/
+static inline bool
+lv2_atom_sequence_sort(LV2_Atom_Sequence* seq,
+                       uint32_t           beat_time,
+                       void*              scratch,
+                       uint32_t           scratch_size)
+{
+	const bool beats = beat_time && seq->body.unit == beat_time;
+
+	// Count events, and return early if they are already sorted
+	uint32_t              n_events = 0;
+	bool                  sorted   = true;
+	const LV2_Atom_Event* prev     = NULL;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		sorted = sorted && !(prev && lv2_atom_event_is_before(ev, prev, beats));
+		prev   = ev;
+		++n_events;
+	}
+	if (sorted) {
+		return true;
+	}
+
+	uint8_t* const begin       = (uint8_t*)lv2_atom_sequence_begin(&seq->body);
+	const uint32_t events_size = seq->atom.size - sizeof(LV2_Atom_Sequence_Body);
+	const uint32_t index_size  = lv2_atom_pad_size(n_events * sizeof(uint32_t));
+	if (!scratch || (uint64_t)index_size + events_size > scratch_size) {
+		return lv2_atom_sequence_sort_in_place(seq, beats);
+	}
+
+	// Build an index of event offsets, using the copy space as a temporary
+	uint32_t*      index = (uint32_t*)scratch;
+	uint8_t* const copy  = (uint8_t*)scratch + index_size;
+	uint32_t*      tmp   = (uint32_t*)copy;
+	uint32_t       i     = 0;
+	LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+		index[i++] = (uint32_t)((uint8_t*)ev - begin);
+	}
+
+	// Sort index with a bottom-up merge sort
+	for (uint32_t width = 1; width < n_events; width *= 2) {
+		for (uint32_t lo = 0; lo < n_events; lo += 2 * width) {
+			const uint32_t mid = lo + width < n_events ? lo + width : n_events;
+			const uint32_t hi  = mid + width < n_events ? mid + width : n_events;
+			uint32_t       l   = lo;
+			uint32_t       r   = mid;
+			for (uint32_t o = lo; o < hi; ++o) {
+				const bool left =
+					r == hi ||
+					(l < mid &&
+					 !lv2_atom_event_is_before(
+						 (const LV2_Atom_Event*)(begin + index[r]),
+						 (const LV2_Atom_Event*)(begin + index[l]),
+						 beats));
+				tmp[o] = left ? index[l++] : index[r++];
+			}
+		}
+		uint32_t* const t = index;
+		index = tmp;
+		tmp   = t;
+	}
+	if (index != (uint32_t*)scratch) {
+		memcpy(scratch, index, n_events * sizeof(uint32_t));
+		index = (uint32_t*)scratch;
+	}
+
+	// Check that an unpadded last event stays last
+	const LV2_Atom_Event* const last = (LV2_Atom_Event*)(
+		begin + index[n_events - 1]);
+	if (events_size % 8 && (uint8_t*)last != (uint8_t*)prev) {
+		return false;
+	}
+
+	// Copy events to scratch space in order, then back
+	uint32_t offset = 0;
+	for (i = 0; i < n_events; ++i) {
+		const LV2_Atom_Event* ev      = (LV2_Atom_Event*)(begin + index[i]);
+		const uint32_t        ev_size = lv2_atom_sequence_event_size(seq, ev);
+		memcpy(copy + offset, ev, ev_size);
+		offset += ev_size;
+	}
+	memcpy(begin, copy, events_size);
+	return true;
+}
+
+/**
+   @}
+   @name Hashing
+   @{
+*/
+
+#define LV2_ATOM_HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define LV2_ATOM_HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define LV2_ATOM_HASH_PRIME3 0x165667B19E3779F9ULL
+#define LV2_ATOM_HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define LV2_ATOM_HASH_PRIME5 0x27D4EB2F165667C5ULL
+
+/** Rotate `x` left by `r` bits.  Used internally. */
+static inline uint64_t
+lv2_atom_hash_rotl(uint64_t x, unsigned r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+/** Mix 8 bytes of input into an accumulator.  Used internally. */
+static inline uint64_t
+lv2_atom_hash_round(uint64_t acc, const uint8_t* input)
+{
+	uint64_t k;
+	memcpy(&k, input, sizeof(k));
+	acc += k * LV2_ATOM_HASH_PRIME2;
+	return lv2_atom_hash_rotl(acc, 31) * LV2_ATOM_HASH_PRIME1;
+}
+
+/** Merge an accumulator into a hash.  Used internally. */
+static inline uint64_t
+lv2_atom_hash_merge(uint64_t hash, uint64_t acc)
+{
+	acc   = lv2_atom_hash_rotl(acc * LV2_ATOM_HASH_PRIME2, 31);
+	hash ^= acc * LV2_ATOM_HASH_PRIME1;
+	return hash * LV2_ATOM_HASH_PRIME1 + LV2_ATOM_HASH_PRIME4;
+}
+
+/**
+   Return a 64-bit hash of `size` bytes at `data`.
+
+   This is the XXH64 algorithm, which processes input in 32 byte stripes with
+   4 independent lanes, so it is fast for large atoms.  The result depends on
+   the byte order of the machine, so hashes are stable on a given machine, but
+   not portable between machines.
+*/
+static inline uint64_t
+lv2_atom_hash_bytes(const void* data, uint32_t size, uint64_t seed)
+{
+	const uint8_t*       p   = (const uint8_t*)data;
+	const uint8_t* const end = p + size;
+	uint64_t             h   = 0;
+
+	if (size >= 32) {
+		uint64_t v1 = seed + LV2_ATOM_HASH_PRIME1 + LV2_ATOM_HASH_PRIME2;
+		uint64_t v2 = seed + LV2_ATOM_HASH_PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - LV2_ATOM_HASH_PRIME1;
+		for (; p + 32 <= end; p += 32) {
+			v1 = lv2_atom_hash_round(v1, p);
+			v2 = lv2_atom_hash_round(v2, p + 8);
+			v3 = lv2_atom_hash_round(v3, p + 16);
+			v4 = lv2_atom_hash_round(v4, p + 24);
+		}
+		h = (lv2_atom_hash_rotl(v1, 1) + lv2_atom_hash_rotl(v2, 7) +
+		     lv2_atom_hash_rotl(v3, 12) + lv2_atom_hash_rotl(v4, 18));
+		h = lv2_atom_hash_merge(h, v1);
+		h = lv2_atom_hash_merge(h, v2);
+		h = lv2_atom_hash_merge(h, v3);
+		h = lv2_atom_hash_merge(h, v4);
+	} else {
+		h = seed + LV2_ATOM_HASH_PRIME5;
+	}
+
+	h += size;
+	for (; p + 8 <= end; p += 8) {
+		h ^= lv2_atom_hash_round(0, p);
+		h  = lv2_atom_hash_rotl(h, 27) * LV2_ATOM_HASH_PRIME1;
+		h += LV2_ATOM_HASH_PRIME4;
+	}
+	if (p + 4 <= end) {
+		uint32_t k;
+		memcpy(&k, p, sizeof(k));
+		h ^= (uint64_t)k * LV2_ATOM_HASH_PRIME1;
+		h  = lv2_atom_hash_rotl(h, 23) * LV2_ATOM_HASH_PRIME2;
+		h += LV2_ATOM_HASH_PRIME3;
+		p += 4;
+	}
+	for (; p < end; ++p) {
+		h ^= *p * LV2_ATOM_HASH_PRIME5;
+		h  = lv2_atom_hash_rotl(h, 11) * LV2_ATOM_HASH_PRIME1;
+	}
+
+	h ^= h >> 33;
+	h *= LV2_ATOM_HASH_PRIME2;
+	h ^= h >> 29;
+	h *= LV2_ATOM_HASH_PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+/**
+   Return a 64-bit hash of `atom`.
+
+   The hash covers the type, size, and body of the atom (but not any padding
+   after it), so atoms that are equal according to lv2_atom_equals() have the
+   same hash.  This is useful for caches and deduplication, where comparing a
+   hash is much faster than comparing the atoms themselves.
+
+   @param atom The atom to hash.
+   @param seed Initial hash value, which can be used to combine several hashes.
+*/
+static inline uint64_t
+lv2_atom_hash(const LV2_Atom* atom, uint64_t seed)
+{
+	return lv2_atom_hash_bytes(atom, lv2_atom_total_size(atom), seed);
+}
+
+/**
+   Return a 64-bit hash of `atom` which ignores the order of object properties.
+
+   This is like lv2_atom_hash(), except objects with the same properties in a
+   different order have the same hash.  This applies to `atom` itself, and to
+   any objects which are property values (recursively), if their type is
+   `object_type`.  Other atoms, including any objects in tuples or other
+   containers, are hashed as in lv2_atom_hash().  Note that equal hashes do
+   not imply that lv2_atom_equals() is true, since the atoms may differ in
+   property order.
+
+   @param atom The atom to hash.
+   @param object_type The URID of atom:Object.
+   @param seed Initial hash value, which can be used to combine several hashes.
+*/
+static inline uint64_t
+lv2_atom_hash_canonical(const LV2_Atom* atom,
+                        uint32_t        object_type,
+                        uint64_t        seed)
+{
+	if (atom->type != object_type || atom->size < sizeof(LV2_Atom_Object_Body)) {
+		return lv2_atom_hash(atom, seed);
+	}
+
+	// Combine hashes of properties with addition, which is commutative
+	const LV2_Atom_Object* obj   = (const LV2_Atom_Object*)atom;
+	uint64_t               props = 0;
+	LV2_ATOM_OBJECT_FOREACH(obj, p) {
+		const uint64_t id = ((uint64_t)p->key << 32) | p->context;
+		props += lv2_atom_hash_canonical(
+			&p->value, object_type, lv2_atom_hash_merge(seed, id));
+	}
+
+	const uint32_t head[3] = { atom->type, obj->body.id, obj->body.otype };
+	return lv2_atom_hash_bytes(&props,
+	                           sizeof(props),
+	                           lv2_atom_hash_bytes(head, sizeof(head), seed));
 }
 
 /**
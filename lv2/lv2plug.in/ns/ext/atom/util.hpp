@@ -0,0 +1,374 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file util.hpp Typed views of atom containers in C++.
+
+   The iteration macros in util.h are awkward in C++, since every use needs a
+   cast of the container and of the elements.  This header provides views of
+   the containers which can be used with range-based for loops, and a checked
+   cast from a generic atom to a view of the right type.
+
+   A view is a single pointer to the atom it was made from, so it is trivially
+   copyable and is best passed by value.  Iterating over a view calls the same
+   functions as the macros in util.h, so the generated code is the same.
+
+   For example, in run():
+   @code
+   namespace atom = lv2::atom;
+
+   for (const LV2_Atom_Event& ev : atom::SequenceView(self->control)) {
+       if (auto obj = atom::view<atom::ObjectView>(&self->forge, &ev.body)) {
+           for (const LV2_Atom_Property_Body& prop : *obj) {
+               ...
+           }
+       }
+   }
+   @endcode
+
+   The elements of a vector are accessed as a Span, a minimal equivalent of
+   C++20 std::span, which it converts to when that is available:
+   @code
+   if (auto vec = atom::view<atom::VectorView>(&self->forge, atom)) {
+       if (auto values = vec->as<float>(&self->forge)) {
+           for (float v : *values) {
+               ...
+           }
+       }
+   }
+   @endcode
+
+   This header requires C++17.  It is non-normative, it is provided for
+   convenience.
+*/
+
+#ifndef LV2_ATOM_UTIL_HPP
+#define LV2_ATOM_UTIL_HPP
+
+#if __cplusplus < 201703L
+#    error "lv2/atom/util.hpp requires C++17"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iterator>
+#include <optional>
+
+#if __cplusplus > 201703L && __has_include(<span>)
+#    include <span>
+#endif
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.hpp"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+
+namespace lv2 {
+namespace atom {
+
+/**
+   @defgroup util_hpp Views
+   @ingroup atom
+   @{
+*/
+
+/** A contiguous range of values, like std::span. */
+template<typename T>
+class Span {
+public:
+	typedef T        element_type;
+	typedef T*       iterator;
+	typedef uint32_t size_type;
+
+	constexpr Span() : _data(nullptr), _size(0) {}
+	constexpr Span(T* data, uint32_t size) : _data(data), _size(size) {}
+
+	constexpr T*       data() const { return _data; }
+	constexpr uint32_t size() const { return _size; }
+	constexpr bool     empty() const { return _size == 0; }
+	constexpr T*       begin() const { return _data; }
+	constexpr T*       end() const { return _data + _size; }
+
+	constexpr T& operator[](uint32_t i) const { return _data[i]; }
+
+#if __cplusplus > 201703L && __has_include(<span>)
+	constexpr operator std::span<T>() const { return { _data, _size }; }
+#endif
+
+private:
+	T*       _data;
+	uint32_t _size;
+};
+
+namespace detail {
+
+/** The end of a container, which an Iterator is compared to. */
+struct End {
+	const uint8_t* ptr;
+};
+
+/**
+   An iterator over the elements of a container.
+
+   The end of a container is a sentinel, since an iterator has reached it once
+   it is at or past the end, exactly as with the macros in util.h.
+*/
+template<typename T, T* (*next)(const T*)>
+class Iterator {
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef T                         value_type;
+	typedef ptrdiff_t                 difference_type;
+	typedef const T*                  pointer;
+	typedef const T&                  reference;
+
+	explicit Iterator(const T* ptr) : _ptr(ptr) {}
+
+	const T& operator*() const { return *_ptr; }
+	const T* operator->() const { return _ptr; }
+
+	Iterator& operator++()
+	{
+		_ptr = next(_ptr);
+		return *this;
+	}
+
+	Iterator operator++(int)
+	{
+		Iterator old = *this;
+		_ptr = next(_ptr);
+		return old;
+	}
+
+	bool operator==(const Iterator& rhs) const { return _ptr == rhs._ptr; }
+	bool operator!=(const Iterator& rhs) const { return _ptr != rhs._ptr; }
+
+	bool operator==(End end) const { return (const uint8_t*)_ptr >= end.ptr; }
+	bool operator!=(End end) const { return (const uint8_t*)_ptr < end.ptr; }
+
+private:
+	const T* _ptr;
+};
+
+}  // namespace detail
+
+/** A view of a Sequence, which iterates over its events. */
+class SequenceView {
+public:
+	typedef LV2_Atom_Sequence Atom;
+	typedef detail::Iterator<LV2_Atom_Event, lv2_atom_sequence_next>
+		iterator;
+
+	/** Atom type of the viewed container. */
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Sequence; }
+
+	explicit SequenceView(const LV2_Atom_Sequence* seq) : _seq(seq) {}
+
+	/** The viewed sequence. */
+	const LV2_Atom_Sequence* atom() const { return _seq; }
+
+	/** Time unit of the events, or 0 for frames. */
+	LV2_URID unit() const { return _seq->body.unit; }
+
+	/** Return true if the sequence has no events. */
+	bool empty() const
+	{
+		return _seq->atom.size <= sizeof(LV2_Atom_Sequence_Body);
+	}
+
+	iterator begin() const
+	{
+		return iterator(lv2_atom_sequence_begin(&_seq->body));
+	}
+
+	detail::End end() const
+	{
+		return { (const uint8_t*)&_seq->body + _seq->atom.size };
+	}
+
+private:
+	const LV2_Atom_Sequence* _seq;
+};
+
+/** A view of an Object, which iterates over its properties. */
+class ObjectView {
+public:
+	typedef LV2_Atom_Object Atom;
+	typedef detail::Iterator<LV2_Atom_Property_Body, lv2_atom_object_next>
+		iterator;
+
+	/** Atom type of the viewed container. */
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Object; }
+
+	explicit ObjectView(const LV2_Atom_Object* obj) : _obj(obj) {}
+
+	/** The viewed object. */
+	const LV2_Atom_Object* atom() const { return _obj; }
+
+	/** ID of the object, or 0 for a blank node. */
+	LV2_URID id() const { return _obj->body.id; }
+
+	/** Type of the object (not the atom type, which is always Object). */
+	LV2_URID otype() const { return _obj->body.otype; }
+
+	/** Return the value of the first property with `key`, or null. */
+	const LV2_Atom* get(LV2_URID key) const
+	{
+		for (const LV2_Atom_Property_Body& prop : *this) {
+			if (prop.key == key) {
+				return &prop.value;
+			}
+		}
+		return nullptr;
+	}
+
+	iterator begin() const
+	{
+		return iterator(lv2_atom_object_begin(&_obj->body));
+	}
+
+	detail::End end() const
+	{
+		return { (const uint8_t*)&_obj->body + _obj->atom.size };
+	}
+
+private:
+	const LV2_Atom_Object* _obj;
+};
+
+/** A view of a Tuple, which iterates over its elements. */
+class TupleView {
+public:
+	typedef LV2_Atom_Tuple                                  Atom;
+	typedef detail::Iterator<LV2_Atom, lv2_atom_tuple_next> iterator;
+
+	/** Atom type of the viewed container. */
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Tuple; }
+
+	explicit TupleView(const LV2_Atom_Tuple* tup) : _tup(tup) {}
+
+	/** The viewed tuple. */
+	const LV2_Atom_Tuple* atom() const { return _tup; }
+
+	/** Return true if the tuple has no elements. */
+	bool empty() const { return _tup->atom.size == 0; }
+
+	iterator begin() const { return iterator(lv2_atom_tuple_begin(_tup)); }
+
+	detail::End end() const
+	{
+		return { (const uint8_t*)(_tup + 1) + _tup->atom.size };
+	}
+
+private:
+	const LV2_Atom_Tuple* _tup;
+};
+
+/** A view of a Vector, which gives access to its elements as a Span. */
+class VectorView {
+public:
+	typedef LV2_Atom_Vector Atom;
+
+	/** Atom type of the viewed container. */
+	static LV2_URID type(const LV2_Atom_Forge* forge) { return forge->Vector; }
+
+	explicit VectorView(const LV2_Atom_Vector* vec) : _vec(vec) {}
+
+	/** The viewed vector. */
+	const LV2_Atom_Vector* atom() const { return _vec; }
+
+	/** Atom type of the elements. */
+	LV2_URID child_type() const { return _vec->body.child_type; }
+
+	/** Size of each element in bytes. */
+	uint32_t child_size() const { return _vec->body.child_size; }
+
+	/** Number of elements. */
+	uint32_t size() const
+	{
+		return _vec->body.child_size
+			? (_vec->atom.size - (uint32_t)sizeof(LV2_Atom_Vector_Body)) /
+			  _vec->body.child_size
+			: 0;
+	}
+
+	/**
+	   Return the elements as values of type `T`, if they have that type.
+
+	   `T` is a value type supported by lv2::atom::Object, and elements are
+	   returned as the type they are stored as, which is int32_t for bool.
+
+	   @return The elements, or nothing if they are not of type `T`.
+	*/
+	template<typename T>
+	std::optional<Span<const typename detail::Scalar<T>::Body>>
+	as(const LV2_Atom_Forge* forge) const
+	{
+		typedef typename detail::Scalar<T>::Body Body;
+		if (_vec->body.child_type != detail::Scalar<T>::type(forge) ||
+		    _vec->body.child_size != sizeof(Body)) {
+			return std::nullopt;
+		}
+		return elements<Body>();
+	}
+
+	/**
+	   Return the elements as values of type `T`, without checking their type.
+
+	   This is for when the type is already known, such as in a loop over
+	   many vectors which have been checked once.
+	*/
+	template<typename T>
+	Span<const T> elements() const
+	{
+		return Span<const T>(
+			(const T*)(_vec + 1),
+			(_vec->atom.size - (uint32_t)sizeof(LV2_Atom_Vector_Body)) /
+			(uint32_t)sizeof(T));
+	}
+
+private:
+	const LV2_Atom_Vector* _vec;
+};
+
+/**
+   Return a view of `atom`, if it is the type of container viewed by `View`.
+
+   This is typically used in an if statement, for example
+   `if (auto obj = view<ObjectView>(forge, &ev.body))`.
+
+   @return The view, or nothing if `atom` is null or has a different type.
+*/
+template<typename View>
+std::optional<View>
+view(const LV2_Atom_Forge* forge, const LV2_Atom* atom)
+{
+	if (!atom || atom->type != View::type(forge) ||
+	    atom->size < sizeof(typename View::Atom) - sizeof(LV2_Atom)) {
+		return std::nullopt;
+	}
+	return View((const typename View::Atom*)atom);
+}
+
+/**
+   @}
+*/
+
+}  // namespace atom
+}  // namespace lv2
+
+#endif  /* LV2_ATOM_UTIL_HPP */
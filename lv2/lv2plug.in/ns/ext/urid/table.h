@@ -0,0 +1,658 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file table.h A URID table for hosts, which implements map and unmap.
+
+   Every host needs to provide the urid:map and urid:unmap features, and many
+   plugins map URIs from several threads.  This is a reusable implementation
+   of both, which hosts can use instead of writing their own.
+
+   URIs are interned in the table and indexed by an open addressing hash
+   table.  Looking up a URI that is already mapped never blocks, and neither
+   does unmapping, which is realtime safe.  Only mapping a new URI takes a
+   lock, since inserts must be serialised, and may allocate.  Any number of
+   threads may use the table at once.
+
+   For example, in a host:
+   @code
+   LV2_URID_Table table;
+   lv2_urid_table_init(&table);
+
+   LV2_URID_Map       map   = lv2_urid_table_map_feature(&table);
+   LV2_URID_Map_Batch batch = lv2_urid_table_map_batch_feature(&table);
+   LV2_URID_Unmap     unmap = lv2_urid_table_unmap_feature(&table);
+   LV2_Feature        map_feature   = { LV2_URID__map, &map };
+   LV2_Feature        batch_feature = { LV2_URID__mapBatch, &batch };
+   LV2_Feature        unmap_feature = { LV2_URID__unmap, &unmap };
+   ...
+   lv2_urid_table_free(&table);
+   @endcode
+
+   Hosts can map every URI defined by LV2 when they start with
+   lv2_urid_table_seed() and the table in static.h, which is generated when
+   LV2 is built.
+
+   When the index grows, the old index is kept until the table is freed,
+   since other threads may still be reading it, so the memory used for the
+   index is at most twice what it needs to be.  Strings are never moved, so
+   pointers returned by unmap are valid until the table is freed.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_URID_TABLE_H
+#define LV2_URID_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup table Table
+   @ingroup urid
+   @{
+*/
+
+/** The number of URIDs in each block of entries. */
+#define LV2_URID_TABLE_BLOCK_SIZE 1024U
+
+/** The maximum number of blocks, so a table holds up to about a million. */
+#define LV2_URID_TABLE_MAX_BLOCKS 1024U
+
+/** A URI interned in a table, which is followed by the URI string. */
+typedef struct {
+	uint32_t hash;  /**< Hash of the URI */
+	uint32_t len;   /**< Length of the URI in bytes */
+} LV2_URID_Table_Entry;
+
+/**
+   A URI with a precomputed hash, which a table can be seeded with.
+
+   The hash must be the one calculated by lv2_urid_table_hash().  Arrays of
+   these are generated at build time, see static.h.
+*/
+typedef struct {
+	const char* uri;   /**< URI string */
+	uint32_t    len;   /**< Length of `uri` in bytes */
+	uint32_t    hash;  /**< Hash of `uri` */
+} LV2_URID_Static_URI;
+
+/**
+   An index of entries by hash.
+
+   Each slot is the hash of the entry in the high 32 bits and the URID in the
+   low 32 bits, or zero if the slot is empty.  Slots are only ever set once.
+*/
+typedef struct LV2_URID_Table_Index_Impl {
+	struct LV2_URID_Table_Index_Impl* prev;   /**< Previous, smaller index */
+	volatile uint64_t*                slots;  /**< Slots, after this struct */
+	uint32_t                          mask;   /**< Number of slots minus 1 */
+} LV2_URID_Table_Index;
+
+/** A URID table.  Fields are private. */
+typedef struct {
+	LV2_URID_Table_Index* volatile index;   /**< Current index */
+	LV2_URID_Table_Entry***        blocks;  /**< Blocks of entries by URID */
+	volatile uint32_t              size;    /**< Number of URIDs */
+#ifdef _WIN32
+	SRWLOCK                        lock;    /**< Lock for inserts */
+#else
+	pthread_mutex_t                lock;    /**< Lock for inserts */
+#endif
+} LV2_URID_Table;
+
+/**
+   @name Atomics
+   Used internally.
+   @{
+*/
+
+static inline uint32_t
+lv2_urid_table_load_u32(const volatile uint32_t* ptr)
+{
+#ifdef _MSC_VER
+	return (uint32_t)_InterlockedOr((volatile long*)ptr, 0);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void
+lv2_urid_table_store_u32(volatile uint32_t* ptr, uint32_t value)
+{
+#ifdef _MSC_VER
+	_InterlockedExchange((volatile long*)ptr, (long)value);
+#else
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline uint64_t
+lv2_urid_table_load_u64(const volatile uint64_t* ptr)
+{
+#ifdef _MSC_VER
+	return (uint64_t)_InterlockedOr64((volatile __int64*)ptr, 0);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void
+lv2_urid_table_store_u64(volatile uint64_t* ptr, uint64_t value)
+{
+#ifdef _MSC_VER
+	_InterlockedExchange64((volatile __int64*)ptr, (__int64)value);
+#else
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline void*
+lv2_urid_table_load_ptr(void* const volatile* ptr)
+{
+#ifdef _MSC_VER
+	return _InterlockedCompareExchangePointer((void* volatile*)ptr, NULL, NULL);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void
+lv2_urid_table_store_ptr(void* volatile* ptr, void* value)
+{
+#ifdef _MSC_VER
+	_InterlockedExchangePointer(ptr, value);
+#else
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+   @}
+*/
+
+/**
+   Load `n` bytes, at most 8, as a little-endian word.  Used internally.
+
+   The byte order is fixed so that hashes are the same on every platform,
+   since they are precomputed at build time for static.h.
+*/
+static inline uint64_t
+lv2_urid_table_load_word(const char* str, size_t n)
+{
+	uint64_t word = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	for (size_t i = 0; i < n; ++i) {
+		word |= (uint64_t)(uint8_t)str[i] << (8 * i);
+	}
+#else
+	memcpy(&word, str, n);
+#endif
+	return word;
+}
+
+/** Return the hash of `uri`, and set `len` to its length.  Used internally. */
+static inline uint32_t
+lv2_urid_table_hash(const char* uri, uint32_t* len)
+{
+	/* Hash 8 bytes at a time, since URIs are long and often share a prefix */
+	const size_t n    = strlen(uri);
+	uint64_t     hash = 0x9E3779B97F4A7C15ULL ^ n;
+	size_t       i    = 0;
+	for (; i + 8 <= n; i += 8) {
+		hash = (hash ^ lv2_urid_table_load_word(uri + i, 8)) *
+			0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 32;
+	}
+
+	hash = (hash ^ lv2_urid_table_load_word(uri + i, n - i)) *
+		0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+
+	*len = (uint32_t)n;
+	return (uint32_t)hash;
+}
+
+/** Allocate an empty index with `n_slots` slots.  Used internally. */
+static inline LV2_URID_Table_Index*
+lv2_urid_table_index_new(uint32_t n_slots)
+{
+	LV2_URID_Table_Index* const index = (LV2_URID_Table_Index*)calloc(
+		1, sizeof(LV2_URID_Table_Index) + n_slots * sizeof(uint64_t));
+	if (index) {
+		index->slots = (volatile uint64_t*)(index + 1);
+		index->mask  = n_slots - 1;
+	}
+	return index;
+}
+
+/** Lock `table` for inserting.  Used internally. */
+static inline void
+lv2_urid_table_lock(LV2_URID_Table* table)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&table->lock);
+#else
+	pthread_mutex_lock(&table->lock);
+#endif
+}
+
+/** Unlock `table` after inserting.  Used internally. */
+static inline void
+lv2_urid_table_unlock(LV2_URID_Table* table)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&table->lock);
+#else
+	pthread_mutex_unlock(&table->lock);
+#endif
+}
+
+/** Return the entry for `urid`, which must be mapped.  Used internally. */
+static inline const LV2_URID_Table_Entry*
+lv2_urid_table_entry(const LV2_URID_Table* table, LV2_URID urid)
+{
+	const LV2_URID_Table_Entry* const* const block =
+		(const LV2_URID_Table_Entry* const*)lv2_urid_table_load_ptr(
+			(void* const volatile*)&table->blocks[(urid - 1) /
+			                                      LV2_URID_TABLE_BLOCK_SIZE]);
+	return block[(urid - 1) % LV2_URID_TABLE_BLOCK_SIZE];
+}
+
+/**
+   Initialise an empty table.
+
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+lv2_urid_table_init(LV2_URID_Table* table)
+{
+	table->size   = 0;
+	table->index  = lv2_urid_table_index_new(256);
+	table->blocks = (LV2_URID_Table_Entry***)calloc(
+		LV2_URID_TABLE_MAX_BLOCKS, sizeof(LV2_URID_Table_Entry**));
+	if (!table->index || !table->blocks) {
+		free(table->index);
+		free(table->blocks);
+		return false;
+	}
+
+#ifdef _WIN32
+	InitializeSRWLock(&table->lock);
+#else
+	pthread_mutex_init(&table->lock, NULL);
+#endif
+	return true;
+}
+
+/**
+   Free all memory used by `table`.
+
+   No other thread may be using the table.  All strings returned by
+   lv2_urid_table_unmap() are invalid after this.
+*/
+static inline void
+lv2_urid_table_free(LV2_URID_Table* table)
+{
+	for (uint32_t i = 0; i < table->size; ++i) {
+		free(table->blocks[i / LV2_URID_TABLE_BLOCK_SIZE]
+		     [i % LV2_URID_TABLE_BLOCK_SIZE]);
+	}
+	for (uint32_t i = 0; i < LV2_URID_TABLE_MAX_BLOCKS; ++i) {
+		free(table->blocks[i]);
+	}
+	for (LV2_URID_Table_Index* i = table->index; i;) {
+		LV2_URID_Table_Index* const prev = i->prev;
+		free(i);
+		i = prev;
+	}
+	free(table->blocks);
+
+#ifndef _WIN32
+	pthread_mutex_destroy(&table->lock);
+#endif
+
+	table->index  = NULL;
+	table->blocks = NULL;
+	table->size   = 0;
+}
+
+/** Return the number of URIDs in `table`. */
+static inline uint32_t
+lv2_urid_table_size(const LV2_URID_Table* table)
+{
+	return lv2_urid_table_load_u32(&table->size);
+}
+
+/**
+   Find `uri` in `index`, or return 0 if it is not there.  Used internally.
+
+   This is lock-free, and safe to call while another thread inserts.
+*/
+static inline LV2_URID
+lv2_urid_table_find(const LV2_URID_Table*       table,
+                    const LV2_URID_Table_Index* index,
+                    const char*                 uri,
+                    uint32_t                    hash,
+                    uint32_t                    len)
+{
+	for (uint32_t i = hash & index->mask;; i = (i + 1) & index->mask) {
+		const uint64_t slot = lv2_urid_table_load_u64(&index->slots[i]);
+		if (!slot) {
+			return 0;
+		} else if ((uint32_t)(slot >> 32) == hash) {
+			const LV2_URID                    urid  = (LV2_URID)slot;
+			const LV2_URID_Table_Entry* const entry =
+				lv2_urid_table_entry(table, urid);
+			if (entry->len == len && !memcmp(entry + 1, uri, len)) {
+				return urid;
+			}
+		}
+	}
+}
+
+/** Add `urid` with `hash` to `index`, which has space.  Used internally. */
+static inline void
+lv2_urid_table_index_add(LV2_URID_Table_Index* index,
+                         uint32_t              hash,
+                         LV2_URID              urid)
+{
+	uint32_t i = hash & index->mask;
+	while (index->slots[i]) {
+		i = (i + 1) & index->mask;
+	}
+	lv2_urid_table_store_u64(&index->slots[i],
+	                         ((uint64_t)hash << 32) | (uint64_t)urid);
+}
+
+/**
+   Insert a new entry for `uri`.  Used internally.
+
+   The lock must be held, and `uri` must not be in the table.
+
+   @return The new URID, or 0 if allocation failed or the table is full.
+*/
+static inline LV2_URID
+lv2_urid_table_insert(LV2_URID_Table* table,
+                      const char*     uri,
+                      uint32_t        hash,
+                      uint32_t        len)
+{
+	const uint32_t size  = table->size;
+	const uint32_t block = size / LV2_URID_TABLE_BLOCK_SIZE;
+	if (block == LV2_URID_TABLE_MAX_BLOCKS) {
+		return 0;
+	}
+
+	// Grow the index first, so it is never more than half full
+	LV2_URID_Table_Index* index = table->index;
+	if (size + 1 > (index->mask + 1) / 2) {
+		LV2_URID_Table_Index* const bigger =
+			lv2_urid_table_index_new((index->mask + 1) * 2);
+		if (!bigger) {
+			return 0;
+		}
+		for (uint32_t i = 0; i <= index->mask; ++i) {
+			const uint64_t slot = index->slots[i];
+			if (slot) {
+				lv2_urid_table_index_add(
+					bigger, (uint32_t)(slot >> 32), (LV2_URID)slot);
+			}
+		}
+		bigger->prev = index;
+		lv2_urid_table_store_ptr((void* volatile*)&table->index, bigger);
+		index = bigger;
+	}
+
+	// Allocate a new block of entries if necessary
+	LV2_URID_Table_Entry** entries = table->blocks[block];
+	if (!entries) {
+		entries = (LV2_URID_Table_Entry**)calloc(
+			LV2_URID_TABLE_BLOCK_SIZE, sizeof(LV2_URID_Table_Entry*));
+		if (!entries) {
+			return 0;
+		}
+		lv2_urid_table_store_ptr((void* volatile*)&table->blocks[block],
+		                         entries);
+	}
+
+	// Intern the URI
+	LV2_URID_Table_Entry* const entry = (LV2_URID_Table_Entry*)malloc(
+		sizeof(LV2_URID_Table_Entry) + len + 1);
+	if (!entry) {
+		return 0;
+	}
+	entry->hash = hash;
+	entry->len  = len;
+	memcpy(entry + 1, uri, len + 1);
+
+	// Publish the entry, then the URID, so readers see a complete entry
+	const LV2_URID urid = size + 1;
+	lv2_urid_table_store_ptr(
+		(void* volatile*)&entries[size % LV2_URID_TABLE_BLOCK_SIZE], entry);
+	lv2_urid_table_store_u32(&table->size, urid);
+	lv2_urid_table_index_add(index, hash, urid);
+	return urid;
+}
+
+/**
+   Map `uri` to a URID, adding it to the table if necessary.
+
+   This does not block if `uri` is already mapped, otherwise it takes a lock
+   and allocates, so it is not realtime safe in general.
+
+   @return The URID of `uri`, or 0 if it could not be added.
+*/
+static inline LV2_URID
+lv2_urid_table_map(LV2_URID_Table* table, const char* uri)
+{
+	uint32_t       len  = 0;
+	const uint32_t hash = lv2_urid_table_hash(uri, &len);
+
+	// Look up without locking, which is the common case
+	LV2_URID urid = lv2_urid_table_find(
+		table,
+		(const LV2_URID_Table_Index*)lv2_urid_table_load_ptr(
+			(void* const volatile*)&table->index),
+		uri, hash, len);
+	if (urid) {
+		return urid;
+	}
+
+	// Look up again with the lock held, since another thread may have added it
+	lv2_urid_table_lock(table);
+	urid = lv2_urid_table_find(table, table->index, uri, hash, len);
+	if (!urid) {
+		urid = lv2_urid_table_insert(table, uri, hash, len);
+	}
+	lv2_urid_table_unlock(table);
+
+	return urid;
+}
+
+/**
+   Map `n_uris` URIs to URIDs, adding them to the table if necessary.
+
+   This is equivalent to calling lv2_urid_table_map() for each URI, but each
+   URI is only hashed once, and the lock is taken at most once, when the
+   first URI that is not already mapped is found.
+
+   @return The number of URIs that were mapped to a non-zero URID.
+*/
+static inline uint32_t
+lv2_urid_table_map_batch(LV2_URID_Table*    table,
+                         uint32_t           n_uris,
+                         const char* const* uris,
+                         LV2_URID*          urids)
+{
+	bool     locked   = false;
+	uint32_t n_mapped = 0;
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		uint32_t       len  = 0;
+		const uint32_t hash = lv2_urid_table_hash(uris[i], &len);
+
+		// Look up without locking, unless the lock is already held
+		urids[i] = lv2_urid_table_find(
+			table,
+			(const LV2_URID_Table_Index*)lv2_urid_table_load_ptr(
+				(void* const volatile*)&table->index),
+			uris[i], hash, len);
+
+		if (!urids[i]) {
+			// Take the lock for this and every following URI
+			if (!locked) {
+				lv2_urid_table_lock(table);
+				locked   = true;
+				urids[i] = lv2_urid_table_find(
+					table, table->index, uris[i], hash, len);
+			}
+			if (!urids[i]) {
+				urids[i] = lv2_urid_table_insert(table, uris[i], hash, len);
+			}
+		}
+
+		n_mapped += (urids[i] != 0);
+	}
+
+	if (locked) {
+		lv2_urid_table_unlock(table);
+	}
+
+	return n_mapped;
+}
+
+/**
+   Map every URI in `uris`, which have precomputed hashes.
+
+   This is faster than mapping each URI in turn, since the URIs are not hashed
+   and the lock is only taken once.  Typically, a host calls this when it
+   starts, with the well-known URIs from static.h, so plugins find most of the
+   URIs they need already mapped when they are instantiated.
+
+   If the table is empty, then the URID of each URI is its index in `uris`
+   plus one.  URIs already in the table keep their URIDs.
+
+   @return True on success, or false if allocation failed.
+*/
+static inline bool
+lv2_urid_table_seed(LV2_URID_Table*            table,
+                    const LV2_URID_Static_URI* uris,
+                    uint32_t                   n_uris)
+{
+	bool success = true;
+	lv2_urid_table_lock(table);
+	for (uint32_t i = 0; i < n_uris && success; ++i) {
+		const LV2_URID_Static_URI* const u = &uris[i];
+		if (!lv2_urid_table_find(
+			    table, table->index, u->uri, u->hash, u->len)) {
+			success = lv2_urid_table_insert(
+				table, u->uri, u->hash, u->len) != 0;
+		}
+	}
+	lv2_urid_table_unlock(table);
+	return success;
+}
+
+/**
+   Return the URI of `urid`, or NULL if it is not mapped.
+
+   This never blocks or allocates, so it is realtime safe.  The returned
+   string is valid until the table is freed.
+*/
+static inline const char*
+lv2_urid_table_unmap(const LV2_URID_Table* table, LV2_URID urid)
+{
+	if (urid == 0 || urid > lv2_urid_table_load_u32(&table->size)) {
+		return NULL;
+	}
+	return (const char*)(lv2_urid_table_entry(table, urid) + 1);
+}
+
+/** Map function for an LV2_URID_Map, with a table as the handle. */
+static inline LV2_URID
+lv2_urid_table_map_uri(LV2_URID_Map_Handle handle, const char* uri)
+{
+	return lv2_urid_table_map((LV2_URID_Table*)handle, uri);
+}
+
+/** Map function for an LV2_URID_Map_Batch, with a table as the handle. */
+static inline uint32_t
+lv2_urid_table_map_batch_uris(LV2_URID_Map_Batch_Handle handle,
+                              uint32_t                  n_uris,
+                              const char* const*        uris,
+                              LV2_URID*                 urids)
+{
+	return lv2_urid_table_map_batch(
+		(LV2_URID_Table*)handle, n_uris, uris, urids);
+}
+
+/** Unmap function for an LV2_URID_Unmap, with a table as the handle. */
+static inline const char*
+lv2_urid_table_unmap_urid(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	return lv2_urid_table_unmap((const LV2_URID_Table*)handle, urid);
+}
+
+/** Return a urid:map feature implemented by `table`. */
+static inline LV2_URID_Map
+lv2_urid_table_map_feature(LV2_URID_Table* table)
+{
+	LV2_URID_Map map = { table, lv2_urid_table_map_uri };
+	return map;
+}
+
+/** Return a urid:mapBatch feature implemented by `table`. */
+static inline LV2_URID_Map_Batch
+lv2_urid_table_map_batch_feature(LV2_URID_Table* table)
+{
+	LV2_URID_Map_Batch batch = { table, lv2_urid_table_map_batch_uris };
+	return batch;
+}
+
+/** Return a urid:unmap feature implemented by `table`. */
+static inline LV2_URID_Unmap
+lv2_urid_table_unmap_feature(LV2_URID_Table* table)
+{
+	LV2_URID_Unmap unmap = { table, lv2_urid_table_unmap_urid };
+	return unmap;
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_URID_TABLE_H */
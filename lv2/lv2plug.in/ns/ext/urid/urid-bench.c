@@ -0,0 +1,389 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Benchmark mapping every URI used in the specification.
+
+  Usage: urid-bench [DIR]
+
+  All Turtle files under DIR (by default, lv2/lv2plug.in/ns, so this should
+  be run from the top of the source tree) are scanned for URIs, which are
+  then mapped in the order they appear, so common URIs like rdfs:label are
+  mapped many times, as they are when a host loads many plugins.
+*/
+
+#define _XOPEN_SOURCE 500
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lv2/lv2plug.in/ns/ext/urid/static.h"
+#include "lv2/lv2plug.in/ns/ext/urid/table.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+#include "lv2/lv2plug.in/ns/ext/urid/util.h"
+
+#define MAX_PREFIXES 64
+
+/** Sink for results, so the compiler can not optimise benchmarks away. */
+static volatile uintptr_t bench_sink = 0;
+
+/** URIs found in all files, in order, with repeats. */
+static char**   uris   = NULL;
+static unsigned n_uris = 0;
+
+static double
+bench_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static void
+bench_report(const char* name, unsigned n, double begin, double end)
+{
+	printf("%-44s %10.2f ns\n", name, (end - begin) * 1.0e9 / n);
+}
+
+/** Simple map that a host might write, like the one in atom-test.c. */
+static char**   naive_uris   = NULL;
+static uint32_t n_naive_uris = 0;
+
+static LV2_URID
+naive_map(LV2_URID_Map_Handle handle, const char* uri)
+{
+	for (uint32_t i = 0; i < n_naive_uris; ++i) {
+		if (!strcmp(naive_uris[i], uri)) {
+			return i + 1;
+		}
+	}
+
+	const size_t len = strlen(uri);
+	naive_uris = (char**)realloc(naive_uris, ++n_naive_uris * sizeof(char*));
+	naive_uris[n_naive_uris - 1] = (char*)malloc(len + 1);
+	memcpy(naive_uris[n_naive_uris - 1], uri, len + 1);
+	return n_naive_uris;
+}
+
+static const char*
+naive_unmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	return (urid > 0 && urid <= n_naive_uris) ? naive_uris[urid - 1] : NULL;
+}
+
+static void
+add_uri(const char* prefix, size_t prefix_len, const char* str, size_t len)
+{
+	char* const uri = (char*)malloc(prefix_len + len + 1);
+	memcpy(uri, prefix, prefix_len);
+	memcpy(uri + prefix_len, str, len);
+	uri[prefix_len + len] = '\0';
+
+	uris = (char**)realloc(uris, ++n_uris * sizeof(char*));
+	uris[n_uris - 1] = uri;
+}
+
+static bool
+is_name_char(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		(c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' ||
+		c == ':';
+}
+
+/**
+   Add the URIs in a Turtle document to `uris`.
+
+   This is not a real parser, but finds IRIs and expands prefixed names
+   outside of comments and string literals, which is enough here.
+*/
+static void
+scan_turtle(const char* str)
+{
+	struct {
+		const char* name;
+		size_t      name_len;
+		const char* uri;
+		size_t      uri_len;
+	} prefixes[MAX_PREFIXES];
+	unsigned n_prefixes = 0;
+
+	for (const char* s = str; *s;) {
+		if (*s == '#') {
+			s += strcspn(s, "\n");
+		} else if (!strncmp(s, "\"\"\"", 3)) {
+			const char* const end = strstr(s + 3, "\"\"\"");
+			s = end ? end + 3 : s + strlen(s);
+		} else if (*s == '"') {
+			for (++s; *s && *s != '"'; ++s) {
+				if (*s == '\\' && s[1]) {
+					++s;
+				}
+			}
+			s += !!*s;
+		} else if (!strncmp(s, "@prefix", 7)) {
+			// Record the prefix, which is not itself a URI use
+			const char* const name = s + 7 + strspn(s + 7, " \t");
+			const char* const colon = strchr(name, ':');
+			const char* const uri   = colon ? strchr(colon, '<') : NULL;
+			const char* const end   = uri ? strchr(uri, '>') : NULL;
+			if (!end) {
+				return;
+			}
+			if (n_prefixes < MAX_PREFIXES) {
+				prefixes[n_prefixes].name     = name;
+				prefixes[n_prefixes].name_len = (size_t)(colon - name);
+				prefixes[n_prefixes].uri      = uri + 1;
+				prefixes[n_prefixes].uri_len  = (size_t)(end - uri - 1);
+				++n_prefixes;
+			}
+			s = end + 1;
+		} else if (*s == '<') {
+			const size_t len = strcspn(s + 1, ">");
+			add_uri("", 0, s + 1, len);
+			s += len + 1 + !!s[len + 1];
+		} else if (is_name_char(*s)) {
+			// Expand a prefixed name, skipping any other token
+			size_t len = 0;
+			while (is_name_char(s[len])) {
+				++len;
+			}
+			const size_t      token_len = len;
+			const char* const colon     = (const char*)memchr(s, ':', len);
+			while (len && s[len - 1] == '.') {
+				--len;  // Trailing dot ends a statement
+			}
+			for (unsigned i = 0; colon && i < n_prefixes; ++i) {
+				if (prefixes[i].name_len == (size_t)(colon - s) &&
+				    !strncmp(prefixes[i].name, s, prefixes[i].name_len)) {
+					add_uri(prefixes[i].uri, prefixes[i].uri_len,
+					        colon + 1, len - (size_t)(colon + 1 - s));
+					break;
+				}
+			}
+			s += token_len;
+		} else {
+			++s;
+		}
+	}
+}
+
+static int
+scan_file(const char* path, const struct stat* sb, int type, struct FTW* ftw)
+{
+	const size_t len = strlen(path);
+	if (type != FTW_F || len < 4 || strcmp(path + len - 4, ".ttl")) {
+		return 0;
+	}
+
+	FILE* const fd = fopen(path, "rb");
+	if (!fd) {
+		return 0;
+	}
+
+	fseek(fd, 0, SEEK_END);
+	const long size = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	char* const str = (char*)calloc(1, (size_t)size + 1);
+	if (fread(str, 1, (size_t)size, fd) == (size_t)size) {
+		scan_turtle(str);
+	}
+
+	free(str);
+	fclose(fd);
+	return 0;
+}
+
+/** Benchmark mapping and unmapping every URI with the given features. */
+static void
+bench_map(const char* name, LV2_URID_Map* map, LV2_URID_Unmap* unmap)
+{
+	LV2_URID* const urids = (LV2_URID*)calloc(n_uris, sizeof(LV2_URID));
+	char            label[64];
+
+	snprintf(label, sizeof(label), "%s map (first time)", name);
+	double begin = bench_time();
+	for (unsigned i = 0; i < n_uris; ++i) {
+		urids[i] = map->map(map->handle, uris[i]);
+	}
+	bench_report(label, n_uris, begin, bench_time());
+
+	snprintf(label, sizeof(label), "%s map (already mapped)", name);
+	begin = bench_time();
+	for (unsigned r = 0; r < 10; ++r) {
+		for (unsigned i = 0; i < n_uris; ++i) {
+			bench_sink += map->map(map->handle, uris[i]);
+		}
+	}
+	bench_report(label, 10 * n_uris, begin, bench_time());
+
+	snprintf(label, sizeof(label), "%s unmap", name);
+	begin = bench_time();
+	for (unsigned r = 0; r < 10; ++r) {
+		for (unsigned i = 0; i < n_uris; ++i) {
+			bench_sink += (uintptr_t)unmap->unmap(unmap->handle, urids[i]);
+		}
+	}
+	bench_report(label, 10 * n_uris, begin, bench_time());
+
+	free(urids);
+}
+
+/** Benchmark adding every static URI to an empty table, as hosts do. */
+static void
+bench_static(void)
+{
+	const unsigned n_runs  = 100;
+	double         elapsed = 0.0;
+	LV2_URID_Table table;
+
+	for (unsigned r = 0; r < n_runs; ++r) {
+		lv2_urid_table_init(&table);
+		const double begin = bench_time();
+		for (unsigned i = 0; i < LV2_URID_STATIC_N_URIS; ++i) {
+			const char* const uri = lv2_urid_static_uris[i].uri;
+			bench_sink += lv2_urid_table_map(&table, uri);
+		}
+		elapsed += bench_time() - begin;
+		lv2_urid_table_free(&table);
+	}
+	bench_report("LV2_URID_Table map each", n_runs * LV2_URID_STATIC_N_URIS,
+	             0.0, elapsed);
+
+	elapsed = 0.0;
+	for (unsigned r = 0; r < n_runs; ++r) {
+		lv2_urid_table_init(&table);
+		const double begin = bench_time();
+		bench_sink += lv2_urid_table_seed(
+			&table, lv2_urid_static_uris, LV2_URID_STATIC_N_URIS);
+		elapsed += bench_time() - begin;
+		lv2_urid_table_free(&table);
+	}
+	bench_report("LV2_URID_Table seed", n_runs * LV2_URID_STATIC_N_URIS,
+	             0.0, elapsed);
+}
+
+/** Map `n` URIs like a plugin instance, and return the time taken. */
+static double
+bench_instance(LV2_URID_Map_Batch* batch,
+               LV2_URID_Map*       map,
+               uint32_t            n,
+               const char**        strs,
+               LV2_URID*           urids)
+{
+	const double begin = bench_time();
+	bench_sink += lv2_urid_map_batch(batch, map, n, strs, urids);
+	return bench_time() - begin;
+}
+
+/**
+   Benchmark instantiating plugins which map `n` URIs each.
+
+   The first instance maps URIs that are not yet in the table.  In a large
+   session, every other instance maps URIs that are already there.
+*/
+static void
+bench_instantiate(uint32_t n)
+{
+	const unsigned n_instances = 10000;
+	const char**   strs        = (const char**)calloc(n, sizeof(char*));
+	LV2_URID*      urids       = (LV2_URID*)calloc(n, sizeof(LV2_URID));
+	for (uint32_t i = 0; i < n; ++i) {
+		strs[i] = lv2_urid_static_uris[i].uri;
+	}
+
+	// Alternate between features, so both see the same heap state
+	double first[2] = { 0.0, 0.0 };
+	double later[2] = { 0.0, 0.0 };
+	for (unsigned r = 0; r < n_instances; ++r) {
+		for (unsigned use_batch = 0; use_batch < 2; ++use_batch) {
+			LV2_URID_Table table;
+			lv2_urid_table_init(&table);
+			LV2_URID_Map       map   = lv2_urid_table_map_feature(&table);
+			LV2_URID_Map_Batch batch =
+				lv2_urid_table_map_batch_feature(&table);
+
+			LV2_URID_Map_Batch* const b = use_batch ? &batch : NULL;
+
+			first[use_batch] += bench_instance(b, &map, n, strs, urids);
+			later[use_batch] += bench_instance(b, &map, n, strs, urids);
+			lv2_urid_table_free(&table);
+		}
+	}
+
+	for (unsigned use_batch = 0; use_batch < 2; ++use_batch) {
+		char              label[64];
+		const char* const feature = use_batch ? "urid:mapBatch" : "urid:map";
+		snprintf(label, sizeof(label), "%s, %u new URIs", feature, n);
+		bench_report(label, n_instances, 0.0, first[use_batch]);
+		snprintf(label, sizeof(label), "%s, %u mapped URIs", feature, n);
+		bench_report(label, n_instances, 0.0, later[use_batch]);
+	}
+
+	free(urids);
+	free(strs);
+}
+
+int
+main(int argc, char** argv)
+{
+	const char* const dir = argc > 1 ? argv[1] : "lv2/lv2plug.in/ns";
+	if (nftw(dir, scan_file, 16, FTW_PHYS) || !n_uris) {
+		fprintf(stderr, "No URIs found in %s\n", dir);
+		return 1;
+	}
+
+	LV2_URID_Map   naive_map_feature   = { NULL, naive_map };
+	LV2_URID_Unmap naive_unmap_feature = { NULL, naive_unmap };
+
+	LV2_URID_Table table;
+	lv2_urid_table_init(&table);
+	LV2_URID_Map   table_map   = lv2_urid_table_map_feature(&table);
+	LV2_URID_Unmap table_unmap = lv2_urid_table_unmap_feature(&table);
+
+	for (unsigned i = 0; i < n_uris; ++i) {
+		bench_sink += lv2_urid_table_map(&table, uris[i]);
+	}
+	const unsigned n_unique = lv2_urid_table_size(&table);
+	lv2_urid_table_free(&table);
+	lv2_urid_table_init(&table);
+
+	printf("Mapping %u URIs (%u unique) in %s:\n", n_uris, n_unique, dir);
+	bench_map("Linear search", &naive_map_feature, &naive_unmap_feature);
+	bench_map("LV2_URID_Table", &table_map, &table_unmap);
+
+	printf("\nMapping %u static URIs:\n", LV2_URID_STATIC_N_URIS);
+	bench_static();
+
+	printf("\nMapping URIs per plugin instance:\n");
+	bench_instantiate(12);
+	bench_instantiate(200);
+
+	lv2_urid_table_free(&table);
+	for (uint32_t i = 0; i < n_naive_uris; ++i) {
+		free(naive_uris[i]);
+	}
+	free(naive_uris);
+	for (unsigned i = 0; i < n_uris; ++i) {
+		free(uris[i]);
+	}
+	free(uris);
+	return 0;
+}
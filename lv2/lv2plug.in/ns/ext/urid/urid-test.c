@@ -0,0 +1,278 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/midi/midi.h"
+#include "lv2/lv2plug.in/ns/ext/urid/static.h"
+#include "lv2/lv2plug.in/ns/ext/urid/table.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+#include "lv2/lv2plug.in/ns/ext/urid/util.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+/** Number of URIs mapped by each thread in the concurrent test. */
+#define N_THREAD_URIS 3000
+
+/** Number of threads in the concurrent test. */
+#define N_THREADS 4
+
+static int
+test_fail(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return 1;
+}
+
+static void
+make_uri(char* buf, size_t size, unsigned i)
+{
+	snprintf(buf, size, "http://example.org/ns#thing%u", i);
+}
+
+static int
+test_map(void)
+{
+	LV2_URID_Table table;
+	if (!lv2_urid_table_init(&table)) {
+		return test_fail("Failed to initialise table\n");
+	}
+
+	LV2_URID_Map   map   = lv2_urid_table_map_feature(&table);
+	LV2_URID_Unmap unmap = lv2_urid_table_unmap_feature(&table);
+
+	// Map some URIs through the features, including the empty string
+	const LV2_URID a     = map.map(map.handle, "http://example.org/a");
+	const LV2_URID b     = map.map(map.handle, "http://example.org/b");
+	const LV2_URID empty = map.map(map.handle, "");
+	if (a != 1 || b != 2 || empty != 3 || lv2_urid_table_size(&table) != 3) {
+		return test_fail("Unexpected URIDs %u %u %u\n", a, b, empty);
+	}
+	if (map.map(map.handle, "http://example.org/a") != a ||
+	    map.map(map.handle, "") != empty) {
+		return test_fail("Mapped URI again to a different URID\n");
+	}
+	if (strcmp(unmap.unmap(unmap.handle, b), "http://example.org/b") ||
+	    strcmp(unmap.unmap(unmap.handle, empty), "")) {
+		return test_fail("Unmapped URID to the wrong URI\n");
+	}
+	if (unmap.unmap(unmap.handle, 0) || unmap.unmap(unmap.handle, 4)) {
+		return test_fail("Unmapped URID that was never mapped\n");
+	}
+
+	// Map enough URIs to grow the index and fill several blocks
+	char           uri[64];
+	const unsigned n = 3 * LV2_URID_TABLE_BLOCK_SIZE;
+	for (unsigned i = 0; i < n; ++i) {
+		make_uri(uri, sizeof(uri), i);
+		if (lv2_urid_table_map(&table, uri) != 4 + i) {
+			return test_fail("Failed to map %s\n", uri);
+		}
+	}
+	for (unsigned i = 0; i < n; ++i) {
+		make_uri(uri, sizeof(uri), i);
+		if (lv2_urid_table_map(&table, uri) != 4 + i ||
+		    strcmp(lv2_urid_table_unmap(&table, 4 + i), uri)) {
+			return test_fail("Incorrect URID for %s after growing\n", uri);
+		}
+	}
+	if (lv2_urid_table_size(&table) != 3 + n ||
+	    strcmp(lv2_urid_table_unmap(&table, a), "http://example.org/a")) {
+		return test_fail("Lost URIs while growing\n");
+	}
+
+	lv2_urid_table_free(&table);
+	return 0;
+}
+
+static int
+test_static(void)
+{
+	// Check that the hashes calculated at build time are correct
+	for (uint32_t i = 0; i < LV2_URID_STATIC_N_URIS; ++i) {
+		const LV2_URID_Static_URI* const u   = &lv2_urid_static_uris[i];
+		uint32_t                         len = 0;
+		if (lv2_urid_table_hash(u->uri, &len) != u->hash || len != u->len) {
+			return test_fail("Incorrect static hash for %s\n", u->uri);
+		}
+	}
+
+	// Seed an empty table, so URIDs are static IDs
+	LV2_URID_Table table;
+	lv2_urid_table_init(&table);
+	if (!lv2_urid_table_seed(&table, lv2_urid_static_uris,
+	                         LV2_URID_STATIC_N_URIS) ||
+	    lv2_urid_table_size(&table) != LV2_URID_STATIC_N_URIS) {
+		return test_fail("Failed to seed table\n");
+	}
+	if (lv2_urid_table_map(&table, LV2_ATOM__Sequence) !=
+	    LV2_URID_STATIC_ATOM__Sequence ||
+	    lv2_urid_table_map(&table, LV2_CORE__Plugin) !=
+	    LV2_URID_STATIC_CORE__Plugin ||
+	    lv2_urid_table_map(&table, LV2_URID__map) !=
+	    LV2_URID_STATIC_URID__map ||
+	    strcmp(lv2_urid_table_unmap(&table, LV2_URID_STATIC_MIDI__MidiEvent),
+	           LV2_MIDI__MidiEvent)) {
+		return test_fail("Seeded URIDs are not static IDs\n");
+	}
+
+	// Seed again, which must not change any URIDs
+	const LV2_URID a = lv2_urid_table_map(&table, "http://example.org/a");
+	if (!lv2_urid_table_seed(&table, lv2_urid_static_uris,
+	                         LV2_URID_STATIC_N_URIS) ||
+	    lv2_urid_table_size(&table) != LV2_URID_STATIC_N_URIS + 1 ||
+	    lv2_urid_table_map(&table, "http://example.org/a") != a ||
+	    lv2_urid_table_map(&table, LV2_ATOM__Sequence) !=
+	    LV2_URID_STATIC_ATOM__Sequence) {
+		return test_fail("Seeding a table again changed URIDs\n");
+	}
+
+	lv2_urid_table_free(&table);
+	return 0;
+}
+
+static int
+test_batch(void)
+{
+	LV2_URID_Table table;
+	lv2_urid_table_init(&table);
+
+	LV2_URID_Map       map   = lv2_urid_table_map_feature(&table);
+	LV2_URID_Map_Batch batch = lv2_urid_table_map_batch_feature(&table);
+
+	// Map a batch where some URIs are already mapped, and one is repeated
+	const LV2_URID seq = map.map(map.handle, LV2_ATOM__Sequence);
+	const char* const uris[] = { LV2_ATOM__Float, LV2_ATOM__Sequence,
+	                             LV2_MIDI__MidiEvent, LV2_ATOM__Float };
+	LV2_URID urids[4] = { 0, 0, 0, 0 };
+	if (lv2_urid_map_batch(&batch, &map, 4, uris, urids) != 4 ||
+	    urids[1] != seq || urids[0] != urids[3] ||
+	    urids[0] == urids[2] || lv2_urid_table_size(&table) != 3) {
+		return test_fail("Incorrect URIDs from batch map\n");
+	}
+	for (unsigned i = 0; i < 4; ++i) {
+		if (map.map(map.handle, uris[i]) != urids[i]) {
+			return test_fail("Batch and single map differ for %s\n", uris[i]);
+		}
+	}
+
+	// Map the same batch with the fallback, which must give the same URIDs
+	LV2_URID fallback_urids[4] = { 0, 0, 0, 0 };
+	if (lv2_urid_map_batch(NULL, &map, 4, uris, fallback_urids) != 4 ||
+	    memcmp(urids, fallback_urids, sizeof(urids))) {
+		return test_fail("Fallback map differs from batch map\n");
+	}
+
+	// Map an empty batch
+	if (lv2_urid_map_batch(&batch, &map, 0, NULL, NULL) != 0) {
+		return test_fail("Mapped URIs in an empty batch\n");
+	}
+
+	lv2_urid_table_free(&table);
+	return 0;
+}
+
+typedef struct {
+	LV2_URID_Table* table;
+	unsigned        offset;
+	LV2_URID        urids[N_THREAD_URIS];
+	bool            error;
+} ThreadTest;
+
+static void*
+map_thread(void* data)
+{
+	ThreadTest* const test = (ThreadTest*)data;
+	char              uri[64];
+
+	// Map every URI, starting at a different one in each thread
+	for (unsigned i = 0; i < N_THREAD_URIS; ++i) {
+		const unsigned j = (i + test->offset) % N_THREAD_URIS;
+		make_uri(uri, sizeof(uri), j);
+		test->urids[j] = lv2_urid_table_map(test->table, uri);
+
+		// Unmap a URID that was mapped by this thread, or any other
+		const LV2_URID    other = (LV2_URID)(i % (j + 1)) + 1;
+		const char* const str   = lv2_urid_table_unmap(test->table, other);
+		if (other <= lv2_urid_table_size(test->table) &&
+		    (!str || strncmp(str, "http://example.org/ns#thing", 27))) {
+			test->error = true;
+		}
+	}
+
+	return NULL;
+}
+
+static int
+test_threads(void)
+{
+	LV2_URID_Table table;
+	lv2_urid_table_init(&table);
+
+	pthread_t  threads[N_THREADS];
+	ThreadTest tests[N_THREADS];
+	for (unsigned t = 0; t < N_THREADS; ++t) {
+		tests[t].table  = &table;
+		tests[t].offset = t * N_THREAD_URIS / N_THREADS;
+		tests[t].error  = false;
+		pthread_create(&threads[t], NULL, map_thread, &tests[t]);
+	}
+	for (unsigned t = 0; t < N_THREADS; ++t) {
+		pthread_join(threads[t], NULL);
+	}
+
+	// Every thread must have got the same URID for each URI
+	char uri[64];
+	if (lv2_urid_table_size(&table) != N_THREAD_URIS) {
+		return test_fail("Table has %u URIDs, not %u\n",
+		                 lv2_urid_table_size(&table), N_THREAD_URIS);
+	}
+	for (unsigned i = 0; i < N_THREAD_URIS; ++i) {
+		make_uri(uri, sizeof(uri), i);
+		const LV2_URID urid = tests[0].urids[i];
+		for (unsigned t = 0; t < N_THREADS; ++t) {
+			if (tests[t].error || !tests[t].urids[i] ||
+			    tests[t].urids[i] != urid) {
+				return test_fail("Thread %u mapped %s to %u, not %u\n",
+				                 t, uri, tests[t].urids[i], urid);
+			}
+		}
+		if (strcmp(lv2_urid_table_unmap(&table, urid), uri)) {
+			return test_fail("URID %u unmapped to the wrong URI\n", urid);
+		}
+	}
+
+	lv2_urid_table_free(&table);
+	return 0;
+}
+
+int
+main(void)
+{
+	if (test_map() || test_static() || test_batch() || test_threads()) {
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
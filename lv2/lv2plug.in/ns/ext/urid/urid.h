@@ -26,8 +26,9 @@
 #define LV2_URID_URI     "http://lv2plug.in/ns/ext/urid"
 #define LV2_URID_PREFIX  LV2_URID_URI "#"
 
-#define LV2_URID__map   LV2_URID_PREFIX "map"
-#define LV2_URID__unmap LV2_URID_PREFIX "unmap"
+#define LV2_URID__map      LV2_URID_PREFIX "map"
+#define LV2_URID__mapBatch LV2_URID_PREFIX "mapBatch"
+#define LV2_URID__unmap    LV2_URID_PREFIX "unmap"
 
 /* Legacy defines */
 #define LV2_URID_MAP_URI   LV2_URID__map
@@ -44,6 +45,11 @@ extern "C" {
 */
 typedef void* LV2_URID_Map_Handle;
 
+/**
+   Opaque pointer to host data for LV2_URID_Map_Batch.
+*/
+typedef void* LV2_URID_Map_Batch_Handle;
+
 /**
    Opaque pointer to host data for LV2_URID_Unmap.
 */
@@ -91,6 +97,42 @@ typedef struct _LV2_URID_Map {
 	                const char*         uri);
 } LV2_URID_Map;
 
+/**
+   URID Batch Map Feature (LV2_URID__mapBatch)
+*/
+typedef struct _LV2_URID_Map_Batch {
+	/**
+	   Opaque pointer to host data.
+
+	   This MUST be passed to map_batch() whenever it is called.
+	   Otherwise, it must not be interpreted in any way.
+	*/
+	LV2_URID_Map_Batch_Handle handle;
+
+	/**
+	   Get the numeric IDs of several URIs.
+
+	   This is equivalent to calling LV2_URID_Map::map() for each URI in
+	   order, and the IDs are the same as those returned by the urid:map
+	   feature passed to the same plugin.  It is intended for plugins which
+	   map many URIs at once, typically in instantiate(), which hosts can
+	   implement more efficiently than many calls to map().
+
+	   Like map(), this function is not necessarily very fast or RT-safe.
+
+	   @param handle Must be the handle member of this struct.
+	   @param n_uris The number of URIs in `uris`.
+	   @param uris The URIs to be mapped to integer IDs.
+	   @param urids Array of `n_uris` IDs, which is set to the ID of each URI,
+	   or 0 if an ID for that URI could not be created.
+	   @return The number of URIs that were mapped to a non-zero ID.
+	*/
+	uint32_t (*map_batch)(LV2_URID_Map_Batch_Handle handle,
+	                      uint32_t                  n_uris,
+	                      const char* const*        uris,
+	                      LV2_URID*                 urids);
+} LV2_URID_Map_Batch;
+
 /**
    URI Unmap Feature (LV2_URID__unmap)
 */
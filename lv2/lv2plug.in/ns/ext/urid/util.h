@@ -0,0 +1,96 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file util.h Helper functions for the LV2 URID extension.
+
+   Plugins can use urid:mapBatch to map all of their URIs with one call, but
+   it is an optional feature, so must fall back to urid:map when the host
+   does not support it.  lv2_urid_map_batch() does either, so the plugin does
+   not need two versions of the code that maps its URIs.  For example, in
+   instantiate():
+
+   @code
+   LV2_URID_Map*       map   = NULL;  // Required feature
+   LV2_URID_Map_Batch* batch = NULL;  // Optional feature, may be NULL
+   ...
+   static const char* const uris[] = { LV2_ATOM__Float, LV2_ATOM__Sequence };
+   LV2_URID                 urids[2];
+   if (lv2_urid_map_batch(batch, map, 2, uris, urids) != 2) {
+       return NULL;
+   }
+   @endcode
+
+   Note these functions are all static inline, do not take their address.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_URID_UTIL_H
+#define LV2_URID_UTIL_H
+
+#include <stdint.h>
+
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   @defgroup util Utilities
+   @ingroup urid
+   @{
+*/
+
+/**
+   Map `n_uris` URIs to URIDs, in one call if the host supports it.
+
+   @param batch The urid:mapBatch feature, or NULL if it is unsupported.
+   @param map The urid:map feature, which is used if `batch` is NULL.
+   @param n_uris The number of URIs in `uris`.
+   @param uris The URIs to map.
+   @param urids Array of `n_uris` URIDs, which is set to the URID of each URI.
+   @return The number of URIs that were mapped to a non-zero URID.
+*/
+static inline uint32_t
+lv2_urid_map_batch(const LV2_URID_Map_Batch* batch,
+                   const LV2_URID_Map*       map,
+                   uint32_t                  n_uris,
+                   const char* const*        uris,
+                   LV2_URID*                 urids)
+{
+	if (batch) {
+		return batch->map_batch(batch->handle, n_uris, uris, urids);
+	}
+
+	uint32_t n_mapped = 0;
+	for (uint32_t i = 0; i < n_uris; ++i) {
+		urids[i] = map->map(map->handle, uris[i]);
+		n_mapped += (urids[i] != 0);
+	}
+	return n_mapped;
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_URID_UTIL_H */
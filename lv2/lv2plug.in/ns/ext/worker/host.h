@@ -0,0 +1,542 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/**
+   @file host.h A worker for hosts, which implements work:schedule.
+
+   Every host that supports the worker extension needs a thread to call
+   work() in, and queues to pass requests and responses between it and the
+   audio thread.  This is a reusable implementation, which hosts can use
+   instead of writing their own.
+
+   Requests and responses are passed through wait-free rings (see
+   atom/ring.h), which are allocated when the worker is initialised, so
+   nothing in the audio thread blocks or allocates.  Messages are read in
+   place, so work() and work_response() are passed a pointer into the ring
+   rather than a copy.  The worker thread sleeps on a semaphore, which the
+   audio thread posts when it schedules work.
+
+   For example, in a host:
+   @code
+   LV2_Worker_Host worker;
+   lv2_worker_host_init(&worker, 4096);
+
+   LV2_Worker_Schedule schedule = lv2_worker_host_schedule_feature(&worker);
+   LV2_Feature         feature  = { LV2_WORKER__schedule, &schedule };
+   ... instantiate the plugin with feature ...
+
+   const LV2_Worker_Interface* iface = (const LV2_Worker_Interface*)
+       descriptor->extension_data(LV2_WORKER__interface);
+   lv2_worker_host_start(&worker, instance, iface);
+
+   // In the audio thread, for every cycle
+   lv2_worker_host_set_freewheel(&worker, freewheeling);
+   descriptor->run(instance, n_samples);
+   lv2_worker_host_end_run(&worker);
+
+   ... deactivate the plugin ...
+   lv2_worker_host_stop(&worker);
+   lv2_worker_host_end_run(&worker);  // Deliver any late responses
+   ... clean up the plugin ...
+   lv2_worker_host_free(&worker);
+   @endcode
+
+   When freewheeling, work is done immediately in schedule_work(), as
+   described in worker.h, and responses are delivered by the following
+   lv2_worker_host_end_run().  Requests that were scheduled before
+   freewheeling started are still done by the worker thread, so their
+   responses may be delivered after those of later requests.  Calls to work()
+   are serialised by a lock, so work() is never called concurrently for the
+   same instance, and schedule_work() may block while freewheeling until the
+   worker thread has finished its current request.
+
+   This header is non-normative, it is provided for convenience.
+*/
+
+#ifndef LV2_WORKER_HOST_H
+#define LV2_WORKER_HOST_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/forge.h"
+#include "lv2/lv2plug.in/ns/ext/atom/ring.h"
+#include "lv2/lv2plug.in/ns/ext/worker/worker.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+#if defined(_WIN32)
+#    include <limits.h>
+#    include <windows.h>
+#elif defined(__APPLE__)
+#    include <mach/mach.h>
+#    include <pthread.h>
+#else
+#    include <errno.h>
+#    include <pthread.h>
+#    include <semaphore.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#    include <stdbool.h>
+#endif
+
+/**
+   @defgroup host Host
+   @ingroup worker
+   @{
+*/
+
+/** A queue of messages, which is a ring and a forge that writes to it. */
+typedef struct {
+	LV2_Atom_Ring  ring;   /**< Ring of messages */
+	LV2_Atom_Forge forge;  /**< Forge for writing to ring */
+} LV2_Worker_Host_Queue;
+
+/**
+   A worker for a plugin instance.  Fields are private.
+
+   Requests are written by the audio thread and read by the worker thread,
+   and responses the other way around.  Responses to work that is done
+   immediately when freewheeling are written and read by the audio thread, so
+   they have a separate queue, and every queue has a single writer.
+*/
+typedef struct {
+	LV2_Worker_Host_Queue       requests;        /**< Audio to worker */
+	LV2_Worker_Host_Queue       responses;       /**< Worker to audio */
+	LV2_Worker_Host_Queue       sync_responses;  /**< Audio to audio */
+	const LV2_Worker_Interface* iface;           /**< Plugin interface */
+	LV2_Handle                  instance;        /**< Plugin instance */
+	volatile uint32_t           exiting;         /**< Thread should exit */
+	bool                        freewheel;       /**< Work immediately */
+	bool                        running;         /**< Thread is running */
+#if defined(_WIN32)
+	HANDLE                      sem;             /**< Posted on request */
+	HANDLE                      thread;          /**< Worker thread */
+	CRITICAL_SECTION            lock;            /**< Held during work() */
+#elif defined(__APPLE__)
+	semaphore_t                 sem;             /**< Posted on request */
+	pthread_t                   thread;          /**< Worker thread */
+	pthread_mutex_t             lock;            /**< Held during work() */
+#else
+	sem_t                       sem;             /**< Posted on request */
+	pthread_t                   thread;          /**< Worker thread */
+	pthread_mutex_t             lock;            /**< Held during work() */
+#endif
+} LV2_Worker_Host;
+
+/**
+   @name Semaphore
+   Used internally.
+   @{
+*/
+
+static inline bool
+lv2_worker_host_sem_init(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	return (host->sem = CreateSemaphore(NULL, 0, LONG_MAX, NULL)) != NULL;
+#elif defined(__APPLE__)
+	return !semaphore_create(mach_task_self(), &host->sem, SYNC_POLICY_FIFO, 0);
+#else
+	return !sem_init(&host->sem, 0, 0);
+#endif
+}
+
+static inline void
+lv2_worker_host_sem_destroy(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	CloseHandle(host->sem);
+#elif defined(__APPLE__)
+	semaphore_destroy(mach_task_self(), host->sem);
+#else
+	sem_destroy(&host->sem);
+#endif
+}
+
+static inline void
+lv2_worker_host_sem_post(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	ReleaseSemaphore(host->sem, 1, NULL);
+#elif defined(__APPLE__)
+	semaphore_signal(host->sem);
+#else
+	sem_post(&host->sem);
+#endif
+}
+
+static inline void
+lv2_worker_host_sem_wait(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	WaitForSingleObject(host->sem, INFINITE);
+#elif defined(__APPLE__)
+	while (semaphore_wait(host->sem) == KERN_ABORTED) {}
+#else
+	while (sem_wait(&host->sem) && errno == EINTR) {}
+#endif
+}
+
+/**
+   @}
+   @name Work Lock
+   Used internally.
+   @{
+*/
+
+static inline bool
+lv2_worker_host_lock_init(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	InitializeCriticalSection(&host->lock);
+	return true;
+#else
+	return !pthread_mutex_init(&host->lock, NULL);
+#endif
+}
+
+static inline void
+lv2_worker_host_lock_destroy(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	DeleteCriticalSection(&host->lock);
+#else
+	pthread_mutex_destroy(&host->lock);
+#endif
+}
+
+static inline void
+lv2_worker_host_lock(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	EnterCriticalSection(&host->lock);
+#else
+	pthread_mutex_lock(&host->lock);
+#endif
+}
+
+static inline void
+lv2_worker_host_unlock(LV2_Worker_Host* host)
+{
+#if defined(_WIN32)
+	LeaveCriticalSection(&host->lock);
+#else
+	pthread_mutex_unlock(&host->lock);
+#endif
+}
+
+/**
+   @}
+   @name Queues
+   Used internally.
+   @{
+*/
+
+static inline bool
+lv2_worker_host_queue_init(LV2_Worker_Host_Queue* queue, uint32_t size)
+{
+	memset(&queue->forge, 0, sizeof(LV2_Atom_Forge));
+
+	void* const buf = malloc(size);
+	if (!buf || !lv2_atom_ring_init(&queue->ring, buf, size)) {
+		free(buf);
+		return false;
+	}
+	return true;
+}
+
+/**
+   Write a message to `queue`, as an atom with type 0 and the message as the
+   body.  This is realtime safe.
+*/
+static inline LV2_Worker_Status
+lv2_worker_host_queue_write(LV2_Worker_Host_Queue* queue,
+                            uint32_t               size,
+                            const void*            data)
+{
+	const LV2_Atom head = { size, 0 };
+	lv2_atom_ring_begin(&queue->ring, &queue->forge);
+	lv2_atom_forge_raw(&queue->forge, &head, sizeof(head));
+	if (size) {
+		lv2_atom_forge_write(&queue->forge, data, size);
+	}
+	return lv2_atom_ring_commit(&queue->ring) ? LV2_WORKER_SUCCESS
+	                                          : LV2_WORKER_ERR_NO_SPACE;
+}
+
+/** Respond function, the handle is the queue to write responses to. */
+static inline LV2_Worker_Status
+lv2_worker_host_respond(LV2_Worker_Respond_Handle handle,
+                        uint32_t                  size,
+                        const void*               data)
+{
+	return lv2_worker_host_queue_write(
+		(LV2_Worker_Host_Queue*)handle, size, data);
+}
+
+/** Pass every response in `queue` to the plugin's work_response(). */
+static inline void
+lv2_worker_host_queue_emit(LV2_Worker_Host* host, LV2_Worker_Host_Queue* queue)
+{
+	for (const LV2_Atom* msg; (msg = lv2_atom_ring_peek(&queue->ring));) {
+		host->iface->work_response(
+			host->instance, msg->size, msg->size ? msg + 1 : NULL);
+		lv2_atom_ring_pop(&queue->ring);
+	}
+}
+
+/**
+   @}
+*/
+
+/** The worker thread, which does requests until it is told to exit. */
+static inline void
+lv2_worker_host_run(LV2_Worker_Host* host)
+{
+	bool done = false;
+	while (!done) {
+		lv2_worker_host_sem_wait(host);
+		done = lv2_atom_ring_load(&host->exiting);
+
+		// Do every request, including any made before an exit
+		const LV2_Atom* msg = NULL;
+		while ((msg = lv2_atom_ring_peek(&host->requests.ring))) {
+			lv2_worker_host_lock(host);
+			host->iface->work(host->instance,
+			                  lv2_worker_host_respond,
+			                  &host->responses,
+			                  msg->size,
+			                  msg->size ? msg + 1 : NULL);
+			lv2_worker_host_unlock(host);
+			lv2_atom_ring_pop(&host->requests.ring);
+		}
+	}
+}
+
+#if defined(_WIN32)
+static inline DWORD WINAPI
+lv2_worker_host_thread(LPVOID data)
+{
+	lv2_worker_host_run((LV2_Worker_Host*)data);
+	return 0;
+}
+#else
+static inline void*
+lv2_worker_host_thread(void* data)
+{
+	lv2_worker_host_run((LV2_Worker_Host*)data);
+	return NULL;
+}
+#endif
+
+/**
+   Initialise `host`.
+
+   This allocates the queues, so must be called before the plugin is
+   instantiated, since the schedule feature is passed to instantiate().
+
+   @param host The worker to initialise.
+   @param size Size of each queue in bytes, which must be a power of two at
+   least 16.  A message takes 8 bytes plus its size padded to 64 bits.
+   @return True on success, or false if `size` is invalid or allocation
+   failed.
+*/
+static inline bool
+lv2_worker_host_init(LV2_Worker_Host* host, uint32_t size)
+{
+	memset(host, 0, sizeof(LV2_Worker_Host));
+	if (lv2_worker_host_queue_init(&host->requests, size) &&
+	    lv2_worker_host_queue_init(&host->responses, size) &&
+	    lv2_worker_host_queue_init(&host->sync_responses, size) &&
+	    lv2_worker_host_sem_init(host)) {
+		if (lv2_worker_host_lock_init(host)) {
+			return true;
+		}
+		lv2_worker_host_sem_destroy(host);
+	}
+
+	free(host->requests.ring.buf);
+	free(host->responses.ring.buf);
+	free(host->sync_responses.ring.buf);
+	memset(host, 0, sizeof(LV2_Worker_Host));
+	return false;
+}
+
+/**
+   Start the worker thread for a plugin instance.
+
+   @param host The worker.
+   @param instance The plugin instance, which was instantiated with the
+   feature from lv2_worker_host_schedule_feature().
+   @param iface The worker interface from the plugin's extension_data().
+   @return True on success, or false if `iface` is incomplete or the thread
+   could not be started.
+*/
+static inline bool
+lv2_worker_host_start(LV2_Worker_Host*            host,
+                      LV2_Handle                  instance,
+                      const LV2_Worker_Interface* iface)
+{
+	if (host->running || !iface || !iface->work || !iface->work_response) {
+		return false;
+	}
+
+	host->instance = instance;
+	host->iface    = iface;
+	host->exiting  = 0;
+#if defined(_WIN32)
+	host->thread = CreateThread(
+		NULL, 0, lv2_worker_host_thread, host, 0, NULL);
+	host->running = host->thread != NULL;
+#else
+	host->running = !pthread_create(
+		&host->thread, NULL, lv2_worker_host_thread, host);
+#endif
+	return host->running;
+}
+
+/**
+   Stop the worker thread.
+
+   This waits for the thread to do every request that was already scheduled,
+   so blocks, and must not be called from the audio thread.  Responses to
+   these requests are not delivered until lv2_worker_host_end_run() is called
+   again.
+*/
+static inline void
+lv2_worker_host_stop(LV2_Worker_Host* host)
+{
+	if (host->running) {
+		lv2_atom_ring_store(&host->exiting, 1);
+		lv2_worker_host_sem_post(host);
+#if defined(_WIN32)
+		WaitForSingleObject(host->thread, INFINITE);
+		CloseHandle(host->thread);
+#else
+		pthread_join(host->thread, NULL);
+#endif
+		host->running = false;
+	}
+}
+
+/** Stop the worker thread if necessary, and free everything `host` uses. */
+static inline void
+lv2_worker_host_free(LV2_Worker_Host* host)
+{
+	lv2_worker_host_stop(host);
+	lv2_worker_host_lock_destroy(host);
+	lv2_worker_host_sem_destroy(host);
+	free(host->requests.ring.buf);
+	free(host->responses.ring.buf);
+	free(host->sync_responses.ring.buf);
+	memset(host, 0, sizeof(LV2_Worker_Host));
+}
+
+/**
+   Set whether the host is freewheeling, so work is done immediately.
+
+   This must only be called from the audio thread, outside run().
+*/
+static inline void
+lv2_worker_host_set_freewheel(LV2_Worker_Host* host, bool freewheel)
+{
+	host->freewheel = freewheel;
+}
+
+/**
+   Schedule work, which implements LV2_Worker_Schedule::schedule_work().
+
+   This is only called by the plugin in run(), or in work_response().  The
+   request is copied to the request queue and the worker thread is woken, or
+   when freewheeling or the thread is not running (for example, when a
+   response delivered after lv2_worker_host_stop() schedules more work), the
+   work is done immediately.  In that case, this waits for the worker thread
+   to finish any request it is doing, so work() is never called concurrently.
+
+   @return LV2_WORKER_SUCCESS, or LV2_WORKER_ERR_NO_SPACE if the request
+   queue is full, or the status returned by work() when freewheeling.
+*/
+static inline LV2_Worker_Status
+lv2_worker_host_schedule(LV2_Worker_Schedule_Handle handle,
+                         uint32_t                   size,
+                         const void*                data)
+{
+	LV2_Worker_Host* const host = (LV2_Worker_Host*)handle;
+	if (host->freewheel || !host->running) {
+		if (!host->iface) {
+			return LV2_WORKER_ERR_UNKNOWN;
+		}
+
+		lv2_worker_host_lock(host);
+		const LV2_Worker_Status st = host->iface->work(host->instance,
+		                                               lv2_worker_host_respond,
+		                                               &host->sync_responses,
+		                                               size,
+		                                               data);
+		lv2_worker_host_unlock(host);
+		return st;
+	}
+
+	const LV2_Worker_Status st =
+		lv2_worker_host_queue_write(&host->requests, size, data);
+	if (!st) {
+		lv2_worker_host_sem_post(host);
+	}
+	return st;
+}
+
+/**
+   Deliver responses to the plugin and call its end_run() method.
+
+   This must be called in the audio thread after every call to run(), and is
+   realtime safe, but for the time spent in work_response() and end_run().
+   Responses from the worker thread are delivered first, followed by any
+   responses to work that was done immediately while freewheeling.
+*/
+static inline void
+lv2_worker_host_end_run(LV2_Worker_Host* host)
+{
+	if (host->iface) {
+		lv2_worker_host_queue_emit(host, &host->responses);
+		lv2_worker_host_queue_emit(host, &host->sync_responses);
+		if (host->iface->end_run) {
+			host->iface->end_run(host->instance);
+		}
+	}
+}
+
+/** Return a work:schedule feature which schedules work with `host`. */
+static inline LV2_Worker_Schedule
+lv2_worker_host_schedule_feature(LV2_Worker_Host* host)
+{
+	LV2_Worker_Schedule schedule = { host, lv2_worker_host_schedule };
+	return schedule;
+}
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* LV2_WORKER_HOST_H */
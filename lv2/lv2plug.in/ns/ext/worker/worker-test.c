@@ -0,0 +1,399 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/atom/util.h"
+#include "lv2/lv2plug.in/ns/ext/worker/host.h"
+#include "lv2/lv2plug.in/ns/ext/worker/worker.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+/** Number of cycles run in each test. */
+#define N_CYCLES 4000
+
+/** Size of the queues, small enough that they are often full. */
+#define QUEUE_SIZE 512
+
+/** Number of frames in each sample. */
+#define SAMPLE_FRAMES 4096
+
+/** Maximum number of samples waiting to be freed. */
+#define MAX_GARBAGE 64
+
+/**
+   A plugin which uses the worker like eg-sampler.
+
+   Requests to load a sample are scheduled in run(), the worker allocates and
+   fills the sample and responds with it, then work_response() installs it
+   and schedules the old sample to be freed.  Messages have an atom header,
+   like SampleMessage in sampler.c.
+*/
+enum { MSG_LOAD = 1, MSG_FREE = 2 };
+
+typedef struct {
+	uint32_t id;
+	float*   data;
+} Sample;
+
+typedef struct {
+	LV2_Atom atom;
+	uint32_t id;
+	uint32_t pad;
+} LoadMessage;
+
+typedef struct {
+	LV2_Atom atom;
+	Sample*  sample;
+} FreeMessage;
+
+typedef struct {
+	LV2_Worker_Schedule* schedule;
+	Sample*              sample;                // Current sample
+	Sample*              garbage[MAX_GARBAGE];  // Frees that did not fit
+	unsigned             n_garbage;             // Number of frees in garbage
+	uint32_t             next_id;               // ID of the next load
+	uint32_t             last_id;               // ID of the last response
+	unsigned             n_loads;               // Loads scheduled
+	unsigned             n_responses;           // Responses delivered
+	unsigned             n_end_runs;            // Calls to end_run()
+	bool                 in_run;                // Currently in run()
+	bool                 out_of_order;          // Response IDs decreased
+	bool                 bad_context;           // Called in wrong context
+	bool                 leaked;                // Garbage overflowed
+	pthread_mutex_t      mutex;                 // Lock for fields below
+	bool                 working;               // Currently in work()
+	bool                 concurrent;            // Entered work() twice
+	unsigned             n_loaded;              // Samples loaded by work()
+	unsigned             n_freed;               // Samples freed by work()
+} Plugin;
+
+static int
+test_fail(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "error: ");
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	return 1;
+}
+
+static LV2_Worker_Status
+work(LV2_Handle                  instance,
+     LV2_Worker_Respond_Function respond,
+     LV2_Worker_Respond_Handle   handle,
+     uint32_t                    size,
+     const void*                 data)
+{
+	Plugin* const         self = (Plugin*)instance;
+	const LV2_Atom* const atom = (const LV2_Atom*)data;
+	if (size < sizeof(LV2_Atom) || size != lv2_atom_total_size(atom)) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	// The lock is not held while working, so concurrent calls are detected
+	pthread_mutex_lock(&self->mutex);
+	self->concurrent |= self->working;
+	self->working     = true;
+	pthread_mutex_unlock(&self->mutex);
+
+	if (atom->type == MSG_FREE) {
+		Sample* const sample = ((const FreeMessage*)data)->sample;
+		free(sample->data);
+		free(sample);
+		pthread_mutex_lock(&self->mutex);
+		++self->n_freed;
+		self->working = false;
+		pthread_mutex_unlock(&self->mutex);
+		return LV2_WORKER_SUCCESS;
+	}
+
+	// Load a sample, which takes a while, so the queues fill up
+	Sample* sample = (Sample*)malloc(sizeof(Sample));
+	sample->id     = ((const LoadMessage*)data)->id;
+	sample->data   = (float*)malloc(SAMPLE_FRAMES * sizeof(float));
+	for (uint32_t i = 0; i < SAMPLE_FRAMES; ++i) {
+		sample->data[i] = (float)(i % 64) / 64.0f;
+	}
+
+	const LV2_Worker_Status st = respond(handle, sizeof(sample), &sample);
+	pthread_mutex_lock(&self->mutex);
+	++self->n_loaded;
+	self->working = false;
+	pthread_mutex_unlock(&self->mutex);
+	return st;
+}
+
+static void
+schedule_free(Plugin* self, Sample* sample)
+{
+	const FreeMessage msg = { { sizeof(Sample*), MSG_FREE }, sample };
+	if (self->schedule->schedule_work(
+		    self->schedule->handle, sizeof(msg), &msg)) {
+		// The queue is full, try again in the next run()
+		self->garbage[self->n_garbage++] = sample;
+	}
+}
+
+static LV2_Worker_Status
+work_response(LV2_Handle instance, uint32_t size, const void* data)
+{
+	Plugin* const self = (Plugin*)instance;
+	if (self->in_run || size != sizeof(Sample*)) {
+		self->bad_context = true;
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	Sample* const sample = *(Sample* const*)data;
+	if (sample->id <= self->last_id) {
+		self->out_of_order = true;
+	}
+	self->last_id = sample->id;
+	++self->n_responses;
+
+	// Install the new sample, and free the old one in the worker
+	if (self->sample && self->n_garbage < MAX_GARBAGE) {
+		schedule_free(self, self->sample);
+	} else if (self->sample) {
+		self->leaked = true;
+	}
+	self->sample = sample;
+	return LV2_WORKER_SUCCESS;
+}
+
+static LV2_Worker_Status
+end_run(LV2_Handle instance)
+{
+	Plugin* const self = (Plugin*)instance;
+	self->bad_context |= self->in_run;
+	++self->n_end_runs;
+	return LV2_WORKER_SUCCESS;
+}
+
+static void
+run(Plugin* self, unsigned n_loads)
+{
+	self->in_run = true;
+
+	// Retry frees that did not fit in the queue earlier
+	Sample* garbage[MAX_GARBAGE];
+	const unsigned n_garbage = self->n_garbage;
+	memcpy(garbage, self->garbage, n_garbage * sizeof(Sample*));
+	self->n_garbage = 0;
+	for (unsigned i = 0; i < n_garbage; ++i) {
+		schedule_free(self, garbage[i]);
+	}
+
+	// Load some new samples
+	for (unsigned i = 0; i < n_loads; ++i) {
+		const LoadMessage msg = {
+			{ 2 * sizeof(uint32_t), MSG_LOAD }, self->next_id, 0 };
+		if (!self->schedule->schedule_work(
+			    self->schedule->handle, sizeof(msg), &msg)) {
+			++self->next_id;
+			++self->n_loads;
+		}
+	}
+
+	self->in_run = false;
+}
+
+static const LV2_Worker_Interface iface = { work, work_response, end_run };
+
+static void
+plugin_init(Plugin* self, LV2_Worker_Schedule* schedule)
+{
+	memset(self, 0, sizeof(Plugin));
+	self->schedule = schedule;
+	self->next_id  = 1;
+	pthread_mutex_init(&self->mutex, NULL);
+}
+
+/** Free everything that is left, and check that nothing was lost. */
+static int
+plugin_finish(Plugin* self, LV2_Worker_Host* host)
+{
+	lv2_worker_host_stop(host);
+	lv2_worker_host_end_run(host);
+
+	// Free samples that never fit in the request queue, and the current one
+	for (unsigned i = 0; i < self->n_garbage; ++i) {
+		const FreeMessage msg = {
+			{ sizeof(Sample*), MSG_FREE }, self->garbage[i] };
+		work(self, lv2_worker_host_respond, NULL, sizeof(msg), &msg);
+	}
+	if (self->sample) {
+		free(self->sample->data);
+		free(self->sample);
+		++self->n_freed;
+	}
+
+	lv2_worker_host_free(host);
+	pthread_mutex_destroy(&self->mutex);
+	if (self->bad_context) {
+		return test_fail("Plugin called in the wrong context\n");
+	} else if (self->leaked) {
+		return test_fail("Too many samples waiting to be freed\n");
+	} else if (self->n_loaded != self->n_loads ||
+	           self->n_responses != self->n_loads) {
+		return test_fail("Scheduled %u loads, did %u, got %u responses\n",
+		                 self->n_loads, self->n_loaded, self->n_responses);
+	} else if (self->n_freed != self->n_loaded) {
+		return test_fail("Loaded %u samples, freed %u\n",
+		                 self->n_loaded, self->n_freed);
+	}
+	return 0;
+}
+
+static int
+test_threaded(void)
+{
+	LV2_Worker_Host     host;
+	LV2_Worker_Schedule schedule;
+	Plugin              plugin;
+	if (!lv2_worker_host_init(&host, QUEUE_SIZE)) {
+		return test_fail("Failed to initialise worker\n");
+	}
+	schedule = lv2_worker_host_schedule_feature(&host);
+	plugin_init(&plugin, &schedule);
+	if (!lv2_worker_host_start(&host, &plugin, &iface)) {
+		return test_fail("Failed to start worker\n");
+	}
+
+	// Schedule bursts of loads as fast as possible
+	unsigned n_full = 0;
+	for (unsigned i = 0; i < N_CYCLES; ++i) {
+		const unsigned n_loads = plugin.n_loads;
+		run(&plugin, i % 8);
+		n_full += plugin.n_loads - n_loads < i % 8;
+		lv2_worker_host_end_run(&host);
+	}
+
+	if (plugin.out_of_order) {
+		return test_fail("Responses delivered out of order\n");
+	} else if (plugin.n_end_runs != N_CYCLES) {
+		return test_fail("end_run() called %u times\n", plugin.n_end_runs);
+	} else if (!n_full) {
+		fprintf(stderr, "warning: Request queue was never full\n");
+	}
+	return plugin_finish(&plugin, &host);
+}
+
+static int
+test_freewheel(void)
+{
+	LV2_Worker_Host     host;
+	LV2_Worker_Schedule schedule;
+	Plugin              plugin;
+	lv2_worker_host_init(&host, QUEUE_SIZE);
+	schedule = lv2_worker_host_schedule_feature(&host);
+	plugin_init(&plugin, &schedule);
+	lv2_worker_host_start(&host, &plugin, &iface);
+	lv2_worker_host_set_freewheel(&host, true);
+
+	// Every load must be done and delivered in the same cycle
+	for (unsigned i = 0; i < N_CYCLES; ++i) {
+		run(&plugin, 1 + i % 3);
+		lv2_worker_host_end_run(&host);
+		if (!plugin.sample || plugin.sample->id != plugin.next_id - 1) {
+			return test_fail("Work not done immediately\n");
+		} else if (plugin.n_freed != plugin.n_loaded - 1) {
+			return test_fail("Sample not freed immediately\n");
+		}
+	}
+
+	if (plugin.out_of_order) {
+		return test_fail("Responses delivered out of order\n");
+	}
+	return plugin_finish(&plugin, &host);
+}
+
+static int
+test_switch(void)
+{
+	LV2_Worker_Host     host;
+	LV2_Worker_Schedule schedule;
+	Plugin              plugin;
+	lv2_worker_host_init(&host, QUEUE_SIZE);
+	schedule = lv2_worker_host_schedule_feature(&host);
+	plugin_init(&plugin, &schedule);
+	lv2_worker_host_start(&host, &plugin, &iface);
+
+	// Switch between freewheeling and not, nothing must be lost
+	for (unsigned i = 0; i < N_CYCLES; ++i) {
+		lv2_worker_host_set_freewheel(&host, (i / 16) % 2);
+		run(&plugin, i % 8);
+		lv2_worker_host_end_run(&host);
+	}
+
+	if (plugin.concurrent) {
+		return test_fail("Called work() concurrently\n");
+	}
+	return plugin_finish(&plugin, &host);
+}
+
+static int
+test_errors(void)
+{
+	LV2_Worker_Host host;
+	if (lv2_worker_host_init(&host, 100) || lv2_worker_host_init(&host, 8)) {
+		return test_fail("Initialised worker with invalid queue size\n");
+	}
+
+	// Without a plugin interface, no work can be done
+	lv2_worker_host_init(&host, 64);
+	LV2_Worker_Schedule schedule = lv2_worker_host_schedule_feature(&host);
+	if (schedule.schedule_work(schedule.handle, 0, NULL) !=
+	    LV2_WORKER_ERR_UNKNOWN) {
+		return test_fail("Scheduled work with no plugin interface\n");
+	}
+
+	// Start fails with an incomplete interface
+	const LV2_Worker_Interface incomplete = { work, NULL, NULL };
+	Plugin                     plugin;
+	plugin_init(&plugin, &schedule);
+	if (lv2_worker_host_start(&host, &plugin, &incomplete) ||
+	    !lv2_worker_host_start(&host, &plugin, &iface) ||
+	    lv2_worker_host_start(&host, &plugin, &iface)) {
+		return test_fail("Unexpected result from starting worker\n");
+	}
+
+	// Messages that are too large for the queue do not fit
+	char big[64];
+	memset(big, 0, sizeof(big));
+	if (schedule.schedule_work(schedule.handle, sizeof(big), big) !=
+	    LV2_WORKER_ERR_NO_SPACE) {
+		return test_fail("Scheduled work larger than the queue\n");
+	}
+
+	return plugin_finish(&plugin, &host);
+}
+
+int
+main(void)
+{
+	if (test_threaded() || test_freewheel() || test_switch() ||
+	    test_errors()) {
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
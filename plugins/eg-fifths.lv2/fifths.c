@@ -16,14 +16,13 @@
 */
 
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #ifndef __cplusplus
 #    include <stdbool.h>
 #endif
 
-#include <sndfile.h>
-
 #include "lv2/lv2plug.in/ns/ext/atom/util.h"
 #include "lv2/lv2plug.in/ns/ext/midi/midi.h"
 #include "lv2/lv2plug.in/ns/ext/patch/patch.h"
@@ -105,6 +104,18 @@ cleanup(LV2_Handle instance)
 	free(instance);
 }
 
+/**
+   Process a cycle.
+
+   Since most events are passed through unchanged, this edits the sequence in
+   place rather than building a new one.  The input is copied to the output in
+   a single block, then the editor inserts a fifth after every note and removes
+   non-MIDI events, only moving events when necessary.
+
+   Inserting events needs the capacity of the output, which is unknown if the
+   host connects both ports to the same buffer, so this plugin requires
+   lv2:inPlaceBroken.
+*/
 static void
 run(LV2_Handle instance,
     uint32_t   sample_count)
@@ -123,48 +134,64 @@ run(LV2_Handle instance,
 	// Get the capacity
 	const uint32_t out_capacity = self->out_port->atom.size;
 
-	// Write an empty Sequence header to the output
-	lv2_atom_sequence_clear(self->out_port);
-	self->out_port->atom.type = self->in_port->atom.type;
-
-	// Read incoming events
-	LV2_ATOM_SEQUENCE_FOREACH(self->in_port, ev) {
-		if (ev->body.type == uris->midi_Event) {
-			const uint8_t* const msg = (const uint8_t*)(ev + 1);
-			switch (lv2_midi_message_type(msg)) {
-			case LV2_MIDI_MSG_NOTE_ON:
-			case LV2_MIDI_MSG_NOTE_OFF:
-				// Forward note to output
+	// Copy the input to the output
+	const uint32_t in_size = self->in_port->atom.size;
+	if (in_size <= out_capacity) {
+		memcpy(self->out_port, self->in_port, sizeof(LV2_Atom) + in_size);
+	} else {
+		// The input does not fit, so copy as many MIDI events as possible
+		lv2_atom_sequence_clear(self->out_port);
+		self->out_port->atom.type = self->in_port->atom.type;
+		self->out_port->body.unit = self->in_port->body.unit;
+		LV2_ATOM_SEQUENCE_FOREACH(self->in_port, ev) {
+			if (ev->body.type == uris->midi_Event) {
 				lv2_atom_sequence_append_event(
 					self->out_port, out_capacity, ev);
-
-				const uint8_t note = msg[1];
-				if (note <= 127 - 7) {
-					// Make a note one 5th (7 semitones) higher than input
-					MIDINoteEvent fifth;
-					
-					// Could simply do fifth.event = *ev here instead...
-					fifth.event.time.frames = ev->time.frames;  // Same time
-					fifth.event.body.type   = ev->body.type;    // Same type
-					fifth.event.body.size   = ev->body.size;    // Same size
-					
-					fifth.msg[0] = msg[0];      // Same status
-					fifth.msg[1] = msg[1] + 7;  // Pitch up 7 semitones
-					fifth.msg[2] = msg[2];      // Same velocity
-
-					// Write 5th event
-					lv2_atom_sequence_append_event(
-						self->out_port, out_capacity, &fifth.event);
-				}
-				break;
-			default:
-				// Forward all other MIDI events directly
-				lv2_atom_sequence_append_event(
-					self->out_port, out_capacity, ev);
-				break;
 			}
 		}
 	}
+
+	// Edit the output sequence in place
+	LV2_Atom_Sequence_Editor editor;
+	lv2_atom_sequence_editor_init(&editor, self->out_port, out_capacity);
+	for (LV2_Atom_Event* ev = NULL;
+	     (ev = lv2_atom_sequence_editor_current(&editor));) {
+		if (ev->body.type != uris->midi_Event) {
+			// Remove non-MIDI events
+			lv2_atom_sequence_editor_drop(&editor);
+			continue;
+		}
+
+		const uint8_t* const msg = (const uint8_t*)(ev + 1);
+		const bool           note =
+			(lv2_midi_message_type(msg) == LV2_MIDI_MSG_NOTE_ON ||
+			 lv2_midi_message_type(msg) == LV2_MIDI_MSG_NOTE_OFF);
+
+		// Make a note one 5th (7 semitones) higher than input
+		MIDINoteEvent fifth;
+		if (note && msg[1] <= 127 - 7) {
+			// Could simply do fifth.event = *ev here instead...
+			fifth.event.time.frames = ev->time.frames;  // Same time
+			fifth.event.body.type   = ev->body.type;    // Same type
+			fifth.event.body.size   = ev->body.size;    // Same size
+
+			fifth.msg[0] = msg[0];      // Same status
+			fifth.msg[1] = msg[1] + 7;  // Pitch up 7 semitones
+			fifth.msg[2] = msg[2];      // Same velocity
+		} else {
+			fifth.event.body.size = 0;
+		}
+
+		/* Keep the original event unchanged.  Later edits may move it, so `ev`
+		   and `msg` must not be used after this point. */
+		lv2_atom_sequence_editor_keep(&editor);
+
+		if (fifth.event.body.size) {
+			// Insert 5th event after the note, or drop it if the output is full
+			lv2_atom_sequence_editor_insert(&editor, &fifth.event);
+		}
+	}
+	lv2_atom_sequence_editor_finish(&editor);
 }
 
 static const void*
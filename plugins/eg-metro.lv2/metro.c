@@ -27,6 +27,7 @@
 #include "lv2/lv2plug.in/ns/ext/atom/util.h"
 #include "lv2/lv2plug.in/ns/ext/time/time.h"
 #include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+#include "lv2/lv2plug.in/ns/ext/urid/util.h"
 #include "lv2/lv2plug.in/ns/lv2core/lv2.h"
 
 #ifndef M_PI
@@ -42,15 +43,35 @@ typedef struct {
 	LV2_URID atom_Path;
 	LV2_URID atom_Resource;
 	LV2_URID atom_Sequence;
+	LV2_URID atom_beatTime;
 	LV2_URID time_Position;
 	LV2_URID time_barBeat;
 	LV2_URID time_beatsPerMinute;
 	LV2_URID time_speed;
 } MetroURIs;
 
+/** Indices of URIs in the arrays used to map them in instantiate(). */
+enum {
+	URI_atom_Blank,
+	URI_atom_Float,
+	URI_atom_Object,
+	URI_atom_Path,
+	URI_atom_Resource,
+	URI_atom_Sequence,
+	URI_atom_beatTime,
+	URI_time_Position,
+	URI_time_barBeat,
+	URI_time_beatsPerMinute,
+	URI_time_speed,
+	N_URIS
+};
+
 static const double attack_s = 0.005;
 static const double decay_s  = 0.075;
 
+/** The maximum number of tempo changes in a cycle, plus one. */
+#define METRO_MAX_TEMPOS 4
+
 enum {
 	METRO_CONTROL = 0,
 	METRO_OUT     = 1
@@ -88,6 +109,10 @@ typedef struct {
 	float  bpm;    // Beats per minute (tempo)
 	float  speed;  // Transport speed (usually 0=stop, 1=play)
 
+	// Tempo changes in the current cycle, to convert between frames and beats
+	LV2_Atom_Tempo_Segment tempo_segments[METRO_MAX_TEMPOS];
+	LV2_Atom_Tempo_Map     tempo;
+
 	uint32_t elapsed_len;  // Frames since the start of the last click
 	uint32_t wave_offset;  // Current play offset in the wave
 	State    state;        // Current play state
@@ -151,11 +176,14 @@ instantiate(const LV2_Descriptor*     descriptor,
 		return NULL;
 	}
 
-	// Scan host features for URID map
-	LV2_URID_Map* map = NULL;
+	// Scan host features for URID map, and batch map if it is supported
+	LV2_URID_Map*       map   = NULL;
+	LV2_URID_Map_Batch* batch = NULL;
 	for (int i = 0; features[i]; ++i) {
-		if (!strcmp(features[i]->URI, LV2_URID_URI "#map")) {
+		if (!strcmp(features[i]->URI, LV2_URID__map)) {
 			map = (LV2_URID_Map*)features[i]->data;
+		} else if (!strcmp(features[i]->URI, LV2_URID__mapBatch)) {
+			batch = (LV2_URID_Map_Batch*)features[i]->data;
 		}
 	}
 	if (!map) {
@@ -164,19 +192,41 @@ instantiate(const LV2_Descriptor*     descriptor,
 		return NULL;
 	}
 
-	// Map URIS
+	// Map URIs, in one call if possible
+	static const char* const uri_strings[N_URIS] = {
+		[URI_atom_Blank]          = LV2_ATOM__Blank,
+		[URI_atom_Float]          = LV2_ATOM__Float,
+		[URI_atom_Object]         = LV2_ATOM__Object,
+		[URI_atom_Path]           = LV2_ATOM__Path,
+		[URI_atom_Resource]       = LV2_ATOM__Resource,
+		[URI_atom_Sequence]       = LV2_ATOM__Sequence,
+		[URI_atom_beatTime]       = LV2_ATOM__beatTime,
+		[URI_time_Position]       = LV2_TIME__Position,
+		[URI_time_barBeat]        = LV2_TIME__barBeat,
+		[URI_time_beatsPerMinute] = LV2_TIME__beatsPerMinute,
+		[URI_time_speed]          = LV2_TIME__speed
+	};
+	LV2_URID urids[N_URIS];
+	if (lv2_urid_map_batch(batch, map, N_URIS, uri_strings, urids) != N_URIS) {
+		fprintf(stderr, "Failed to map URIs.\n");
+		free(self);
+		return NULL;
+	}
+
+	// Set each URID by name, so the order of MetroURIs does not matter
 	MetroURIs* const uris = &self->uris;
-	self->map = map;
-	uris->atom_Blank          = map->map(map->handle, LV2_ATOM__Blank);
-	uris->atom_Float          = map->map(map->handle, LV2_ATOM__Float);
-	uris->atom_Object         = map->map(map->handle, LV2_ATOM__Object);
-	uris->atom_Path           = map->map(map->handle, LV2_ATOM__Path);
-	uris->atom_Resource       = map->map(map->handle, LV2_ATOM__Resource);
-	uris->atom_Sequence       = map->map(map->handle, LV2_ATOM__Sequence);
-	uris->time_Position       = map->map(map->handle, LV2_TIME__Position);
-	uris->time_barBeat        = map->map(map->handle, LV2_TIME__barBeat);
-	uris->time_beatsPerMinute = map->map(map->handle, LV2_TIME__beatsPerMinute);
-	uris->time_speed          = map->map(map->handle, LV2_TIME__speed);
+	uris->atom_Blank          = urids[URI_atom_Blank];
+	uris->atom_Float          = urids[URI_atom_Float];
+	uris->atom_Object         = urids[URI_atom_Object];
+	uris->atom_Path           = urids[URI_atom_Path];
+	uris->atom_Resource       = urids[URI_atom_Resource];
+	uris->atom_Sequence       = urids[URI_atom_Sequence];
+	uris->atom_beatTime       = urids[URI_atom_beatTime];
+	uris->time_Position       = urids[URI_time_Position];
+	uris->time_barBeat        = urids[URI_time_barBeat];
+	uris->time_beatsPerMinute = urids[URI_time_beatsPerMinute];
+	uris->time_speed          = urids[URI_time_speed];
+	self->map                 = map;
 
 	// Initialise instance fields
 	self->rate       = rate;
@@ -184,6 +234,9 @@ instantiate(const LV2_Descriptor*     descriptor,
 	self->attack_len = (uint32_t)(attack_s * rate);
 	self->decay_len  = (uint32_t)(decay_s * rate);
 	self->state      = STATE_OFF;
+	lv2_atom_tempo_map_init(
+		&self->tempo, self->tempo_segments, METRO_MAX_TEMPOS, rate);
+	lv2_atom_tempo_map_reset(&self->tempo, 0, 0.0, self->bpm);
 
 	// Generate one cycle of a sine wave at the desired frequency
 	const double freq = 440.0 * 2.0;
@@ -200,21 +253,28 @@ instantiate(const LV2_Descriptor*     descriptor,
 static void
 cleanup(LV2_Handle instance)
 {
-	free(instance);
+	Metro* self = (Metro*)instance;
+	free(self->wave);
+	free(self);
 }
 
 /**
    Play back audio for the range [begin..end) relative to this cycle.  This is
    called by run() in-between events to output audio up until the current time.
+   The length of a beat is taken from the tempo map, which stores it for every
+   tempo, so no division is needed here.
 */
 static void
 play(Metro* self, uint32_t begin, uint32_t end)
 {
+	const LV2_Atom_Tempo_Segment* tempo =
+		lv2_atom_tempo_map_segment_at_frames(&self->tempo, begin);
+
 	float* const   output          = self->ports.output;
-	const uint32_t frames_per_beat = 60.0f / self->bpm * self->rate;
+	const uint32_t frames_per_beat = (uint32_t)tempo->frames_per_beat;
 
 	if (self->speed == 0.0f) {
-		memset(output, 0, (end - begin) * sizeof(float));
+		memset(output + begin, 0, (end - begin) * sizeof(float));
 		return;
 	}
 
@@ -255,10 +315,12 @@ play(Metro* self, uint32_t begin, uint32_t end)
 
 /**
    Update the current position based on a host message.  This is called by
-   run() when a time:Position is received.
+   run() when a time:Position is received at `frames` in the cycle.  A tempo
+   change is added to the tempo map, so later events in beat time are placed
+   at the correct frame, and play() uses the new tempo.
 */
 static void
-update_position(Metro* self, const LV2_Atom_Object* obj)
+update_position(Metro* self, const LV2_Atom_Object* obj, uint32_t frames)
 {
 	const MetroURIs* uris = &self->uris;
 
@@ -272,6 +334,14 @@ update_position(Metro* self, const LV2_Atom_Object* obj)
 	if (bpm && bpm->type == uris->atom_Float) {
 		// Tempo changed, update BPM
 		self->bpm = ((LV2_Atom_Float*)bpm)->body;
+		if (!lv2_atom_tempo_map_set_tempo(&self->tempo, frames, self->bpm)) {
+			// Map is full, so restart it here, since earlier times are done
+			lv2_atom_tempo_map_reset(
+				&self->tempo,
+				frames,
+				lv2_atom_tempo_map_frames_to_beats(&self->tempo, frames),
+				self->bpm);
+		}
 	}
 	if (speed && speed->type == uris->atom_Float) {
 		// Speed changed, e.g. 0 (stop) to 1 (play)
@@ -280,10 +350,13 @@ update_position(Metro* self, const LV2_Atom_Object* obj)
 	if (beat && beat->type == uris->atom_Float) {
 		// Received a beat position, synchronise
 		// This hard sync may cause clicks, a real plugin would be more graceful
-		const float frames_per_beat = 60.0f / self->bpm * self->rate;
-		const float bar_beats       = ((LV2_Atom_Float*)beat)->body;
-		const float beat_beats      = bar_beats - floorf(bar_beats);
-		self->elapsed_len           = beat_beats * frames_per_beat;
+		const LV2_Atom_Tempo_Segment* tempo =
+			lv2_atom_tempo_map_segment_at_frames(&self->tempo, frames);
+
+		const double frames_per_beat = tempo->frames_per_beat;
+		const float  bar_beats       = ((LV2_Atom_Float*)beat)->body;
+		const float  beat_beats      = bar_beats - floorf(bar_beats);
+		self->elapsed_len            = beat_beats * frames_per_beat;
 		if (self->elapsed_len < self->attack_len) {
 			self->state = STATE_ATTACK;
 		} else if (self->elapsed_len < self->attack_len + self->decay_len) {
@@ -294,39 +367,51 @@ update_position(Metro* self, const LV2_Atom_Object* obj)
 	}
 }
 
+/**
+   The run() method works forwards in time through the cycle in slices
+   between events, using the slicer from the atom utilities.  For each slice,
+   the events at the start of the slice are handled first, then the click is
+   played for the rest of the slice.  This way, every event takes effect at
+   exactly the right time, but the audio rendering in play() is only
+   interrupted when there is an event.
+
+   The host may send events with time stamps in beats rather than frames.  In
+   that case, the slicer is given the tempo map for this cycle, which starts at
+   beat 0 at the start of the cycle, to find the frame of each event.
+*/
 static void
 run(LV2_Handle instance, uint32_t sample_count)
 {
 	Metro*           self = (Metro*)instance;
 	const MetroURIs* uris = &self->uris;
 
-	// Work forwards in time frame by frame, handling events as we go
-	const LV2_Atom_Sequence* in     = self->ports.control;
-	uint32_t                 last_t = 0;
-	for (const LV2_Atom_Event* ev = lv2_atom_sequence_begin(&in->body);
-	     !lv2_atom_sequence_is_end(&in->body, in->atom.size, ev);
-	     ev = lv2_atom_sequence_next(ev)) {
-
-		// Play the click for the time slice from last_t until now
-		play(self, last_t, ev->time.frames);
-
-		// Check if this event is an Object
-		// (or deprecated Blank to tolerate old hosts)
-		if (ev->body.type == uris->atom_Object ||
-		    ev->body.type == uris->atom_Blank) {
-			const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
-			if (obj->body.otype == uris->time_Position) {
-				// Received position information, update
-				update_position(self, obj);
+	// Start the tempo map for this cycle at the current tempo
+	lv2_atom_tempo_map_reset(&self->tempo, 0, 0.0, self->bpm);
+
+	const LV2_Atom_Sequence* control = self->ports.control;
+	LV2_Atom_Slicer          slicer;
+	LV2_Atom_Slice           slice;
+	lv2_atom_slicer_init(&slicer, control, sample_count, 0);
+	if (control->body.unit == uris->atom_beatTime) {
+		lv2_atom_slicer_set_tempo(&slicer, &self->tempo);
+	}
+	while (lv2_atom_slicer_next(&slicer, &slice)) {
+		LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+			// Check if this event is an Object
+			// (or deprecated Blank to tolerate old hosts)
+			if (ev->body.type == uris->atom_Object ||
+			    ev->body.type == uris->atom_Blank) {
+				const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
+				if (obj->body.otype == uris->time_Position) {
+					// Received position information, update
+					update_position(self, obj, slice.begin);
+				}
 			}
 		}
 
-		// Update time for next iteration and move to next event
-		last_t = ev->time.frames;
+		// Play the click for the time slice until the next event
+		play(self, slice.begin, slice.end);
 	}
-
-	// Play for remainder of cycle
-	play(self, last_t, sample_count);
 }
 
 static const LV2_Descriptor descriptor = {
@@ -126,15 +126,15 @@ write_output(Midigate* self, uint32_t offset, uint32_t len)
 }
 
 /**
-   This plugin works through the cycle in chunks starting at offset zero.  The
-   +offset+ represents the current time within this this cycle, so
-   the output from 0 to +offset+ has already been written.
+   This plugin works through the cycle in slices between events, using the
+   slicer from the atom utilities.  Each slice begins with the events that
+   occur at that time, and ends at the time of the next event (or the end of
+   the cycle), so the output from slice.begin to slice.end can be written in
+   one chunk with the gate unchanged.
 
-   MIDI events are read in a loop.  In each iteration, the number of active
-   notes (on note on and note off) or the program (on program change) is
-   updated, then the output is written up until the current event time.  Then
-   +offset+ is updated and the next event is processed.  After the loop the
-   final chunk from the last event to the end of the cycle is emitted.
+   For each slice, the number of active notes (on note on and note off) or the
+   program (on program change) is updated for every event in the slice, then
+   the output is written for the slice.
 
    There is currently no standard way to describe MIDI programs in LV2, so the
    host has no way of knowing that these programs exist and should be presented
@@ -150,33 +150,34 @@ write_output(Midigate* self, uint32_t offset, uint32_t len)
 static void
 run(LV2_Handle instance, uint32_t sample_count)
 {
-	Midigate* self   = (Midigate*)instance;
-	uint32_t  offset = 0;
-
-	LV2_ATOM_SEQUENCE_FOREACH(self->control, ev) {
-		if (ev->body.type == self->uris.midi_MidiEvent) {
-			const uint8_t* const msg = (const uint8_t*)(ev + 1);
-			switch (lv2_midi_message_type(msg)) {
-			case LV2_MIDI_MSG_NOTE_ON:
-				++self->n_active_notes;
-				break;
-			case LV2_MIDI_MSG_NOTE_OFF:
-				--self->n_active_notes;
-				break;
-			case LV2_MIDI_MSG_PGM_CHANGE:
-				if (msg[1] == 0 || msg[1] == 1) {
-					self->program = msg[1];
+	Midigate* self = (Midigate*)instance;
+
+	LV2_Atom_Slicer slicer;
+	LV2_Atom_Slice  slice;
+	lv2_atom_slicer_init(&slicer, self->control, sample_count, 0);
+	while (lv2_atom_slicer_next(&slicer, &slice)) {
+		LV2_ATOM_SLICE_FOREACH(&slice, ev) {
+			if (ev->body.type == self->uris.midi_MidiEvent) {
+				const uint8_t* const msg = (const uint8_t*)(ev + 1);
+				switch (lv2_midi_message_type(msg)) {
+				case LV2_MIDI_MSG_NOTE_ON:
+					++self->n_active_notes;
+					break;
+				case LV2_MIDI_MSG_NOTE_OFF:
+					--self->n_active_notes;
+					break;
+				case LV2_MIDI_MSG_PGM_CHANGE:
+					if (msg[1] == 0 || msg[1] == 1) {
+						self->program = msg[1];
+					}
+					break;
+				default: break;
 				}
-				break;
-			default: break;
 			}
 		}
 
-		write_output(self, offset, ev->time.frames - offset);
-		offset = (uint32_t)ev->time.frames;
+		write_output(self, slice.begin, slice.end - slice.begin);
 	}
-
-	write_output(self, offset, sample_count - offset);
 }
 
 /**
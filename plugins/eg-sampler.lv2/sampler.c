@@ -80,9 +80,18 @@ typedef struct {
 	// URIs
 	SamplerURIs uris;
 
+	// Handlers for incoming events
+	LV2_Atom_Dispatch dispatch;
+
+	// Pre-forged patch:Set message for the sample file
+	LV2_Atom_Template set_file_tmpl;
+
 	// Current position in run()
 	uint32_t frame_offset;
 
+	// Frame to start playing from in the current cycle
+	uint32_t start_frame;
+
 	// Playback state
 	sf_count_t frame;
 	bool       play;
@@ -219,11 +228,19 @@ work_response(LV2_Handle  instance,
 	// Install the new sample
 	self->sample = *(Sample*const*)data;
 
-	// Send a notification that we're using a new sample.
-	lv2_atom_forge_frame_time(&self->forge, self->frame_offset);
-	write_set_file(&self->forge, &self->uris,
-	               self->sample->path,
-	               self->sample->path_len);
+	/* Send a notification that we're using a new sample.  This copies the
+	   message made in instantiate() with the path, and the null terminator,
+	   as the value.  If it does not fit, the event time is removed as well,
+	   so no event without a body is left in the notify sequence. */
+	const LV2_Atom_Forge_Checkpoint checkpoint =
+		lv2_atom_forge_checkpoint(&self->forge);
+	if (!lv2_atom_forge_frame_time(&self->forge, self->frame_offset) ||
+	    !lv2_atom_template_write_tail(&self->set_file_tmpl,
+	                                  &self->forge,
+	                                  self->sample->path,
+	                                  self->sample->path_len + 1)) {
+		lv2_atom_forge_rollback(&self->forge, &checkpoint);
+	}
 
 	return LV2_WORKER_SUCCESS;
 }
@@ -249,6 +266,49 @@ connect_port(LV2_Handle instance,
 	}
 }
 
+/** Handle an incoming MIDI event, starting playback on a note on. */
+static void
+on_midi_event(void* handle, const LV2_Atom_Event* ev)
+{
+	Sampler* const       self = (Sampler*)handle;
+	const uint8_t* const msg  = (const uint8_t*)(ev + 1);
+	switch (lv2_midi_message_type(msg)) {
+	case LV2_MIDI_MSG_NOTE_ON:
+		self->start_frame = ev->time.frames;
+		self->frame       = 0;
+		self->play        = true;
+		break;
+	default:
+		break;
+	}
+}
+
+/** Handle an incoming patch:Set message by sending it to the worker. */
+static void
+on_patch_set(void* handle, const LV2_Atom_Event* ev)
+{
+	Sampler* const self = (Sampler*)handle;
+	lv2_log_trace(&self->logger, "Queueing set message\n");
+	self->schedule->schedule_work(self->schedule->handle,
+	                              lv2_atom_total_size(&ev->body),
+	                              &ev->body);
+}
+
+static void
+on_unknown_object(void* handle, const LV2_Atom_Event* ev)
+{
+	Sampler* const         self = (Sampler*)handle;
+	const LV2_Atom_Object* obj  = (const LV2_Atom_Object*)&ev->body;
+	lv2_log_trace(&self->logger, "Unknown object type %d\n", obj->body.otype);
+}
+
+static void
+on_unknown_event(void* handle, const LV2_Atom_Event* ev)
+{
+	Sampler* const self = (Sampler*)handle;
+	lv2_log_trace(&self->logger, "Unknown event type %d\n", ev->body.type);
+}
+
 static LV2_Handle
 instantiate(const LV2_Descriptor*     descriptor,
             double                    rate,
@@ -285,6 +345,26 @@ instantiate(const LV2_Descriptor*     descriptor,
 	lv2_atom_forge_init(&self->forge, self->map);
 	lv2_log_logger_init(&self->logger, self->map, self->log);
 
+	// Build the table of handlers for incoming events
+	LV2_Atom_Dispatch* dispatch = &self->dispatch;
+	lv2_atom_dispatch_init(dispatch,
+	                       self->uris.atom_Object,
+	                       self->uris.atom_Blank,
+	                       self->uris.atom_Resource);
+	lv2_atom_dispatch_add(dispatch, self->uris.midi_Event, 0, on_midi_event);
+	lv2_atom_dispatch_add(dispatch, self->uris.atom_Object, self->uris.patch_Set,
+	                      on_patch_set);
+	lv2_atom_dispatch_add(dispatch, self->uris.atom_Object, 0, on_unknown_object);
+	dispatch->fallback = on_unknown_event;
+
+	// Forge the message for notifying about the sample file once, in advance
+	if (!make_set_file_template(&self->set_file_tmpl, &self->forge,
+	                            &self->uris)) {
+		lv2_log_error(&self->logger, "Failed to build patch:Set template\n");
+		lv2_atom_template_free(&self->set_file_tmpl);
+		goto fail;
+	}
+
 	// Load the default sample file
 	const size_t path_len    = strlen(path);
 	const size_t file_len    = strlen(default_sample_file);
@@ -306,6 +386,7 @@ cleanup(LV2_Handle instance)
 {
 	Sampler* self = (Sampler*)instance;
 	free_sample(self, self->sample);
+	lv2_atom_template_free(&self->set_file_tmpl);
 	free(self);
 }
 
@@ -313,11 +394,9 @@ static void
 run(LV2_Handle instance,
     uint32_t   sample_count)
 {
-	Sampler*     self        = (Sampler*)instance;
-	SamplerURIs* uris        = &self->uris;
-	sf_count_t   start_frame = 0;
-	sf_count_t   pos         = 0;
-	float*       output      = self->output_port;
+	Sampler*   self   = (Sampler*)instance;
+	sf_count_t pos    = 0;
+	float*     output = self->output_port;
 
 	// Set up forge to write directly to notify output port.
 	const uint32_t notify_capacity = self->notify_port->atom.size;
@@ -328,35 +407,18 @@ run(LV2_Handle instance,
 	// Start a sequence in the notify output port.
 	lv2_atom_forge_sequence_head(&self->forge, &self->notify_frame, 0);
 
-	// Read incoming events
-	LV2_ATOM_SEQUENCE_FOREACH(self->control_port, ev) {
-		self->frame_offset = ev->time.frames;
-		if (ev->body.type == uris->midi_Event) {
-			const uint8_t* const msg = (const uint8_t*)(ev + 1);
-			switch (lv2_midi_message_type(msg)) {
-			case LV2_MIDI_MSG_NOTE_ON:
-				start_frame = ev->time.frames;
-				self->frame = 0;
-				self->play  = true;
-				break;
-			default:
-				break;
-			}
-		} else if (lv2_atom_forge_is_object_type(&self->forge, ev->body.type)) {
-			const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
-			if (obj->body.otype == uris->patch_Set) {
-				// Received a set message, send it to the worker.
-				lv2_log_trace(&self->logger, "Queueing set message\n");
-				self->schedule->schedule_work(self->schedule->handle,
-				                              lv2_atom_total_size(&ev->body),
-				                              &ev->body);
-			} else {
-				lv2_log_trace(&self->logger,
-				              "Unknown object type %d\n", obj->body.otype);
-			}
-		} else {
-			lv2_log_trace(&self->logger,
-			              "Unknown event type %d\n", ev->body.type);
+	/* Read incoming events, dispatching each to the appropriate handler.  The
+	   sequence is checked first, so the handlers and the worker can safely
+	   read messages without checking bounds everywhere. */
+	const LV2_Atom_Sequence* control = self->control_port;
+	self->start_frame = 0;
+	if (!lv2_atom_sequence_validate(&self->forge, control,
+	                                lv2_atom_total_size(&control->atom))) {
+		lv2_log_error(&self->logger, "Ignoring malformed control input\n");
+	} else {
+		LV2_ATOM_SEQUENCE_FOREACH(control, ev) {
+			self->frame_offset = ev->time.frames;
+			lv2_atom_dispatch_event(&self->dispatch, self, ev);
 		}
 	}
 
@@ -365,7 +427,7 @@ run(LV2_Handle instance,
 		uint32_t       f  = self->frame;
 		const uint32_t lf = self->sample->info.frames;
 
-		for (pos = 0; pos < start_frame; ++pos) {
+		for (pos = 0; pos < self->start_frame; ++pos) {
 			output[pos] = 0;
 		}
 
@@ -18,6 +18,7 @@
 #ifndef SAMPLER_URIS_H
 #define SAMPLER_URIS_H
 
+#include "lv2/lv2plug.in/ns/ext/atom/template.h"
 #include "lv2/lv2plug.in/ns/ext/log/log.h"
 #include "lv2/lv2plug.in/ns/ext/midi/midi.h"
 #include "lv2/lv2plug.in/ns/ext/state/state.h"
@@ -29,6 +30,7 @@
 
 typedef struct {
 	LV2_URID atom_Blank;
+	LV2_URID atom_Object;
 	LV2_URID atom_Path;
 	LV2_URID atom_Resource;
 	LV2_URID atom_Sequence;
@@ -47,6 +49,7 @@ static inline void
 map_sampler_uris(LV2_URID_Map* map, SamplerURIs* uris)
 {
 	uris->atom_Blank         = map->map(map->handle, LV2_ATOM__Blank);
+	uris->atom_Object        = map->map(map->handle, LV2_ATOM__Object);
 	uris->atom_Path          = map->map(map->handle, LV2_ATOM__Path);
 	uris->atom_Resource      = map->map(map->handle, LV2_ATOM__Resource);
 	uris->atom_Sequence      = map->map(map->handle, LV2_ATOM__Sequence);
@@ -88,6 +91,29 @@ write_set_file(LV2_Atom_Forge*    forge,
 	return set;
 }
 
+/**
+ * Build a template for the message written by write_set_file(), with the path
+ * as its tail, so it can be sent with lv2_atom_template_write_tail().
+ */
+static inline bool
+make_set_file_template(LV2_Atom_Template* tmpl,
+                       LV2_Atom_Forge*    forge,
+                       const SamplerURIs* uris)
+{
+	LV2_Atom_Forge_Frame frame;
+	lv2_atom_template_begin(tmpl, forge);
+	lv2_atom_forge_object(forge, &frame, 0, uris->patch_Set);
+	lv2_atom_forge_key(forge, uris->patch_property);
+	lv2_atom_forge_urid(forge, uris->eg_sample);
+	lv2_atom_forge_key(forge, uris->patch_value);
+	lv2_atom_template_mark_tail(tmpl, forge);
+	lv2_atom_forge_path(forge, "", 0);
+	lv2_atom_forge_pop(forge, &frame);
+	lv2_atom_forge_set_buffer(forge, NULL, 0);
+
+	return lv2_atom_template_end(tmpl) != NULL;
+}
+
 /**
  * Get the file path from a message like:
  * []
@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include "lv2/lv2plug.in/ns/ext/atom/template.h"
 #include "lv2/lv2plug.in/ns/ext/log/log.h"
 #include "lv2/lv2plug.in/ns/ext/log/logger.h"
 #include "lv2/lv2plug.in/ns/ext/state/state.h"
@@ -50,6 +51,14 @@ typedef struct {
 	LV2_Log_Log*   log;
 	LV2_Log_Logger logger;
 
+	// Handlers for incoming messages
+	LV2_Atom_Dispatch dispatch;
+
+	// Pre-forged UI state message, and the offsets of its fields
+	LV2_Atom_Template state_tmpl;
+	uint32_t          spp_field;
+	uint32_t          amp_field;
+
 	// Instantiation settings
 	uint32_t n_channels;
 	double   rate;
@@ -71,6 +80,54 @@ typedef enum {
 	SCO_OUTPUT1 = 5,  // Audio input 2 (stereo variant)
 } PortIndex;
 
+/**
+   ==== Message Handlers ====
+
+   Each type of message from the UI is handled by a separate function.  These
+   are put in a dispatch table when the plugin is instantiated, so run() does
+   not need to compare the type of every incoming message against every type
+   the plugin understands.
+*/
+
+/** The UI was activated. */
+static void
+on_ui_on(void* handle, const LV2_Atom_Event* ev)
+{
+	EgScope* self = (EgScope*)handle;
+
+	self->ui_active           = true;
+	self->send_settings_to_ui = true;
+}
+
+/** The UI was closed. */
+static void
+on_ui_off(void* handle, const LV2_Atom_Event* ev)
+{
+	EgScope* self = (EgScope*)handle;
+
+	self->ui_active = false;
+}
+
+/** The current UI settings. */
+static void
+on_ui_state(void* handle, const LV2_Atom_Event* ev)
+{
+	EgScope*               self = (EgScope*)handle;
+	const LV2_Atom_Object* obj  = (const LV2_Atom_Object*)&ev->body;
+
+	const LV2_Atom* spp = NULL;
+	const LV2_Atom* amp = NULL;
+	lv2_atom_object_get(obj, self->uris.ui_spp, &spp,
+	                    self->uris.ui_amp, &amp,
+	                    0);
+	if (spp && spp->type == self->uris.atom_Int) {
+		self->ui_spp = ((const LV2_Atom_Int*)spp)->body;
+	}
+	if (amp && amp->type == self->uris.atom_Float) {
+		self->ui_amp = ((const LV2_Atom_Float*)amp)->body;
+	}
+}
+
 /** ==== Instantiate Method ==== */
 static LV2_Handle
 instantiate(const LV2_Descriptor*     descriptor,
@@ -126,6 +183,41 @@ instantiate(const LV2_Descriptor*     descriptor,
 	lv2_atom_forge_init(&self->forge, self->map);
 	lv2_log_logger_init(&self->logger, self->map, self->log);
 
+	/* Build the message dispatch table.  The UI sends objects with the
+	   deprecated type atom:Blank, so that is registered as an alias. */
+	const ScoLV2URIs* uris = &self->uris;
+	lv2_atom_dispatch_init(
+		&self->dispatch, uris->atom_Object, uris->atom_Blank, 0);
+	lv2_atom_dispatch_add(
+		&self->dispatch, uris->atom_Object, uris->ui_On, on_ui_on);
+	lv2_atom_dispatch_add(
+		&self->dispatch, uris->atom_Object, uris->ui_Off, on_ui_off);
+	lv2_atom_dispatch_add(
+		&self->dispatch, uris->atom_Object, uris->ui_State, on_ui_state);
+
+	/* Forge the UI state message once, as a template which is copied and
+	   patched with the current settings whenever it is sent.  The sample rate
+	   never changes, so it is simply part of the template. */
+	LV2_Atom_Forge* const forge = &self->forge;
+	LV2_Atom_Forge_Frame  frame;
+	lv2_atom_template_begin(&self->state_tmpl, forge);
+	lv2_atom_forge_object(forge, &frame, 0, uris->ui_State);
+	lv2_atom_forge_key(forge, uris->ui_spp);
+	self->spp_field = lv2_atom_template_field(
+		&self->state_tmpl, lv2_atom_forge_int(forge, 0));
+	lv2_atom_forge_key(forge, uris->ui_amp);
+	self->amp_field = lv2_atom_template_field(
+		&self->state_tmpl, lv2_atom_forge_float(forge, 0.0f));
+	lv2_atom_forge_key(forge, uris->param_sampleRate);
+	lv2_atom_forge_float(forge, (float)rate);
+	lv2_atom_forge_pop(forge, &frame);
+	lv2_atom_forge_set_buffer(forge, NULL, 0);
+	if (!lv2_atom_template_end(&self->state_tmpl)) {
+		lv2_atom_template_free(&self->state_tmpl);
+		free(self);
+		return NULL;
+	}
+
 	return (LV2_Handle)self;
 }
 
@@ -175,31 +267,68 @@ connect_port(LV2_Handle handle,
    where the value of the `sco:audioData` property, `[ 0.0, 0.0, ... ]`, is a
    http://lv2plug.in/ns/ext/atom#Vector[Vector] of
    http://lv2plug.in/ns/ext/atom#Float[Float].
+
+   The notify port may not have room for the whole message, so a checkpoint is
+   taken first.  If any write fails, the forge is rolled back to the checkpoint
+   so the message is dropped entirely, rather than leaving a truncated object
+   in the output.
+
+   Returns true if the message was written.
 */
-static void
+static bool
 tx_rawaudio(LV2_Atom_Forge* forge,
             ScoLV2URIs*     uris,
             const int32_t   channel,
             const size_t    n_samples,
             const float*    data)
 {
-	LV2_Atom_Forge_Frame frame;
+	const LV2_Atom_Forge_Checkpoint checkpoint = lv2_atom_forge_checkpoint(forge);
+	LV2_Atom_Forge_Frame            frame;
 
 	// Forge container object of type 'RawAudio'
-	lv2_atom_forge_frame_time(forge, 0);
-	lv2_atom_forge_object(forge, &frame, 0, uris->RawAudio);
+	if (lv2_atom_forge_frame_time(forge, 0) &&
+	    lv2_atom_forge_object(forge, &frame, 0, uris->RawAudio) &&
+	    // Add integer 'channelID' property
+	    lv2_atom_forge_key(forge, uris->channelID) &&
+	    lv2_atom_forge_int(forge, channel) &&
+	    // Add vector of floats 'audioData' property
+	    lv2_atom_forge_key(forge, uris->audioData) &&
+	    lv2_atom_forge_vector(
+		    forge, sizeof(float), uris->atom_Float, n_samples, data)) {
+		// Close off object
+		lv2_atom_forge_pop(forge, &frame);
+		return true;
+	}
 
-	// Add integer 'channelID' property
-	lv2_atom_forge_key(forge, uris->channelID);
-	lv2_atom_forge_int(forge, channel);
+	// Out of space, remove the partial message
+	lv2_atom_forge_rollback(forge, &checkpoint);
+	return false;
+}
 
-	// Add vector of floats 'audioData' property
-	lv2_atom_forge_key(forge, uris->audioData);
-	lv2_atom_forge_vector(
-		forge, sizeof(float), uris->atom_Float, n_samples, data);
+/**
+   ==== Utility Function: `tx_state` ====
 
-	// Close off object
-	lv2_atom_forge_pop(forge, &frame);
+   This function sends a message with the UI state, by writing a copy of the
+   template made in `instantiate` and setting its fields to the current
+   settings.  As in `tx_rawaudio`, the forge is rolled back if the message
+   does not fit.
+*/
+static bool
+tx_state(EgScope* self)
+{
+	LV2_Atom_Forge* const           forge      = &self->forge;
+	const LV2_Atom_Forge_Checkpoint checkpoint = lv2_atom_forge_checkpoint(forge);
+	LV2_Atom*                       msg        = NULL;
+
+	if (lv2_atom_forge_frame_time(forge, 0) &&
+	    (msg = lv2_atom_template_write(&self->state_tmpl, forge))) {
+		lv2_atom_template_set_int(msg, self->spp_field, (int32_t)self->ui_spp);
+		lv2_atom_template_set_float(msg, self->amp_field, self->ui_amp);
+		return true;
+	}
+
+	lv2_atom_forge_rollback(forge, &checkpoint);
+	return false;
 }
 
 /** ==== Run Method ==== */
@@ -208,91 +337,49 @@ run(LV2_Handle handle, uint32_t n_samples)
 {
 	EgScope* self = (EgScope*)handle;
 
-	/* Ensure notify port buffer is large enough to hold all audio-samples and
-	   configuration settings.  A minimum size was requested in the .ttl file,
-	   but check here just to be sure.
+	/* Prepare forge buffer and initialize atom-sequence
 
-	   TODO: Explain these magic numbers.
+	   A minimum size for the notify buffer was requested in the .ttl file, but
+	   there is no need to check it here: every message is written with a
+	   checkpoint, so the buffer is filled up to its capacity, and any message
+	   which does not fit is dropped.
 	*/
-	const size_t   size  = (sizeof(float) * n_samples + 64) * self->n_channels;
 	const uint32_t space = self->notify->atom.size;
-	if (space < size + 128) {
-		/* Insufficient space, report error and do nothing.  Note that a
-		   real-time production plugin mustn't call log functions in run(), but
-		   this can be useful for debugging and example purposes.
-		*/
-		lv2_log_error(&self->logger, "Buffer size is insufficient\n");
-		return;
-	}
-
-	// Prepare forge buffer and initialize atom-sequence
 	lv2_atom_forge_set_buffer(&self->forge, (uint8_t*)self->notify, space);
-	lv2_atom_forge_sequence_head(&self->forge, &self->frame, 0);
+	const bool notify = lv2_atom_forge_sequence_head(
+		&self->forge, &self->frame, 0);
 
 	/* Send settings to UI
 
 	   The plugin can continue to run while the UI is closed and re-opened.
 	   The state and settings of the UI are kept here and transmitted to the UI
 	   every time it asks for them or if the user initializes a 'load preset'.
+	   If there is no room, they are sent in the next cycle.
 	*/
-	if (self->send_settings_to_ui && self->ui_active) {
-		self->send_settings_to_ui = false;
-		// Forge container object of type 'ui_state'
-		LV2_Atom_Forge_Frame frame;
-		lv2_atom_forge_frame_time(&self->forge, 0);
-		lv2_atom_forge_object(&self->forge, &frame, 0, self->uris.ui_State);
-
-		// Add UI state as properties
-		lv2_atom_forge_key(&self->forge, self->uris.ui_spp);
-		lv2_atom_forge_int(&self->forge, self->ui_spp);
-		lv2_atom_forge_key(&self->forge, self->uris.ui_amp);
-		lv2_atom_forge_float(&self->forge, self->ui_amp);
-		lv2_atom_forge_key(&self->forge, self->uris.param_sampleRate);
-		lv2_atom_forge_float(&self->forge, self->rate);
-		lv2_atom_forge_pop(&self->forge, &frame);
+	if (notify && self->send_settings_to_ui && self->ui_active) {
+		self->send_settings_to_ui = !tx_state(self);
 	}
 
-	// Process incoming events from GUI
-	if (self->control) {
-		const LV2_Atom_Event* ev = lv2_atom_sequence_begin(
-			&(self->control)->body);
-		// For each incoming message...
-		while (!lv2_atom_sequence_is_end(
-			       &self->control->body, self->control->atom.size, ev)) {
-			// If the event is an atom:Blank object
-			if (ev->body.type == self->uris.atom_Blank) {
-				const LV2_Atom_Object* obj = (const LV2_Atom_Object*)&ev->body;
-				if (obj->body.otype == self->uris.ui_On) {
-					// If the object is a ui-on, the UI was activated
-					self->ui_active           = true;
-					self->send_settings_to_ui = true;
-				} else if (obj->body.otype == self->uris.ui_Off) {
-					// If the object is a ui-off, the UI was closed
-					self->ui_active = false;
-				} else if (obj->body.otype == self->uris.ui_State) {
-					// If the object is a ui-state, it's the current UI settings
-					const LV2_Atom* spp = NULL;
-					const LV2_Atom* amp = NULL;
-					lv2_atom_object_get(obj, self->uris.ui_spp, &spp,
-					                    self->uris.ui_amp, &amp,
-					                    0);
-					if (spp) {
-						self->ui_spp = ((const LV2_Atom_Int*)spp)->body;
-					}
-					if (amp) {
-						self->ui_amp = ((const LV2_Atom_Float*)amp)->body;
-					}
-				}
-			}
-			ev = lv2_atom_sequence_next(ev);
-		}
+	/* Process incoming events from GUI
+
+	   Messages from the UI are checked first, so the handlers can safely
+	   access their contents without checking bounds everywhere.
+	*/
+	if (self->control &&
+	    lv2_atom_sequence_validate(&self->forge,
+	                               self->control,
+	                               lv2_atom_total_size(&self->control->atom))) {
+		lv2_atom_dispatch_sequence(&self->dispatch, self, self->control);
 	}
 
 	// Process audio data
+	bool send_audio = notify && self->ui_active;
 	for (uint32_t c = 0; c < self->n_channels; ++c) {
-		if (self->ui_active) {
-			// If UI is active, send raw audio data to UI
-			tx_rawaudio(&self->forge, &self->uris, c, n_samples, self->input[c]);
+		if (send_audio) {
+			/* If UI is active, send raw audio data to UI.  If the buffer is
+			   full, later channels would not fit either, so stop sending. */
+			send_audio = tx_rawaudio(
+				&self->forge, &self->uris, c, n_samples, self->input[c]);
 		}
 		// If not processing audio in-place, forward audio
 		if (self->input[c] != self->output[c]) {
@@ -307,7 +394,9 @@ run(LV2_Handle handle, uint32_t n_samples)
 static void
 cleanup(LV2_Handle handle)
 {
-	free(handle);
+	EgScope* self = (EgScope*)handle;
+	lv2_atom_template_free(&self->state_tmpl);
+	free(self);
 }
 
 
@@ -0,0 +1,426 @@
+/*
+  Copyright 2026 David Robillard <http://drobilla.net>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THIS SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+/*
+  Benchmark loading and instantiating plugins, as a host does for a session.
+
+  Usage: instantiate-bench [OPTION]... [PATH]...
+
+  Every plugin library under each PATH (by default, build/plugins, so this
+  should be run from the top of the source tree) is loaded, and every plugin
+  in it is instantiated and cleaned up many times.  The time taken for each
+  phase is reported, along with how many times the plugin called each host
+  feature, and how long was spent in those calls, so the rest of the time is
+  the plugin's own code, like loading files or generating tables.
+
+  The URID map is shared by every plugin, as in a real session, so only the
+  first instance of a plugin maps new URIs, and only if no plugin before it
+  has mapped them.  With -c, every instance is a cold start: the library is
+  loaded again with a new URID map each time, and page caches are dropped
+  first if permitted (usually only for root).
+*/
+
+#define _XOPEN_SOURCE 500
+
+#include <dlfcn.h>
+#include <ftw.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lv2/lv2plug.in/ns/ext/log/log.h"
+#include "lv2/lv2plug.in/ns/ext/urid/table.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+#include "lv2/lv2plug.in/ns/ext/worker/worker.h"
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+
+/** Number of times a phase was run, and the total time it took. */
+typedef struct {
+	unsigned n;
+	double   time;
+} Counter;
+
+/** Host state, which features are implemented with. */
+typedef struct {
+	LV2_URID_Table table;      /**< URID map shared by all plugins */
+	Counter        map;        /**< Calls to urid:map */
+	Counter        map_batch;  /**< Calls to urid:mapBatch */
+	unsigned       n_batched;  /**< URIs mapped with urid:mapBatch */
+	Counter        unmap;      /**< Calls to urid:unmap */
+	Counter        log;        /**< Calls to log:log */
+	Counter        schedule;   /**< Calls to worker:schedule */
+	bool           verbose;    /**< Print log messages */
+} Host;
+
+/** Command line options. */
+typedef struct {
+	unsigned n_instances;  /**< Number of times to instantiate each plugin */
+	double   rate;         /**< Sample rate */
+	bool     cold;         /**< Load everything again for every instance */
+	bool     batch;        /**< Provide urid:mapBatch */
+} Options;
+
+/** Paths of plugin libraries found in the paths given on the command line. */
+static char**   libs   = NULL;
+static unsigned n_libs = 0;
+
+static double
+bench_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static void
+count(Counter* counter, double begin)
+{
+	++counter->n;
+	counter->time += bench_time() - begin;
+}
+
+static LV2_URID
+map_uri(LV2_URID_Map_Handle handle, const char* uri)
+{
+	Host* const    host  = (Host*)handle;
+	const double   begin = bench_time();
+	const LV2_URID urid  = lv2_urid_table_map(&host->table, uri);
+	count(&host->map, begin);
+	return urid;
+}
+
+static uint32_t
+map_batch(LV2_URID_Map_Batch_Handle handle,
+          uint32_t                  n_uris,
+          const char* const*        uris,
+          LV2_URID*                 urids)
+{
+	Host* const    host  = (Host*)handle;
+	const double   begin = bench_time();
+	const uint32_t n     = lv2_urid_table_map_batch(
+		&host->table, n_uris, uris, urids);
+	count(&host->map_batch, begin);
+	host->n_batched += n_uris;
+	return n;
+}
+
+static const char*
+unmap_urid(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	Host* const       host  = (Host*)handle;
+	const double      begin = bench_time();
+	const char* const uri   = lv2_urid_table_unmap(&host->table, urid);
+	count(&host->unmap, begin);
+	return uri;
+}
+
+static int
+log_vprintf(LV2_Log_Handle handle,
+            LV2_URID       type,
+            const char*    fmt,
+            va_list        ap)
+{
+	Host* const  host  = (Host*)handle;
+	const double begin = bench_time();
+	const int    ret   = host->verbose ? vfprintf(stderr, fmt, ap) : 0;
+	count(&host->log, begin);
+	return ret;
+}
+
+static int
+log_printf(LV2_Log_Handle handle, LV2_URID type, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int ret = log_vprintf(handle, type, fmt, args);
+	va_end(args);
+	return ret;
+}
+
+static LV2_Worker_Status
+schedule_work(LV2_Worker_Schedule_Handle handle,
+              uint32_t                   size,
+              const void*                data)
+{
+	/* There is no worker here, so refuse work, which plugins must handle */
+	Host* const host = (Host*)handle;
+	count(&host->schedule, bench_time());
+	return LV2_WORKER_ERR_NO_SPACE;
+}
+
+/** Drop page caches, so files must be read from disk again. */
+static bool
+drop_caches(void)
+{
+	sync();
+	FILE* const fd = fopen("/proc/sys/vm/drop_caches", "w");
+	if (!fd) {
+		return false;
+	}
+
+	const bool success = fputs("3\n", fd) >= 0;
+	return !fclose(fd) && success;
+}
+
+static void
+report(const char* name, const Counter* counter)
+{
+	printf("  %-22s %8u %12.3f us %12.3f ms\n",
+	       name,
+	       counter->n,
+	       counter->n ? counter->time * 1.0e6 / counter->n : 0.0,
+	       counter->time * 1.0e3);
+}
+
+/** Return the descriptor function of a plugin library. */
+static LV2_Descriptor_Function
+descriptor_function(void* lib)
+{
+	// Casting from void* to a function pointer is only allowed via a union
+	union {
+		void*                   ptr;
+		LV2_Descriptor_Function func;
+	} df;
+
+	df.ptr = dlsym(lib, "lv2_descriptor");
+	return df.func;
+}
+
+/** Benchmark the `index`th plugin in the library at `path`. */
+static bool
+bench_plugin(const Options* opts,
+             Host*          host,
+             const char*    path,
+             uint32_t       index)
+{
+	// Get the bundle path, which is passed to instantiate()
+	const size_t bundle_len = (size_t)(strrchr(path, '/') - path + 1);
+	char* const  bundle     = (char*)calloc(1, bundle_len + 1);
+	memcpy(bundle, path, bundle_len);
+
+	// Reset feature counters, but keep the URID map from previous plugins
+	const Counter zero = { 0, 0.0 };
+	host->map = host->map_batch = host->unmap = zero;
+	host->log = host->schedule = zero;
+	host->n_batched = 0;
+
+	LV2_URID_Map        map      = { host, map_uri };
+	LV2_URID_Map_Batch  batch    = { host, map_batch };
+	LV2_URID_Unmap      unmap    = { host, unmap_urid };
+	LV2_Log_Log         log      = { host, log_printf, log_vprintf };
+	LV2_Worker_Schedule schedule = { host, schedule_work };
+
+	const LV2_Feature map_feature      = { LV2_URID__map, &map };
+	const LV2_Feature batch_feature    = { LV2_URID__mapBatch, &batch };
+	const LV2_Feature unmap_feature    = { LV2_URID__unmap, &unmap };
+	const LV2_Feature log_feature      = { LV2_LOG__log, &log };
+	const LV2_Feature schedule_feature = { LV2_WORKER__schedule, &schedule };
+
+	const LV2_Feature* features[] = { &map_feature,
+	                                  &unmap_feature,
+	                                  &log_feature,
+	                                  &schedule_feature,
+	                                  opts->batch ? &batch_feature : NULL,
+	                                  NULL };
+
+	Counter  open        = { 0, 0.0 };
+	Counter  discover    = { 0, 0.0 };
+	Counter  instantiate = { 0, 0.0 };
+	Counter  cleanup     = { 0, 0.0 };
+	void*    lib         = NULL;
+	unsigned n_failed    = 0;
+	bool     cold_warned = false;
+
+	const LV2_Descriptor* desc = NULL;
+	for (unsigned i = 0; i < opts->n_instances; ++i) {
+		if (opts->cold || !lib) {
+			// Start from scratch, like a host that was just launched
+			if (lib) {
+				dlclose(lib);
+			}
+			if (opts->cold) {
+				lv2_urid_table_free(&host->table);
+				if (!lv2_urid_table_init(&host->table)) {
+					// The table is unusable, and can not even be freed
+					fprintf(stderr, "error: Failed to allocate URID map\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+			if (opts->cold && !drop_caches() && !cold_warned) {
+				fprintf(stderr, "warning: Failed to drop page caches\n");
+				cold_warned = true;
+			}
+
+			double begin = bench_time();
+			if (!(lib = dlopen(path, RTLD_NOW | RTLD_LOCAL))) {
+				fprintf(stderr, "error: %s\n", dlerror());
+				break;
+			}
+			count(&open, begin);
+
+			begin = bench_time();
+			const LV2_Descriptor_Function df = descriptor_function(lib);
+			if (!df || !(desc = df(index))) {
+				break;
+			}
+			count(&discover, begin);
+		}
+
+		const double begin  = bench_time();
+		LV2_Handle   handle = desc->instantiate(
+			desc, opts->rate, bundle, features);
+		count(&instantiate, begin);
+		if (!handle) {
+			++n_failed;
+			continue;
+		}
+
+		const double cleanup_begin = bench_time();
+		desc->cleanup(handle);
+		count(&cleanup, cleanup_begin);
+	}
+
+	if (desc) {
+		// Time in features is part of instantiate and cleanup, subtract it
+		Counter plugin = instantiate;
+		plugin.time += cleanup.time - host->map.time - host->map_batch.time -
+			host->unmap.time - host->log.time - host->schedule.time;
+
+		printf("%s (%s)\n", desc->URI, path);
+		printf("  %-22s %8s %15s %15s\n", "Phase", "Calls", "Mean", "Total");
+		report("dlopen", &open);
+		report("lv2_descriptor", &discover);
+		report("instantiate", &instantiate);
+		report("cleanup", &cleanup);
+		report("urid:map", &host->map);
+		report("urid:mapBatch", &host->map_batch);
+		report("urid:unmap", &host->unmap);
+		report("log:log", &host->log);
+		report("worker:schedule", &host->schedule);
+		report("plugin code", &plugin);
+		if (host->n_batched) {
+			printf("  %u URIs mapped in batches\n", host->n_batched);
+		}
+		if (n_failed) {
+			printf("  %u instances failed\n", n_failed);
+		}
+		printf("\n");
+	}
+
+	if (lib) {
+		dlclose(lib);
+	}
+	free(bundle);
+	return desc != NULL;
+}
+
+/** Benchmark every plugin in the library at `path`. */
+static void
+bench_library(const Options* opts, Host* host, const char* path)
+{
+	for (uint32_t i = 0; bench_plugin(opts, host, path, i); ++i) {}
+}
+
+static int
+find_lib(const char* path, const struct stat* sb, int type, struct FTW* ftw)
+{
+	const size_t len = strlen(path);
+	if (type == FTW_F && len > 3 && !strcmp(path + len - 3, ".so")) {
+		libs = (char**)realloc(libs, ++n_libs * sizeof(char*));
+		libs[n_libs - 1] = (char*)malloc(len + 1);
+		memcpy(libs[n_libs - 1], path, len + 1);
+	}
+	return 0;
+}
+
+static int
+compare_paths(const void* a, const void* b)
+{
+	return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static int
+print_usage(const char* name, bool error)
+{
+	FILE* const os = error ? stderr : stdout;
+	fprintf(os, "Usage: %s [OPTION]... [PATH]...\n", name);
+	fprintf(os, "Benchmark instantiating every plugin in PATH.\n\n");
+	fprintf(os, "  -b    Provide the urid:mapBatch feature\n");
+	fprintf(os, "  -c    Cold start every instance\n");
+	fprintf(os, "  -h    Display this help and exit\n");
+	fprintf(os, "  -n N  Instantiate each plugin N times (default: 100)\n");
+	fprintf(os, "  -r R  Use sample rate R (default: 48000)\n");
+	fprintf(os, "  -v    Print messages logged by plugins\n");
+	return error ? 1 : 0;
+}
+
+int
+main(int argc, char** argv)
+{
+	Options opts    = { 100, 48000.0, false, false };
+	bool    verbose = false;
+
+	int a = 1;
+	for (; a < argc && argv[a][0] == '-'; ++a) {
+		if (argv[a][1] == 'b') {
+			opts.batch = true;
+		} else if (argv[a][1] == 'c') {
+			opts.cold = true;
+		} else if (argv[a][1] == 'h') {
+			return print_usage(argv[0], false);
+		} else if (argv[a][1] == 'n' && a + 1 < argc) {
+			opts.n_instances = (unsigned)strtoul(argv[++a], NULL, 10);
+		} else if (argv[a][1] == 'r' && a + 1 < argc) {
+			opts.rate = strtod(argv[++a], NULL);
+		} else if (argv[a][1] == 'v') {
+			verbose = true;
+		} else {
+			return print_usage(argv[0], true);
+		}
+	}
+
+	if (a == argc) {
+		nftw("build/plugins", find_lib, 16, FTW_PHYS);
+	}
+	for (; a < argc; ++a) {
+		nftw(argv[a], find_lib, 16, FTW_PHYS);
+	}
+	if (!n_libs) {
+		fprintf(stderr, "No plugin libraries found\n");
+		return 1;
+	}
+
+	Host host;
+	memset(&host, 0, sizeof(host));
+	if (!lv2_urid_table_init(&host.table)) {
+		fprintf(stderr, "Failed to allocate URID map\n");
+		return 1;
+	}
+	host.verbose = verbose;
+
+	qsort(libs, n_libs, sizeof(char*), compare_paths);
+	for (unsigned i = 0; i < n_libs; ++i) {
+		bench_library(&opts, &host, libs[i]);
+		free(libs[i]);
+	}
+
+	lv2_urid_table_free(&host.table);
+	free(libs);
+	return 0;
+}